@@ -23,6 +23,7 @@
 #define MSGID_NYX_MOD_GET_STRTOD_ERR                                        "NYXUTIL_GET_STRTOD_ERR"
 #define MSGID_NYX_MOD_SYSFS_ERR                                             "NYXUTIL_SYSFS_ERR"
 #define MSGID_NYX_MOD_GET_DIR_ERR                                           "NYXUTIL_GET_DIR_ERR"
+#define MSGID_NYX_MOD_COALESCE_ENV_ERR                                      "NYXUTIL_COALESCE_ENV_ERR"
 
 /** Battery*/
 #define MSGID_NYX_MOD_UDEV_ERR                                              "NYXBAT_UDEV_ERR"
@@ -32,6 +33,8 @@
 #define MSGID_NYX_MOD_BATT_OPEN_ALREADY_ERR                                 "NYXBAT_OPEN_ALREADY_ERR"
 #define MSGID_NYX_MOD_BATT_OPEN_ERR                                         "NYXBAT_OPEN_ERR"
 #define MSGID_NYX_MOD_BATT_OUT_OF_MEMORY                                    "NYXBAT_OUT_OF_MEM"
+#define MSGID_NYX_MOD_BATT_HISTORY_ERR                                      "NYXBAT_HISTORY_ERR"
+#define MSGID_NYX_MOD_BATT_SIMULATOR_ERR                                    "NYXBAT_SIMULATOR_ERR"
 
 /** Charger*/
 #define MSGID_NYX_MOD_CHARG_ERR                                             "NYXCHG_ERR"
@@ -35,17 +35,18 @@
 #include "msgid.h"
 
 #include <glib.h>
-#include <libudev.h>
 
 #include "battery.h"
 #include "utils.h"
-
-#define CHARGE_MIN_TEMPERATURE_C 0
-#define CHARGE_MAX_TEMPERATURE_C 57
-#define BATTERY_MAX_TEMPERATURE_C  60
+#include "power_supply_monitor.h"
 
 #define PATH_LEN 256
 
+/* time constant of the average current, and the smallest average current
+ * (in uA) that still gives a time-to-empty/full */
+#define BATTERY_CURRENT_EWMA_TAU_S 60
+#define BATTERY_ESTIMATE_MIN_CURRENT 1000
+
 char *battery_sysfs_path = NULL;
 
 nyx_battery_ctia_t battery_ctia_params;
@@ -53,31 +54,151 @@ nyx_battery_ctia_t battery_ctia_params;
 int current_battery_percentage;
 bool current_battery_present;
 
-struct udev *udev = NULL;
-struct udev_monitor *mon = NULL;
-guint watch = 0;
+static bool listening = false;
+static guint sample_timer = 0;
 
 extern nyx_device_t *nyxDev;
 extern void *battery_callback_context;
 extern nyx_device_callback_function_t battery_callback;
 
-char batt_capacity_path[PATH_LEN] = {0,};
-char batt_energy_now_path[PATH_LEN] = {0,};
-char batt_energy_full_path[PATH_LEN] = {0,};
-char batt_energy_full_design_path[PATH_LEN] = {0,};
-char batt_charge_now_path[PATH_LEN] = {0,};
-char batt_charge_full_path[PATH_LEN] = {0,};
-char batt_charge_full_design_path[PATH_LEN] = {0,};
-char batt_temperature_path[PATH_LEN] = {0,};
-char batt_voltage_path[PATH_LEN] = {0,};
-char batt_current_path[PATH_LEN] = {0,};
-char batt_present_path[PATH_LEN] = {0,};
+sysfs_attr_t batt_capacity = SYSFS_ATTR_INIT;
+sysfs_attr_t batt_energy_now = SYSFS_ATTR_INIT;
+sysfs_attr_t batt_energy_full = SYSFS_ATTR_INIT;
+sysfs_attr_t batt_charge_now = SYSFS_ATTR_INIT;
+sysfs_attr_t batt_charge_full = SYSFS_ATTR_INIT;
+sysfs_attr_t batt_charge_full_design = SYSFS_ATTR_INIT;
+sysfs_attr_t batt_charge_counter = SYSFS_ATTR_INIT;
+sysfs_attr_t batt_temperature = SYSFS_ATTR_INIT;
+sysfs_attr_t batt_voltage = SYSFS_ATTR_INIT;
+sysfs_attr_t batt_current = SYSFS_ATTR_INIT;
+sysfs_attr_t batt_present = SYSFS_ATTR_INIT;
+sysfs_attr_t batt_status = SYSFS_ATTR_INIT;
 char batt_fake_battery_path[PATH_LEN] = {0,};
 
+static sysfs_attr_t *battery_attrs[] =
+{
+	&batt_capacity, &batt_energy_now, &batt_energy_full, &batt_charge_now,
+	&batt_charge_full, &batt_charge_full_design, &batt_charge_counter,
+	&batt_temperature, &batt_voltage, &batt_current, &batt_present, &batt_status,
+};
+
+static power_supply_uevent_t battery_snapshot;
+static bool battery_snapshot_valid = false;
+
+/* the latest battery uevent, evaluated once its burst is over */
+static power_supply_uevent_t battery_event;
+static bool battery_event_valid = false;
+static event_coalescer_t battery_events;
+
+/* exponentially weighted average of the current, updated on every sample */
+static double current_ewma = 0;
+static gint64 current_ewma_time = 0;    /* monotonic us, 0 while unset */
+static bool current_ewma_charging = false;
+
+/**
+ * @brief Read all battery values at once from the uevent attribute; until
+ * battery_snapshot_end() the battery_* readers use it and only go to their
+ * own sysfs file for values the uevent did not carry.
+ */
+void battery_snapshot_begin(void)
+{
+	const power_supply_uevent_t *simulated = battery_simulator_state();
+
+	if (simulated)
+	{
+		battery_snapshot = *simulated;
+		battery_snapshot_valid = true;
+		return;
+	}
+
+	battery_snapshot_valid = battery_sysfs_path &&
+	                         power_supply_read_uevent(battery_sysfs_path, &battery_snapshot) == 0;
+}
+
+void battery_snapshot_end(void)
+{
+	battery_snapshot_valid = false;
+}
+
+static int32_t battery_read_value(power_supply_key_t key, sysfs_attr_t *attr)
+{
+	int32_t value;
+
+	if (battery_snapshot_valid && power_supply_uevent_get(&battery_snapshot, key, &value))
+	{
+		return value;
+	}
+
+	if (sysfs_attr_read_int(attr, &value) < 0)
+	{
+		return -1;
+	}
+
+	return value;
+}
+
+static bool battery_has_value(power_supply_key_t key, sysfs_attr_t *attr)
+{
+	if (battery_snapshot_valid && power_supply_uevent_get(&battery_snapshot, key, NULL))
+	{
+		return true;
+	}
+
+	return sysfs_attr_exists(attr);
+}
+
+/* Like battery_read_value() for values that may be negative */
+static bool battery_read_signed(power_supply_key_t key, sysfs_attr_t *attr,
+                                int32_t *value)
+{
+	if (battery_snapshot_valid && power_supply_uevent_get(&battery_snapshot, key, value))
+	{
+		return true;
+	}
+
+	return sysfs_attr_read_int(attr, value) == 0;
+}
+
+/**
+ * @brief Whether the battery charges; POWER_SUPPLY_STATUS decides when it is
+ * known, otherwise a positive current means charging
+ */
+static bool battery_is_charging(int32_t current, bool *full)
+{
+	char status[POWER_SUPPLY_STATUS_LEN] = "";
+
+	if (battery_snapshot_valid && battery_snapshot.status[0])
+	{
+		g_strlcpy(status, battery_snapshot.status, sizeof(status));
+	}
+	else
+	{
+		sysfs_attr_read(&batt_status, status, sizeof(status));
+	}
+
+	if (full)
+	{
+		*full = (strcmp(status, "Full") == 0);
+	}
+
+	if (strcmp(status, "Charging") == 0)
+	{
+		return true;
+	}
+
+	if (strcmp(status, "Discharging") == 0 || strcmp(status, "Not charging") == 0 ||
+	        strcmp(status, "Full") == 0)
+	{
+		return false;
+	}
+
+	return current > 0;
+}
+
 nyx_battery_ctia_t *get_battery_ctia_params(void)
 {
-	battery_ctia_params.charge_min_temp_c = CHARGE_MIN_TEMPERATURE_C;
-	battery_ctia_params.charge_max_temp_c = CHARGE_MAX_TEMPERATURE_C;
+	battery_ctia_params.charge_min_temp_c = BATTERY_CHARGE_MIN_TEMPERATURE_C;
+	battery_ctia_params.charge_max_temp_c = BATTERY_CHARGE_MAX_TEMPERATURE_C;
 	battery_ctia_params.battery_crit_max_temp = BATTERY_MAX_TEMPERATURE_C;
 	battery_ctia_params.skip_battery_authentication = true;
 
@@ -97,17 +218,17 @@ int battery_percent(void)
 	// TODO: Might first confirm that battery is present?
 
 	/* try capacity node first but keep in mind it's not supported by all power class devices */
-	if ((capacity = nyx_utils_read_value(batt_capacity_path)) < 0)
+	if ((capacity = battery_read_value(POWER_SUPPLY_CAPACITY, &batt_capacity)) < 0)
 	{
 		/* capacity node is not available so next try is energy_full path */
-		if (g_file_test(batt_energy_full_path, G_FILE_TEST_EXISTS))
+		if (battery_has_value(POWER_SUPPLY_ENERGY_FULL, &batt_energy_full))
 		{
-			if ((now = nyx_utils_read_value(batt_energy_now_path)) < 0)
+			if ((now = battery_read_value(POWER_SUPPLY_ENERGY_NOW, &batt_energy_now)) < 0)
 			{
 				return -1;
 			}
 
-			if ((full = nyx_utils_read_value(batt_energy_full_path)) < 0)
+			if ((full = battery_read_value(POWER_SUPPLY_ENERGY_FULL, &batt_energy_full)) < 0)
 			{
 				return -1;
 			}
@@ -115,14 +236,14 @@ int battery_percent(void)
 			capacity = (100 * now / full);
 		}
 		/* as last try we can use charge_now path */
-		else if (g_file_test(batt_charge_now_path, G_FILE_TEST_EXISTS))
+		else if (battery_has_value(POWER_SUPPLY_CHARGE_NOW, &batt_charge_now))
 		{
-			if ((full = nyx_utils_read_value(batt_charge_full_path)) < 0)
+			if ((full = battery_read_value(POWER_SUPPLY_CHARGE_FULL, &batt_charge_full)) < 0)
 			{
 				return -1;
 			}
 
-			if ((now = nyx_utils_read_value(batt_charge_now_path)) < 0)
+			if ((now = battery_read_value(POWER_SUPPLY_CHARGE_NOW, &batt_charge_now)) < 0)
 			{
 				return -1;
 			}
@@ -147,7 +268,7 @@ int battery_temperature(void)
 {
 	int temp;
 
-	if ((temp = nyx_utils_read_value(batt_temperature_path)) < 0)
+	if ((temp = battery_read_value(POWER_SUPPLY_TEMP, &batt_temperature)) < 0)
 	{
 		return -1;
 	}
@@ -165,7 +286,7 @@ int battery_voltage(void)
 {
 	int voltage;
 
-	if ((voltage = nyx_utils_read_value(batt_voltage_path)) < 0)
+	if ((voltage = battery_read_value(POWER_SUPPLY_VOLTAGE_NOW, &batt_voltage)) < 0)
 	{
 		return -1;
 	}
@@ -174,15 +295,16 @@ int battery_voltage(void)
 }
 
 /**
- * @brief Read the amount of current being drawn by the battery (negative = charging!)
+ * @brief Read the current through the battery in uA: positive while it
+ * charges, negative while it discharges
  *
  * @retval Current (integer)
  */
 int battery_current(void)
 {
-	signed int current;
+	int32_t current;
 
-	if ((current = nyx_utils_read_value(batt_current_path)) < 0)
+	if (!battery_read_signed(POWER_SUPPLY_CURRENT_NOW, &batt_current, &current))
 	{
 		return -1;
 	}
@@ -191,17 +313,127 @@ int battery_current(void)
 }
 
 /**
- * @brief Read average current being drawn by the battery.
+ * @brief Read average current being drawn by the battery: the exponentially
+ * weighted average of the samples, or the current itself before the first one
  *
  * @retval Current (integer)
  */
 
 int battery_avg_current(void)
 {
-	// return battery_current for this device unless we have a way to separately read "average" current
+	if (current_ewma_time)
+	{
+		return (int) current_ewma;
+	}
+
 	return battery_current();
 }
 
+/**
+ * @brief Fold the current of the snapshot into the average; called on every
+ * sample between battery_snapshot_begin() and battery_snapshot_end()
+ *
+ * The weight of a sample grows with the time since the previous one,
+ * dt / (dt + BATTERY_CURRENT_EWMA_TAU_S), so irregular uevents do not skew
+ * the average. It restarts when the battery starts or stops charging.
+ */
+static void battery_estimate_update(void)
+{
+	gint64 now = g_get_monotonic_time();
+	int32_t current;
+	bool charging;
+	double dt, alpha;
+
+	if (!battery_is_present() ||
+	        !battery_read_signed(POWER_SUPPLY_CURRENT_NOW, &batt_current, &current))
+	{
+		current_ewma_time = 0;
+		return;
+	}
+
+	charging = battery_is_charging(current, NULL);
+
+	if (!current_ewma_time || charging != current_ewma_charging)
+	{
+		current_ewma = current;
+		current_ewma_charging = charging;
+		current_ewma_time = now;
+		return;
+	}
+
+	dt = (double)(now - current_ewma_time) / G_USEC_PER_SEC;
+	alpha = dt / (dt + BATTERY_CURRENT_EWMA_TAU_S);
+	current_ewma += alpha * (current - current_ewma);
+	current_ewma_time = now;
+}
+
+/**
+ * @brief Estimate the time to empty and to full from the average current and
+ * the remaining charge, or energy when the battery only reports that
+ */
+void battery_get_estimate(nyx_battery_estimate_t *estimate)
+{
+	int32_t now, full, voltage;
+	double current, remaining = -1, missing = -1;
+	bool is_full;
+
+	memset(estimate, 0, sizeof(nyx_battery_estimate_t));
+	estimate->time_to_empty = -1;
+	estimate->time_to_full = -1;
+
+	if (!battery_is_present())
+	{
+		return;
+	}
+
+	estimate->avg_current = battery_avg_current();
+	estimate->charging = battery_is_charging(estimate->avg_current, &is_full);
+
+	if (is_full)
+	{
+		estimate->time_to_full = 0;
+		return;
+	}
+
+	current = estimate->avg_current < 0 ? -estimate->avg_current : estimate->avg_current;
+
+	if (current < BATTERY_ESTIMATE_MIN_CURRENT)
+	{
+		return;
+	}
+
+	/* uAh over uA */
+	if (battery_read_signed(POWER_SUPPLY_CHARGE_NOW, &batt_charge_now, &now) &&
+	        battery_read_signed(POWER_SUPPLY_CHARGE_FULL, &batt_charge_full, &full) &&
+	        now >= 0 && full > 0)
+	{
+		remaining = now;
+		missing = MAX(full - now, 0);
+	}
+	/* uWh over uW */
+	else if (battery_read_signed(POWER_SUPPLY_ENERGY_NOW, &batt_energy_now, &now) &&
+	         battery_read_signed(POWER_SUPPLY_ENERGY_FULL, &batt_energy_full, &full) &&
+	         (voltage = battery_voltage()) > 0 && now >= 0 && full > 0)
+	{
+		current = current * voltage / 1000000;
+		remaining = now;
+		missing = MAX(full - now, 0);
+	}
+	else
+	{
+		return;
+	}
+
+	if (estimate->charging)
+	{
+		estimate->time_to_full = (int)(missing * 3600 / current);
+	}
+	else
+	{
+		estimate->time_to_empty = (int)(remaining * 3600 / current);
+	}
+}
+
 /**
  * @brief Read battery full capacity
  *
@@ -211,10 +443,11 @@ double battery_full40(void)
 {
 	int charge_full;
 
-	if (!g_file_test(batt_charge_full_path, G_FILE_TEST_EXISTS) ||
-	        ((charge_full = nyx_utils_read_value(batt_charge_full_path)) < 0))
+	if (!battery_has_value(POWER_SUPPLY_CHARGE_FULL, &batt_charge_full) ||
+	        ((charge_full = battery_read_value(POWER_SUPPLY_CHARGE_FULL, &batt_charge_full)) < 0))
 	{
-		if ((charge_full = nyx_utils_read_value(batt_charge_full_design_path)) < 0)
+		if ((charge_full = battery_read_value(POWER_SUPPLY_CHARGE_FULL_DESIGN,
+		                                      &batt_charge_full_design)) < 0)
 		{
 			return -1;
 		}
@@ -232,7 +465,16 @@ double battery_full40(void)
 
 double battery_rawcoulomb(void)
 {
-	return -1;
+	int32_t counter;
+
+	/* the coulomb counter as the gauge reports it, before any correction */
+	if (!battery_read_signed(POWER_SUPPLY_CHARGE_COUNTER, &batt_charge_counter, &counter))
+	{
+		return battery_coulomb();
+	}
+
+	/* Divide the value by 1000 to convert from uAh to mAh */
+	return (double) counter / 1000;
 }
 
 /**
@@ -245,7 +487,7 @@ double battery_coulomb(void)
 {
 	int charge_now;
 
-	if ((charge_now = nyx_utils_read_value(batt_charge_now_path)) < 0)
+	if ((charge_now = battery_read_value(POWER_SUPPLY_CHARGE_NOW, &batt_charge_now)) < 0)
 	{
 		return -1;
 	}
@@ -255,20 +497,29 @@ double battery_coulomb(void)
 }
 
 /**
- * @brief Read battery age
+ * @brief Read battery age: full charge capacity in percent of the design one
  *
  * @retval Battery age (double)
  */
 double battery_age(void)
 {
-	return -1;
+	int charge_full, charge_full_design;
+
+	if ((charge_full = battery_read_value(POWER_SUPPLY_CHARGE_FULL, &batt_charge_full)) < 0 ||
+	        (charge_full_design = battery_read_value(POWER_SUPPLY_CHARGE_FULL_DESIGN,
+	                              &batt_charge_full_design)) <= 0)
+	{
+		return -1;
+	}
+
+	return 100.0 * charge_full / charge_full_design;
 }
 
 bool battery_is_present(void)
 {
 	int present;
 
-	if ((present = nyx_utils_read_value(batt_present_path)) < 0)
+	if ((present = battery_read_value(POWER_SUPPLY_PRESENT, &batt_present)) < 0)
 	{
 		return false;
 	}
@@ -276,172 +527,282 @@ bool battery_is_present(void)
 	return (1 == present);
 }
 
-gboolean _handle_event(GIOChannel *channel, GIOCondition condition,
-                       gpointer data)
+static void detect_battery_sysfs_paths();
+
+/**
+ * @brief Read the values kept by the history and watched by subscriptions
+ */
+void battery_sample(nyx_battery_history_sample_t *sample)
 {
-	struct udev_device *dev;
+	memset(sample, 0, sizeof(nyx_battery_history_sample_t));
+	sample->time = g_get_real_time() / G_USEC_PER_SEC;
+	sample->present = battery_is_present();
 
-	if ((condition  & G_IO_IN) == G_IO_IN)
+	if (sample->present)
 	{
-		dev = udev_monitor_receive_device(mon);
+		sample->percentage = battery_percent();
+		sample->voltage = battery_voltage();
+		sample->current = battery_current();
+		sample->temperature = battery_temperature();
+		sample->charging = battery_is_charging(sample->current, NULL);
+	}
+}
 
-		if (dev)
-		{
-			/*Initiate callback only if battery percentage or present parameters change*/
-			int prev_battery_percentage = current_battery_percentage;
-			bool prev_battery_present = current_battery_present;
+static gboolean battery_sample_timer_cb(gpointer data)
+{
+	nyx_battery_history_sample_t sample;
+	int64_t since = g_get_real_time() / G_USEC_PER_SEC - battery_history_last_time();
 
-			current_battery_present = battery_is_present();
-			current_battery_percentage = current_battery_present ? battery_percent() : 0;
+	/* uevents already sampled recently enough; a newest sample in the
+	 * future (the clock stepped back) is no reason to wait */
+	if (since >= 0 && since < BATTERY_HISTORY_SAMPLE_S)
+	{
+		return TRUE;
+	}
 
-			if ((current_battery_present != prev_battery_present) ||
-			        (current_battery_percentage != prev_battery_percentage))
-			{
-				if (battery_callback != NULL)
-				{
-					battery_callback(nyxDev, NYX_CALLBACK_STATUS_DONE, battery_callback_context);
-				}
-			}
+	battery_snapshot_begin();
+	battery_estimate_update();
+	battery_sample(&sample);
+	battery_snapshot_end();
+
+	battery_history_add(&sample);
+	battery_subscription_notify(nyxDev, &sample);
+	return TRUE;
+}
+
+/**
+ * @brief Evaluate the last battery uevent of a burst
+ *
+ * @retval true if the battery callback or a subscription was called
+ */
+static bool battery_flush_events(void *data)
+{
+	/*Initiate callback only if battery percentage or present parameters change*/
+	int prev_battery_percentage = current_battery_percentage;
+	bool prev_battery_present = current_battery_present;
+	nyx_battery_history_sample_t sample;
+	bool delivered;
+
+	if (!battery_event_valid)
+	{
+		return false;
+	}
+
+	battery_snapshot = battery_event;
+	battery_snapshot_valid = true;
+	battery_event_valid = false;
+
+	current_battery_present = battery_is_present();
+	current_battery_percentage = current_battery_present ? battery_percent() : 0;
+	battery_estimate_update();
+	battery_sample(&sample);
+	battery_snapshot_end();
+
+	battery_history_add(&sample);
+
+	nyx_debug("%s: %u uevents, %u evaluations, %u delivered", __FUNCTION__,
+	          battery_events.raw_events, battery_events.evaluations, battery_events.delivered);
+
+	/* each subscription only for its own thresholds */
+	delivered = battery_subscription_notify(nyxDev, &sample) > 0;
+
+	if ((current_battery_present != prev_battery_present) ||
+	        (current_battery_percentage != prev_battery_percentage))
+	{
+		if (battery_callback != NULL)
+		{
+			battery_callback(nyxDev, NYX_CALLBACK_STATUS_DONE, battery_callback_context);
+			delivered = true;
 		}
-		else
+	}
+
+	return delivered;
+}
+
+/**
+ * @brief Counters of the uevent coalescing: battery uevents received and
+ * callbacks delivered for them
+ */
+void battery_get_event_counters(uint32_t *raw_events, uint32_t *delivered)
+{
+	if (raw_events)
+	{
+		*raw_events = battery_events.raw_events;
+	}
+
+	if (delivered)
+	{
+		*delivered = battery_events.delivered;
+	}
+}
+
+/* each uevent carries the whole state, so the last one of a burst is enough */
+static void battery_push_event(const power_supply_uevent_t *values)
+{
+	battery_event = *values;
+	battery_event_valid = true;
+	event_coalescer_push(&battery_events);
+}
+
+void _handle_event(const power_supply_event_t *event, void *data)
+{
+	if (!event->dev)
+	{
+		if (battery_callback != NULL)
 		{
-			if (battery_callback != NULL)
-			{
-				battery_callback(nyxDev, NYX_CALLBACK_STATUS_DONE, battery_callback_context);
-			}
+			battery_callback(nyxDev, NYX_CALLBACK_STATUS_DONE, battery_callback_context);
 		}
+
+		return;
 	}
 
-	return TRUE;
+	/* A battery that comes or goes moves every attribute */
+	if (event->index_changed)
+	{
+		detect_battery_sysfs_paths();
+	}
+
+	/* Events of the other supplies do not change the battery values */
+	if (event->has_values && sysfs_attr_of_supply(&batt_present, event->sysname))
+	{
+		battery_push_event(&event->values);
+	}
 }
 
 static void detect_battery_sysfs_paths()
 {
+	if (g_strcmp0(power_supply_path_by_type("Battery"), battery_sysfs_path) == 0)
+	{
+		return;
+	}
+
+	g_free(battery_sysfs_path);
 	battery_sysfs_path = find_power_supply_sysfs_path("Battery");
 
+	/* without a battery every attribute is left unset */
+	sysfs_attr_init(&batt_capacity, battery_sysfs_path, "capacity");
+	sysfs_attr_init(&batt_energy_now, battery_sysfs_path, "energy_now");
+	sysfs_attr_init(&batt_energy_full, battery_sysfs_path, "energy_full");
+	sysfs_attr_init(&batt_charge_now, battery_sysfs_path, "charge_now");
+	sysfs_attr_init(&batt_charge_full, battery_sysfs_path, "charge_full");
+	sysfs_attr_init(&batt_charge_full_design, battery_sysfs_path, "charge_full_design");
+	sysfs_attr_init(&batt_charge_counter, battery_sysfs_path, "charge_counter");
+	sysfs_attr_init(&batt_temperature, battery_sysfs_path, "temp");
+	sysfs_attr_init(&batt_voltage, battery_sysfs_path, "voltage_now");
+	sysfs_attr_init(&batt_current, battery_sysfs_path, "current_now");
+	sysfs_attr_init(&batt_present, battery_sysfs_path, "present");
+	sysfs_attr_init(&batt_status, battery_sysfs_path, "status");
+
 	if (battery_sysfs_path)
 	{
-		snprintf(batt_capacity_path, PATH_LEN, "%s/capacity", battery_sysfs_path);
-		snprintf(batt_energy_now_path, PATH_LEN, "%s/energy_now", battery_sysfs_path);
-		snprintf(batt_energy_full_path, PATH_LEN, "%s/energy_full", battery_sysfs_path);
-		snprintf(batt_charge_now_path, PATH_LEN, "%s/charge_now", battery_sysfs_path);
-		snprintf(batt_charge_full_path, PATH_LEN, "%s/charge_full", battery_sysfs_path);
-		snprintf(batt_charge_full_design_path, PATH_LEN, "%s/charge_full_design",
-		         battery_sysfs_path);
-		snprintf(batt_temperature_path, PATH_LEN, "%s/temp", battery_sysfs_path);
-		snprintf(batt_voltage_path, PATH_LEN, "%s/voltage_now", battery_sysfs_path);
-		snprintf(batt_current_path, PATH_LEN, "%s/current_now", battery_sysfs_path);
-		snprintf(batt_present_path, PATH_LEN, "%s/present", battery_sysfs_path);
 		snprintf(batt_fake_battery_path, PATH_LEN, "%s/pseudo_batt",
 		         battery_sysfs_path);
 	}
+	else
+	{
+		batt_fake_battery_path[0] = '\0';
+	}
 }
 
 static void battery_cleanup(void)
 {
-	// battery_init sets g_io_channel_set_close_on_unref, and calls g_io_channel_unref.
-	// This leaves one ref associated with the watch, so removing the watch should close the channel.
-	if (0 != watch)
+	unsigned int i;
+
+	for (i = 0; i < G_N_ELEMENTS(battery_attrs); i++)
 	{
-		g_source_remove(watch);
-		watch = 0;
+		sysfs_attr_close(battery_attrs[i]);
 	}
 
-	if (NULL != mon)
+	battery_simulator_stop();
+	event_coalescer_cancel(&battery_events);
+	battery_event_valid = false;
+	current_ewma_time = 0;
+
+	if (sample_timer)
 	{
-		udev_monitor_filter_remove(mon);
-		mon = NULL;
+		g_source_remove(sample_timer);
+		sample_timer = 0;
 	}
 
-	if (NULL != udev)
+	battery_history_close();
+	battery_subscription_clear();
+
+	g_free(battery_sysfs_path);
+	battery_sysfs_path = NULL;
+
+	if (listening)
 	{
-		udev_unref(udev);
-		udev = NULL;
+		power_supply_monitor_remove_listener(_handle_event, NULL);
+		listening = false;
 	}
 
 	return;
 }
 
-nyx_error_t battery_init(void)
+/**
+ * @brief Replay the profile named by NYX_BATTERY_SIMULATE instead of
+ * following the kernel battery
+ */
+static bool battery_simulator_init(const char *profile)
 {
-	int fd;
-	GIOChannel *channel = NULL;
-
-	udev = udev_new();
+	const char *speed = getenv("NYX_BATTERY_SIMULATE_SPEED");
+	const char *loops = getenv("NYX_BATTERY_SIMULATE_LOOPS");
 
-	if (!udev)
+	if (!battery_simulator_start(profile, speed ? g_ascii_strtod(speed, NULL) : 1.0,
+	                             loops ? strtoul(loops, NULL, 10) : 1, battery_push_event))
 	{
-		nyx_error(MSGID_NYX_MOD_UDEV_ERR, 0 ,
-		          "Could not initialize udev component; battery status updates will not be available");
-		return NYX_ERROR_GENERIC;
+		return false;
 	}
 
-	/*Initialize the sysfs paths*/
-	detect_battery_sysfs_paths();
-
-	// initialize current battery present/percentage values
-	current_battery_present = battery_is_present();
-	current_battery_percentage = current_battery_present ? battery_percent() : 0;
-
-	mon = udev_monitor_new_from_netlink(udev, "kernel");
+	nyx_debug("%s: simulating the battery from %s", __FUNCTION__, profile);
+	return true;
+}
 
-	if (mon == NULL)
-	{
-		nyx_error(MSGID_NYX_MOD_UDEV_MONITOR_ERR, 0,
-		          "Failed to create udev monitor for kernel events");
-		battery_cleanup();
-		return NYX_ERROR_GENERIC;
-	}
+nyx_error_t battery_init(void)
+{
+	const char *history_file = getenv("NYX_BATTERY_HISTORY_FILE");
+	const char *profile = getenv("NYX_BATTERY_SIMULATE");
 
-	if (udev_monitor_filter_add_match_subsystem_devtype(mon, "power_supply",
-	        NULL) < 0)
+	if (profile)
 	{
-		nyx_error(MSGID_NYX_MOD_UDEV_SUBSYSTEM_ERR, 0,
-		          "Failed to setup udev filter for power_supply subsytem events");
-		battery_cleanup();
-		return NYX_ERROR_GENERIC;
+		if (!battery_simulator_init(profile))
+		{
+			return NYX_ERROR_GENERIC;
+		}
 	}
-
-	if (udev_monitor_enable_receiving(mon) < 0)
+	else
 	{
-		nyx_error(MSGID_NYX_MOD_UDEV_RECV_ERR, 0,
-		          "Failed to enable receiving kernel events for power_supply subsytem\n");
-		battery_cleanup();
-		return NYX_ERROR_GENERIC;
+		/*Initialize the sysfs paths*/
+		detect_battery_sysfs_paths();
 	}
 
-	/* Setup io watch for uevents */
-	fd = udev_monitor_get_fd(mon);
+	// initialize current battery present/percentage values
+	current_battery_present = battery_is_present();
+	current_battery_percentage = current_battery_present ? battery_percent() : 0;
 
-	if (-1 == fd)
-	{
-		battery_cleanup();
-		return NYX_ERROR_GENERIC;
-	}
+	event_coalescer_init(&battery_events, power_supply_coalesce_ms(),
+	                     battery_flush_events, NULL);
 
-	channel = g_io_channel_unix_new(fd);
+	/* a simulated battery has no place in the persisted history */
+	battery_history_open(profile ? NULL : history_file ? history_file : BATTERY_HISTORY_FILE, 0);
+	sample_timer = g_timeout_add_seconds(BATTERY_HISTORY_SAMPLE_S,
+	                                     battery_sample_timer_cb, NULL);
 
-	if (!channel)
+	if (profile)
 	{
-		battery_cleanup();
-		return NYX_ERROR_GENERIC;
+		return NYX_ERROR_NONE;
 	}
 
-	/* add watch event (which adds a ref) before calling g_io_channel_unref */
-	watch = g_io_add_watch(channel, G_IO_IN | G_IO_HUP | G_IO_NVAL, _handle_event,
-	                       NULL);
-
-	/* Remove the ref from g_io_channel_unix_new so we won't leak the channel if g_io_add_watch failed */
-	/* watch holds another ref which is removed in battery_cleanup */
-	g_io_channel_set_close_on_unref(channel, TRUE);
-	g_io_channel_unref(channel);
-
-	if (0 == watch)
+	/* uevents come from the monitor shared with the charger module */
+	if (power_supply_monitor_add_listener(_handle_event, NULL) < 0)
 	{
+		nyx_error(MSGID_NYX_MOD_UDEV_ERR, 0,
+		          "Could not monitor power_supply events; battery status updates will not be available");
 		battery_cleanup();
 		return NYX_ERROR_GENERIC;
 	}
 
+	listening = true;
 	return NYX_ERROR_NONE;
 }
 
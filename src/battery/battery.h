@@ -21,9 +21,16 @@
 #ifndef BATTERY_H_
 #define BATTERY_H_
 
+#include <stdint.h>
+#include <stdbool.h>
 #include <nyx/common/nyx_error.h>
 #include <nyx/common/nyx_battery_common.h>
 
+#include "utils.h"
+#include "battery_history.h"
+#include "battery_estimate.h"
+#include "battery_subscription.h"
+
 // These functions are implemented in device/battery.c or emulator/fake_battery.c
 
 // called by batterylib.c
@@ -32,6 +39,8 @@ nyx_error_t battery_deinit(void);
 nyx_battery_ctia_t *get_battery_ctia_params(void);
 
 // called by battery_read_status() in batterylib.c
+void battery_snapshot_begin(void);
+void battery_snapshot_end(void);
 int battery_percent(void);
 int battery_temperature(void);
 int battery_voltage(void);
@@ -42,6 +51,8 @@ double battery_rawcoulomb(void);
 double battery_coulomb(void);
 double battery_age(void);
 bool battery_is_present(void);
+void battery_get_estimate(nyx_battery_estimate_t *estimate);
+void battery_sample(nyx_battery_history_sample_t *sample);
 
 // not currently supported by device/battery.c or emulator/fake_battery.c (stub implementations)
 bool battery_authenticate(void);
@@ -50,6 +61,43 @@ void battery_set_wakeup_percent(int);
 void battery_set_fakemode(bool);
 nyx_error_t battery_get_fakemode(bool *);
 
+// uevents received versus battery callbacks delivered after coalescing
+void battery_get_event_counters(uint32_t *raw_events, uint32_t *delivered);
+
+// history of samples, implemented in battery_history.c
+#define BATTERY_HISTORY_CAPACITY 4096       /* samples, about 48 KiB on disk */
+#define BATTERY_HISTORY_FILE "/var/lib/nyx/battery_history"
+#define BATTERY_HISTORY_SAMPLE_S 60         /* sampling period when no uevent arrives */
+#define BATTERY_HISTORY_MIN_SPACING_S 10    /* unless percentage or state changed */
+#define BATTERY_HISTORY_SYNC_S 600          /* write back period of the mapped file */
+
+void battery_history_open(const char *path, uint32_t capacity);
+void battery_history_close(void);
+void battery_history_sync(bool wait);
+bool battery_history_add(const nyx_battery_history_sample_t *sample);
+int64_t battery_history_last_time(void);
+uint32_t battery_history_query(int64_t from, int64_t to,
+                               nyx_battery_history_sample_t *samples, uint32_t max);
+
+// listeners with thresholds, implemented in battery_subscription.c
+uint32_t battery_subscription_add(const nyx_battery_subscription_t *criteria,
+                                  nyx_device_callback_function_t callback, void *context,
+                                  const nyx_battery_history_sample_t *sample);
+bool battery_subscription_remove(uint32_t id);
+void battery_subscription_clear(void);
+unsigned int battery_subscription_notify(nyx_device_handle_t handle,
+        const nyx_battery_history_sample_t *sample);
+
+// simulated battery, implemented in battery_simulator.c; battery_init()
+// replays the profile in NYX_BATTERY_SIMULATE, NYX_BATTERY_SIMULATE_SPEED
+// times faster (0 as fast as possible) and NYX_BATTERY_SIMULATE_LOOPS times
+// (0 for ever), instead of following the kernel battery
+bool battery_simulator_start(const char *path, double replay_speed, unsigned int loops,
+                             void (*apply)(const power_supply_uevent_t *values));
+void battery_simulator_stop(void);
+const power_supply_uevent_t *battery_simulator_state(void);
+bool battery_simulator_running(void);
+
 // not currently called by batterylib.c
 // bool battery_is_authenticated(const char *pair_challenge, const char *pair_response);
 
@@ -0,0 +1,52 @@
+// Copyright (c) 2024 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+/**
+ * @file battery_estimate.h
+ *
+ * @brief Remaining runtime estimated by the battery module.
+ *
+ * Installed as <nyx-battery/battery_estimate.h>; look the query up with
+ * dlsym() as described in battery_history.h.
+ */
+
+#ifndef BATTERY_ESTIMATE_H_
+#define BATTERY_ESTIMATE_H_
+
+#include <stdbool.h>
+#include <nyx/nyx_module.h>
+
+typedef struct
+{
+	int avg_current;        /* uA, averaged over about a minute */
+	bool charging;
+	int time_to_empty;      /* s, -1 if unknown or charging */
+	int time_to_full;       /* s, -1 if unknown or discharging */
+} nyx_battery_estimate_t;
+
+/**
+ * Read the time to empty and the time to full at the present average
+ * current. The module updates the average on every battery sample, so this
+ * is as cheap as the status query.
+ */
+nyx_error_t battery_query_estimate(nyx_device_handle_t handle,
+                                   nyx_battery_estimate_t *estimate);
+
+#define BATTERY_QUERY_ESTIMATE_SYMBOL "battery_query_estimate"
+typedef nyx_error_t (*battery_query_estimate_function_t)(nyx_device_handle_t handle,
+        nyx_battery_estimate_t *estimate);
+
+#endif /* BATTERY_ESTIMATE_H_ */
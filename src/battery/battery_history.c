@@ -0,0 +1,348 @@
+// Copyright (c) 2024 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+/**
+ * @file battery_history.c
+ *
+ * @brief Ring of battery samples in a memory mapped file.
+ *
+ * The ring lives in the mapping itself, so a sample costs a 12 byte store.
+ * The kernel writes the pages back on its own; the ring is only msync()ed
+ * (asynchronously) every BATTERY_HISTORY_SYNC_S seconds and synchronously
+ * when the module closes. Without a usable file the ring is kept in memory.
+ *
+ * Every process that opens the battery module gets here, so only the one
+ * holding an exclusive flock() on the file maps it; the others keep their
+ * ring in memory rather than racing on head and count.
+ */
+
+#include <glib.h>
+#include <string.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <nyx/nyx_module.h>
+#include <nyx/module/nyx_log.h>
+#include "msgid.h"
+
+#include "battery.h"
+#include "battery_history.h"
+
+#define BATTERY_HISTORY_MAGIC       0x48425942  /* "BYBH" */
+#define BATTERY_HISTORY_VERSION     1
+
+#define BATTERY_HISTORY_CHARGING    0x01
+#define BATTERY_HISTORY_PRESENT     0x02
+
+/* 12 bytes per sample, fixed point */
+typedef struct __attribute__((packed))
+{
+	uint32_t time;          /* s since epoch */
+	uint16_t voltage;       /* mV */
+	int16_t current;        /* mA */
+	int16_t temperature;    /* 0.1 degC */
+	uint8_t percentage;
+	uint8_t flags;
+} battery_history_record_t;
+
+typedef struct
+{
+	uint32_t magic;
+	uint16_t version;
+	uint16_t record_size;
+	uint32_t capacity;
+	uint32_t head;          /* slot of the next record */
+	uint32_t count;
+	uint32_t reserved[3];
+	battery_history_record_t records[];
+} battery_history_t;
+
+static battery_history_t *history = NULL;
+static size_t history_size = 0;
+static bool history_mapped = false;
+static int history_fd = -1;
+static guint history_sync_timer = 0;
+
+static size_t battery_history_size(uint32_t capacity)
+{
+	return sizeof(battery_history_t) + capacity * sizeof(battery_history_record_t);
+}
+
+static void battery_history_reset(battery_history_t *ring, uint32_t capacity)
+{
+	memset(ring, 0, sizeof(battery_history_t));
+	ring->magic = BATTERY_HISTORY_MAGIC;
+	ring->version = BATTERY_HISTORY_VERSION;
+	ring->record_size = sizeof(battery_history_record_t);
+	ring->capacity = capacity;
+}
+
+static bool battery_history_valid(const battery_history_t *ring, uint32_t capacity)
+{
+	return ring->magic == BATTERY_HISTORY_MAGIC &&
+	       ring->version == BATTERY_HISTORY_VERSION &&
+	       ring->record_size == sizeof(battery_history_record_t) &&
+	       ring->capacity == capacity &&
+	       ring->head < capacity && ring->count <= capacity;
+}
+
+static battery_history_t *battery_history_map(const char *path, uint32_t capacity)
+{
+	size_t size = battery_history_size(capacity);
+	gchar *dir = g_path_get_dirname(path);
+	battery_history_t *ring;
+	struct stat st;
+	int fd;
+
+	g_mkdir_with_parents(dir, 0755);
+	g_free(dir);
+
+	fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+
+	if (fd < 0)
+	{
+		return NULL;
+	}
+
+	/* Held for as long as the ring is mapped, released by close() */
+	if (flock(fd, LOCK_EX | LOCK_NB) < 0)
+	{
+		int err = errno;
+
+		close(fd);
+		errno = err;
+		return NULL;
+	}
+
+	if (fstat(fd, &st) < 0 || ((size_t)st.st_size != size && ftruncate(fd, size) < 0))
+	{
+		close(fd);
+		return NULL;
+	}
+
+	ring = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+	if (ring == MAP_FAILED)
+	{
+		close(fd);
+		return NULL;
+	}
+
+	history_fd = fd;
+
+	if (!battery_history_valid(ring, capacity))
+	{
+		battery_history_reset(ring, capacity);
+	}
+
+	return ring;
+}
+
+static gboolean battery_history_sync_cb(gpointer data)
+{
+	battery_history_sync(false);
+	return TRUE;
+}
+
+/**
+ * @brief Open the history in path, or in memory only if that fails.
+ */
+void battery_history_open(const char *path, uint32_t capacity)
+{
+	battery_history_close();
+
+	if (capacity == 0)
+	{
+		capacity = BATTERY_HISTORY_CAPACITY;
+	}
+
+	history_size = battery_history_size(capacity);
+	history = path ? battery_history_map(path, capacity) : NULL;
+	history_mapped = (history != NULL);
+
+	if (!history)
+	{
+		if (path)
+		{
+			nyx_error(MSGID_NYX_MOD_BATT_HISTORY_ERR, 0,
+			          "Cannot map %s (%s); battery history is not persisted", path,
+			          errno == EWOULDBLOCK ? "in use by another process" : strerror(errno));
+		}
+
+		history = g_malloc(history_size);
+		battery_history_reset(history, capacity);
+	}
+	else
+	{
+		history_sync_timer = g_timeout_add_seconds(BATTERY_HISTORY_SYNC_S,
+		                                           battery_history_sync_cb, NULL);
+	}
+}
+
+void battery_history_close(void)
+{
+	if (history_sync_timer)
+	{
+		g_source_remove(history_sync_timer);
+		history_sync_timer = 0;
+	}
+
+	if (!history)
+	{
+		return;
+	}
+
+	if (history_mapped)
+	{
+		battery_history_sync(true);
+		munmap(history, history_size);
+		close(history_fd);
+		history_fd = -1;
+	}
+	else
+	{
+		g_free(history);
+	}
+
+	history = NULL;
+	history_mapped = false;
+}
+
+/**
+ * @brief Schedule write back of the mapped ring; wait for it if wait is set.
+ */
+void battery_history_sync(bool wait)
+{
+	if (history && history_mapped)
+	{
+		msync(history, history_size, wait ? MS_SYNC : MS_ASYNC);
+	}
+}
+
+static int32_t clamp(int64_t value, int32_t min, int32_t max)
+{
+	return value < min ? min : (value > max ? max : (int32_t)value);
+}
+
+static const battery_history_record_t *battery_history_last(void)
+{
+	uint32_t slot;
+
+	if (!history || history->count == 0)
+	{
+		return NULL;
+	}
+
+	slot = (history->head + history->capacity - 1) % history->capacity;
+	return &history->records[slot];
+}
+
+/**
+ * @brief Time of the newest sample, 0 if there is none
+ */
+int64_t battery_history_last_time(void)
+{
+	const battery_history_record_t *last = battery_history_last();
+
+	return last ? last->time : 0;
+}
+
+/**
+ * @brief Append a sample. Within BATTERY_HISTORY_MIN_SPACING_S of the last
+ * one it is dropped unless percentage, charging or presence changed.
+ *
+ * @retval true if it was stored
+ */
+bool battery_history_add(const nyx_battery_history_sample_t *sample)
+{
+	const battery_history_record_t *last = battery_history_last();
+	battery_history_record_t record;
+
+	if (!history || !sample)
+	{
+		return false;
+	}
+
+	record.time = (uint32_t)clamp(sample->time, 0, INT32_MAX);
+	record.voltage = (uint16_t)clamp(sample->voltage / 1000, 0, UINT16_MAX);
+	record.current = (int16_t)clamp(sample->current / 1000, INT16_MIN, INT16_MAX);
+	record.temperature = (int16_t)clamp(sample->temperature, INT16_MIN, INT16_MAX);
+	record.percentage = (uint8_t)clamp(sample->percentage, 0, 100);
+	record.flags = (sample->charging ? BATTERY_HISTORY_CHARGING : 0) |
+	               (sample->present ? BATTERY_HISTORY_PRESENT : 0);
+
+	if (last && record.time >= last->time &&
+	        record.time - last->time < BATTERY_HISTORY_MIN_SPACING_S &&
+	        record.percentage == last->percentage && record.flags == last->flags)
+	{
+		return false;
+	}
+
+	history->records[history->head] = record;
+	history->head = (history->head + 1) % history->capacity;
+
+	if (history->count < history->capacity)
+	{
+		history->count++;
+	}
+
+	return true;
+}
+
+/**
+ * @brief Copy up to max samples between from and to, oldest first.
+ *
+ * @retval number of samples copied
+ */
+uint32_t battery_history_query(int64_t from, int64_t to,
+                               nyx_battery_history_sample_t *samples, uint32_t max)
+{
+	uint32_t first, i, n = 0;
+
+	if (!history || !samples)
+	{
+		return 0;
+	}
+
+	first = (history->head + history->capacity - history->count) % history->capacity;
+
+	for (i = 0; i < history->count && n < max; i++)
+	{
+		const battery_history_record_t *record =
+		    &history->records[(first + i) % history->capacity];
+
+		if (record->time < from || record->time > to)
+		{
+			continue;
+		}
+
+		samples[n].time = record->time;
+		samples[n].percentage = record->percentage;
+		samples[n].voltage = record->voltage * 1000;
+		samples[n].current = record->current * 1000;
+		samples[n].temperature = record->temperature;
+		samples[n].charging = (record->flags & BATTERY_HISTORY_CHARGING) != 0;
+		samples[n].present = (record->flags & BATTERY_HISTORY_PRESENT) != 0;
+		n++;
+	}
+
+	return n;
+}
@@ -0,0 +1,69 @@
+// Copyright (c) 2024 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+/**
+ * @file battery_history.h
+ *
+ * @brief History of battery samples kept by the battery module.
+ *
+ * Installed as <nyx-battery/battery_history.h>. nyx-lib fixes the method
+ * table of a module, so the query is not a nyx method; clients look it up
+ * in the battery module nyx_device_open() loaded and call it with the
+ * handle they got:
+ *
+ *     void *module = dlopen(<battery module library>, RTLD_NOW | RTLD_NOLOAD);
+ *     battery_query_history_function_t query_history =
+ *         (battery_query_history_function_t) dlsym(module, BATTERY_QUERY_HISTORY_SYMBOL);
+ */
+
+#ifndef BATTERY_HISTORY_H_
+#define BATTERY_HISTORY_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <nyx/nyx_module.h>
+
+/**
+ * One sample, in the units of nyx_battery_status_t. The history stores
+ * voltage and current at mV and mA resolution.
+ */
+typedef struct
+{
+	int64_t time;           /* wall clock, s since epoch */
+	int percentage;
+	int voltage;            /* uV */
+	int current;            /* uA */
+	int temperature;        /* 0.1 degC */
+	bool charging;
+	bool present;
+} nyx_battery_history_sample_t;
+
+/**
+ * Copy the samples taken between from and to (s since epoch, inclusive),
+ * oldest first, up to max of them, into samples and their number into
+ * count. The module keeps the last few days across restarts.
+ */
+nyx_error_t battery_query_history(nyx_device_handle_t handle,
+                                  int64_t from, int64_t to,
+                                  nyx_battery_history_sample_t *samples,
+                                  uint32_t max, uint32_t *count);
+
+#define BATTERY_QUERY_HISTORY_SYMBOL "battery_query_history"
+typedef nyx_error_t (*battery_query_history_function_t)(nyx_device_handle_t handle,
+        int64_t from, int64_t to, nyx_battery_history_sample_t *samples,
+        uint32_t max, uint32_t *count);
+
+#endif /* BATTERY_HISTORY_H_ */
@@ -0,0 +1,311 @@
+// Copyright (c) 2024 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+
+/**
+ * @file battery_simulator.c
+ *
+ * @brief Replays a battery profile in place of the kernel power_supply.
+ *
+ * A profile is a text file with one step per line:
+ *
+ *     # ms since start, then sysfs attribute=value pairs or plug/unplug
+ *     0     present=1 capacity=80 current_now=-450000 voltage_now=3912000 temp=251
+ *     60000 capacity=79 voltage_now=3905000
+ *     90000 plug current_now=1200000
+ *
+ * A step only lists what changes; plug and unplug set the status to
+ * Charging and Discharging. Every step is handed over as a complete
+ * power_supply uevent, so it takes the same path as a kernel uevent.
+ */
+
+#include <glib.h>
+#include <string.h>
+#include <stdlib.h>
+#include <errno.h>
+
+#include <nyx/nyx_module.h>
+#include <nyx/module/nyx_log.h>
+#include "msgid.h"
+
+#include "battery.h"
+#include "utils.h"
+
+typedef struct
+{
+	uint32_t time;          /* ms since start */
+	power_supply_uevent_t values;
+} battery_simulator_step_t;
+
+static GArray *steps = NULL;
+static unsigned int step_index = 0;
+static double speed = 1.0;
+static unsigned int loops_left = 0;     /* 0 for ever */
+static guint step_timer = 0;
+static power_supply_uevent_t state;
+static void (*apply_step)(const power_supply_uevent_t *values) = NULL;
+
+static void battery_simulator_merge(power_supply_uevent_t *into,
+                                    const power_supply_uevent_t *from)
+{
+	int i;
+
+	for (i = 0; i < POWER_SUPPLY_KEY_COUNT; i++)
+	{
+		if (from->valid & (1U << i))
+		{
+			into->value[i] = from->value[i];
+			into->valid |= 1U << i;
+		}
+	}
+
+	if (from->status[0])
+	{
+		g_strlcpy(into->status, from->status, POWER_SUPPLY_STATUS_LEN);
+	}
+}
+
+static bool battery_simulator_parse_line(char *line, battery_simulator_step_t *step)
+{
+	gchar **tokens;
+	char *endptr;
+	bool ok = true;
+	int i;
+
+	memset(step, 0, sizeof(battery_simulator_step_t));
+	tokens = g_strsplit_set(g_strstrip(line), " \t", -1);
+
+	errno = 0;
+	step->time = strtoul(tokens[0], &endptr, 10);
+
+	if (endptr == tokens[0] || *endptr || errno)
+	{
+		g_strfreev(tokens);
+		return false;
+	}
+
+	for (i = 1; tokens[i] && ok; i++)
+	{
+		char *value = strchr(tokens[i], '=');
+		gchar *key, *name;
+
+		if (!tokens[i][0])
+		{
+			continue;
+		}
+
+		if (strcmp(tokens[i], "plug") == 0)
+		{
+			g_strlcpy(step->values.status, "Charging", POWER_SUPPLY_STATUS_LEN);
+			continue;
+		}
+
+		if (strcmp(tokens[i], "unplug") == 0)
+		{
+			g_strlcpy(step->values.status, "Discharging", POWER_SUPPLY_STATUS_LEN);
+			continue;
+		}
+
+		if (!value)
+		{
+			ok = false;
+			break;
+		}
+
+		/* the sysfs attribute name is the POWER_SUPPLY_ key in lower case */
+		*value++ = '\0';
+		key = g_ascii_strup(tokens[i], -1);
+		name = g_strconcat("POWER_SUPPLY_", key, NULL);
+		ok = power_supply_uevent_set(&step->values, name, value);
+		g_free(name);
+		g_free(key);
+	}
+
+	g_strfreev(tokens);
+	return ok;
+}
+
+/**
+ * @brief Load a profile
+ *
+ * @retval the steps, or NULL if the file cannot be read or a line is invalid
+ */
+static GArray *battery_simulator_load(const char *path)
+{
+	battery_simulator_step_t step;
+	gchar *contents = NULL;
+	gchar **lines;
+	GArray *loaded;
+	uint32_t last = 0;
+	int i;
+
+	if (!g_file_get_contents(path, &contents, NULL, NULL))
+	{
+		nyx_error(MSGID_NYX_MOD_BATT_SIMULATOR_ERR, 0, "Cannot read battery profile %s", path);
+		return NULL;
+	}
+
+	loaded = g_array_new(FALSE, FALSE, sizeof(battery_simulator_step_t));
+	lines = g_strsplit(contents, "\n", -1);
+	g_free(contents);
+
+	for (i = 0; lines[i]; i++)
+	{
+		char *line = g_strstrip(lines[i]);
+
+		if (!line[0] || line[0] == '#')
+		{
+			continue;
+		}
+
+		if (!battery_simulator_parse_line(line, &step) || step.time < last)
+		{
+			nyx_error(MSGID_NYX_MOD_BATT_SIMULATOR_ERR, 0,
+			          "Invalid step at line %d of battery profile %s", i + 1, path);
+			g_array_free(loaded, TRUE);
+			loaded = NULL;
+			break;
+		}
+
+		last = step.time;
+		g_array_append_val(loaded, step);
+	}
+
+	g_strfreev(lines);
+
+	if (loaded && loaded->len == 0)
+	{
+		g_array_free(loaded, TRUE);
+		loaded = NULL;
+	}
+
+	return loaded;
+}
+
+static void battery_simulator_schedule(void);
+
+static gboolean battery_simulator_step_cb(gpointer data)
+{
+	const battery_simulator_step_t *step =
+	    &g_array_index(steps, battery_simulator_step_t, step_index);
+
+	step_timer = 0;
+	battery_simulator_merge(&state, &step->values);
+	apply_step(&state);
+
+	if (++step_index == steps->len)
+	{
+		if (loops_left == 1)
+		{
+			nyx_debug("%s: battery profile replayed", __FUNCTION__);
+			return FALSE;
+		}
+
+		if (loops_left)
+		{
+			loops_left--;
+		}
+
+		step_index = 0;
+	}
+
+	battery_simulator_schedule();
+	return FALSE;
+}
+
+static void battery_simulator_schedule(void)
+{
+	const battery_simulator_step_t *step =
+	    &g_array_index(steps, battery_simulator_step_t, step_index);
+	uint32_t delay = 0;
+
+	/* a new loop starts right after the last step */
+	if (step_index > 0 && speed > 0)
+	{
+		delay = (step->time -
+		         g_array_index(steps, battery_simulator_step_t, step_index - 1).time) / speed;
+	}
+
+	step_timer = g_timeout_add(delay, battery_simulator_step_cb, NULL);
+}
+
+/**
+ * @brief Replay the profile in path; speed scales its time (0 replays it as
+ * fast as possible) and it runs loops times (0 for ever). The first step is
+ * the state the battery starts in, see battery_simulator_state(); apply is
+ * called with the state after each of the following ones.
+ *
+ * @retval true if the profile could be loaded
+ */
+bool battery_simulator_start(const char *path, double replay_speed, unsigned int loops,
+                             void (*apply)(const power_supply_uevent_t *values))
+{
+	battery_simulator_stop();
+
+	if (!path || !apply || !(steps = battery_simulator_load(path)))
+	{
+		return false;
+	}
+
+	speed = replay_speed > 0 ? replay_speed : 0;
+	loops_left = loops;
+	apply_step = apply;
+	memset(&state, 0, sizeof(state));
+
+	step_index = 0;
+	battery_simulator_merge(&state, &g_array_index(steps, battery_simulator_step_t, 0).values);
+
+	if (steps->len > 1)
+	{
+		step_index = 1;
+		battery_simulator_schedule();
+	}
+
+	return true;
+}
+
+void battery_simulator_stop(void)
+{
+	if (step_timer)
+	{
+		g_source_remove(step_timer);
+		step_timer = 0;
+	}
+
+	if (steps)
+	{
+		g_array_free(steps, TRUE);
+		steps = NULL;
+	}
+
+	apply_step = NULL;
+}
+
+/**
+ * @brief The simulated battery values, NULL when no profile is loaded
+ */
+const power_supply_uevent_t *battery_simulator_state(void)
+{
+	return steps ? &state : NULL;
+}
+
+/**
+ * @brief Whether steps are still to be replayed
+ */
+bool battery_simulator_running(void)
+{
+	return step_timer != 0;
+}
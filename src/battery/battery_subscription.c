@@ -0,0 +1,194 @@
+// Copyright (c) 2024 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+
+/**
+ * @file battery_subscription.c
+ *
+ * @brief Listeners of the battery status, each with its own thresholds.
+ *
+ * Every listener remembers the sample it was last called for (or subscribed
+ * with) and is called again only once a sample lands in another percentage
+ * step, voltage or temperature zone, or charging or presence state.
+ */
+
+#include <glib.h>
+#include <string.h>
+
+#include <nyx/nyx_module.h>
+#include <nyx/module/nyx_log.h>
+
+#include "battery.h"
+
+typedef struct
+{
+	uint32_t id;
+	nyx_battery_subscription_t criteria;
+	nyx_device_callback_function_t callback;
+	void *context;
+	nyx_battery_history_sample_t last;
+} battery_subscription_t;
+
+static GSList *subscriptions = NULL;
+static uint32_t next_subscription_id = 1;
+
+static bool battery_subscription_valid(const nyx_battery_subscription_t *criteria)
+{
+	if (criteria->percentage_step < 0 ||
+	        criteria->voltage_low > criteria->voltage_high ||
+	        criteria->temperature_low > criteria->temperature_high)
+	{
+		return false;
+	}
+
+	return criteria->percentage_step || criteria->voltage_high ||
+	       criteria->temperature_low || criteria->temperature_high ||
+	       criteria->charging || criteria->presence;
+}
+
+/* -1 below the band, 0 inside, 1 above */
+static int band_zone(int value, int low, int high)
+{
+	return value < low ? -1 : (value > high ? 1 : 0);
+}
+
+static bool battery_subscription_crossed(const battery_subscription_t *sub,
+        const nyx_battery_history_sample_t *sample)
+{
+	const nyx_battery_subscription_t *c = &sub->criteria;
+	const nyx_battery_history_sample_t *last = &sub->last;
+
+	if (c->presence && sample->present != last->present)
+	{
+		return true;
+	}
+
+	if (c->charging && sample->charging != last->charging)
+	{
+		return true;
+	}
+
+	if (c->percentage_step &&
+	        sample->percentage / c->percentage_step != last->percentage / c->percentage_step)
+	{
+		return true;
+	}
+
+	if ((c->voltage_low || c->voltage_high) &&
+	        band_zone(sample->voltage, c->voltage_low, c->voltage_high) !=
+	        band_zone(last->voltage, c->voltage_low, c->voltage_high))
+	{
+		return true;
+	}
+
+	if ((c->temperature_low || c->temperature_high) &&
+	        band_zone(sample->temperature, c->temperature_low, c->temperature_high) !=
+	        band_zone(last->temperature, c->temperature_low, c->temperature_high))
+	{
+		return true;
+	}
+
+	return false;
+}
+
+/**
+ * @brief Add a listener, starting from sample
+ *
+ * @retval its id, 0 if the criteria watch nothing or are inconsistent
+ */
+uint32_t battery_subscription_add(const nyx_battery_subscription_t *criteria,
+                                  nyx_device_callback_function_t callback, void *context,
+                                  const nyx_battery_history_sample_t *sample)
+{
+	battery_subscription_t *sub;
+
+	if (!criteria || !callback || !sample || !battery_subscription_valid(criteria))
+	{
+		return 0;
+	}
+
+	sub = g_new0(battery_subscription_t, 1);
+	sub->id = next_subscription_id++;
+	sub->criteria = *criteria;
+	sub->callback = callback;
+	sub->context = context;
+	sub->last = *sample;
+
+	/* 0 is never an id */
+	if (next_subscription_id == 0)
+	{
+		next_subscription_id = 1;
+	}
+
+	subscriptions = g_slist_append(subscriptions, sub);
+	return sub->id;
+}
+
+bool battery_subscription_remove(uint32_t id)
+{
+	GSList *l;
+
+	for (l = subscriptions; l; l = l->next)
+	{
+		battery_subscription_t *sub = l->data;
+
+		if (sub->id == id)
+		{
+			subscriptions = g_slist_delete_link(subscriptions, l);
+			g_free(sub);
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void battery_subscription_clear(void)
+{
+	g_slist_free_full(subscriptions, g_free);
+	subscriptions = NULL;
+}
+
+/**
+ * @brief Call the listeners whose thresholds sample crosses
+ *
+ * @retval number of listeners called
+ */
+unsigned int battery_subscription_notify(nyx_device_handle_t handle,
+        const nyx_battery_history_sample_t *sample)
+{
+	GSList *copy = g_slist_copy(subscriptions);
+	unsigned int notified = 0;
+	GSList *l;
+
+	// A listener may unsubscribe itself, or another one, from its callback
+	for (l = copy; l; l = l->next)
+	{
+		battery_subscription_t *sub = l->data;
+
+		if (!g_slist_find(subscriptions, sub) || !battery_subscription_crossed(sub, sample))
+		{
+			continue;
+		}
+
+		sub->last = *sample;
+		notified++;
+		sub->callback(handle, NYX_CALLBACK_STATUS_DONE, sub->context);
+	}
+
+	g_slist_free(copy);
+	return notified;
+}
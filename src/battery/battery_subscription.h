@@ -0,0 +1,70 @@
+// Copyright (c) 2024 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+
+/**
+ * @file battery_subscription.h
+ *
+ * @brief Battery status callbacks with per listener thresholds.
+ *
+ * Installed as <nyx-battery/battery_subscription.h>; look both functions up
+ * with dlsym() as described in battery_history.h. Callbacks run on the
+ * module's main loop, like the status callback.
+ */
+
+#ifndef BATTERY_SUBSCRIPTION_H_
+#define BATTERY_SUBSCRIPTION_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <nyx/nyx_module.h>
+
+/**
+ * What a listener wants to be called for; fields left 0 are not watched.
+ * A band calls back when the value enters or leaves [low, high].
+ */
+typedef struct
+{
+	int percentage_step;    /* percentage crosses a multiple of it */
+	int voltage_low;        /* uV */
+	int voltage_high;
+	int temperature_low;    /* 0.1 degC */
+	int temperature_high;
+	bool charging;          /* charging starts or stops */
+	bool presence;          /* battery inserted or removed */
+} nyx_battery_subscription_t;
+
+/**
+ * Call callback with context whenever the battery crosses one of the
+ * thresholds of criteria. Any number of listeners can subscribe, next to the
+ * callback of battery_register_battery_status_callback(). id receives the
+ * handle for battery_unsubscribe().
+ */
+nyx_error_t battery_subscribe(nyx_device_handle_t handle,
+                              const nyx_battery_subscription_t *criteria,
+                              nyx_device_callback_function_t callback,
+                              void *context, uint32_t *id);
+
+nyx_error_t battery_unsubscribe(nyx_device_handle_t handle, uint32_t id);
+
+#define BATTERY_SUBSCRIBE_SYMBOL "battery_subscribe"
+#define BATTERY_UNSUBSCRIBE_SYMBOL "battery_unsubscribe"
+typedef nyx_error_t (*battery_subscribe_function_t)(nyx_device_handle_t handle,
+        const nyx_battery_subscription_t *criteria,
+        nyx_device_callback_function_t callback, void *context, uint32_t *id);
+typedef nyx_error_t (*battery_unsubscribe_function_t)(nyx_device_handle_t handle, uint32_t id);
+
+#endif /* BATTERY_SUBSCRIPTION_H_ */
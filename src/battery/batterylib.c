@@ -132,6 +132,7 @@ void battery_read_status(nyx_battery_status_t *state)
 	{
 		memset(state, 0, sizeof(nyx_battery_status_t));
 
+		battery_snapshot_begin();
 		state->present = battery_is_present();
 
 		if (state->present)
@@ -155,6 +156,8 @@ void battery_read_status(nyx_battery_status_t *state)
 		{
 			state->charging = false;
 		}
+
+		battery_snapshot_end();
 	}
 }
 
@@ -280,3 +283,84 @@ nyx_error_t battery_get_fake_mode(nyx_device_handle_t handle,
 
 	return err;
 }
+
+nyx_error_t battery_query_history(nyx_device_handle_t handle,
+                                  int64_t from, int64_t to,
+                                  nyx_battery_history_sample_t *samples,
+                                  uint32_t max, uint32_t *count)
+{
+	if (handle != nyxDev)
+	{
+		return NYX_ERROR_INVALID_HANDLE;
+	}
+
+	if (!samples || !count || from > to)
+	{
+		return NYX_ERROR_INVALID_VALUE;
+	}
+
+	*count = battery_history_query(from, to, samples, max);
+	return NYX_ERROR_NONE;
+}
+
+nyx_error_t battery_query_estimate(nyx_device_handle_t handle,
+                                   nyx_battery_estimate_t *estimate)
+{
+	if (handle != nyxDev)
+	{
+		return NYX_ERROR_INVALID_HANDLE;
+	}
+
+	if (!estimate)
+	{
+		return NYX_ERROR_INVALID_VALUE;
+	}
+
+	battery_snapshot_begin();
+	battery_get_estimate(estimate);
+	battery_snapshot_end();
+
+	return NYX_ERROR_NONE;
+}
+
+nyx_error_t battery_subscribe(nyx_device_handle_t handle,
+                              const nyx_battery_subscription_t *criteria,
+                              nyx_device_callback_function_t callback,
+                              void *context, uint32_t *id)
+{
+	nyx_battery_history_sample_t sample;
+
+	if (handle != nyxDev)
+	{
+		return NYX_ERROR_INVALID_HANDLE;
+	}
+
+	if (!criteria || !callback || !id)
+	{
+		return NYX_ERROR_INVALID_VALUE;
+	}
+
+	/* thresholds are crossed relative to the state at subscription */
+	battery_snapshot_begin();
+	battery_sample(&sample);
+	battery_snapshot_end();
+
+	*id = battery_subscription_add(criteria, callback, context, &sample);
+
+	return *id ? NYX_ERROR_NONE : NYX_ERROR_INVALID_VALUE;
+}
+
+nyx_error_t battery_unsubscribe(nyx_device_handle_t handle, uint32_t id)
+{
+	if (handle != nyxDev)
+	{
+		return NYX_ERROR_INVALID_HANDLE;
+	}
+
+	if (!battery_subscription_remove(id))
+	{
+		return NYX_ERROR_INVALID_VALUE;
+	}
+
+	return NYX_ERROR_NONE;
+}
@@ -0,0 +1,136 @@
+// Copyright (c) 2024 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+//
+// Cost of the battery query and uevent paths against a fake power_supply
+// tree: microseconds and file syscalls per call.
+//
+//     bench_battery_query [-n iterations] [-d parent directory]
+//
+// The tree is created in the parent directory (default $TMPDIR); use a
+// tmpfs such as /dev/shm to leave the disk out. Uevents are injected
+// straight into the battery listener, with coalescing off so that each one
+// is evaluated and calls back.
+//
+
+#include <glib.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <nyx/nyx_module.h>
+#include <nyx/module/nyx_utils.h>
+
+#undef nyx_debug
+#define nyx_debug(m, args...) {}
+
+// Pull in the code under test
+#include "../batterylib.c"
+#include "../battery.c"
+
+#include "../../utils/tests/bench_power_supply.h"
+
+static uint32_t callbacks = 0;
+
+static void count_callback(nyx_device_handle_t handle, nyx_callback_status_t status,
+                           void *context)
+{
+	callbacks++;
+}
+
+int main(int argc, char **argv)
+{
+	nyx_device_t device;
+	nyx_battery_status_t status;
+	power_supply_event_t event;
+	bench_counters_t start, end;
+	const char *parent = NULL;
+	gchar *class_dir;
+	int iterations = 10000;
+	int opt, i;
+
+	while ((opt = getopt(argc, argv, "n:d:")) != -1)
+	{
+		switch (opt)
+		{
+			case 'n':
+				iterations = atoi(optarg);
+				break;
+
+			case 'd':
+				parent = optarg;
+				break;
+
+			default:
+				fprintf(stderr, "usage: %s [-n iterations] [-d parent directory]\n", argv[0]);
+				return 1;
+		}
+	}
+
+	if (!(class_dir = bench_power_supply_create(parent)))
+	{
+		fprintf(stderr, "cannot create a power_supply tree\n");
+		return 1;
+	}
+
+	// what battery_init() does, without the udev monitor
+	power_supply_index_scan(class_dir);
+	detect_battery_sysfs_paths();
+	event_coalescer_init(&battery_events, 0, battery_flush_events, NULL);
+	battery_history_open(NULL, 0);
+	nyxDev = &device;
+	battery_callback = count_callback;
+
+	printf("%s, %d iterations\n", class_dir, iterations);
+
+	bench_counters_get(&start);
+
+	for (i = 0; i < iterations; i++)
+	{
+		battery_query_battery_status(nyxDev, &status);
+	}
+
+	bench_counters_get(&end);
+	bench_counters_report("battery_query_battery_status", iterations, &start, &end);
+
+	// every uevent changes the percentage, so each one calls back
+	memset(&event, 0, sizeof(event));
+	event.dev = (struct udev_device *) &device;     // never dereferenced by the listener
+	event.action = "change";
+	event.sysname = "battery";
+	event.has_values = power_supply_read_uevent(battery_sysfs_path, &event.values) == 0;
+
+	bench_counters_get(&start);
+
+	for (i = 0; i < iterations; i++)
+	{
+		event.values.value[POWER_SUPPLY_CAPACITY] = 50 + i % 2;
+		_handle_event(&event, NULL);
+	}
+
+	bench_counters_get(&end);
+	bench_counters_report("uevent to battery callback", iterations, &start, &end);
+
+	if (callbacks != (uint32_t) iterations)
+	{
+		printf("  %u callbacks for %d uevents\n", callbacks, iterations);
+	}
+
+	battery_cleanup();
+	power_supply_index_clear();
+	bench_power_supply_remove(class_dir);
+	return 0;
+}
@@ -0,0 +1,152 @@
+// Copyright (c) 2024 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+//
+// Maximum sustained rate of battery callbacks: replays a profile through the
+// simulated battery as fast as possible and counts the callbacks delivered.
+//
+//     bench_battery_simulator [-n steps] [-w coalescing window in ms]
+//
+// Every step changes the percentage, so without coalescing (-w 0, the
+// default here) each one is a callback; with a window the callbacks are
+// bounded by it whatever the event rate.
+//
+
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <nyx/nyx_module.h>
+#include <nyx/module/nyx_utils.h>
+
+#undef nyx_debug
+#define nyx_debug(m, args...) {}
+
+// externals defined in batterylib.c
+nyx_device_t *nyxDev = NULL;
+void *battery_callback_context = NULL;
+nyx_device_callback_function_t battery_callback = NULL;
+
+#include "../battery.c"
+
+static uint32_t callbacks = 0;
+
+// what a client does on every callback, like battery_read_status() in batterylib.c
+static void read_status(nyx_battery_status_t *state)
+{
+	battery_snapshot_begin();
+	state->present = battery_is_present();
+	state->percentage = battery_percent();
+	state->voltage = battery_voltage();
+	state->current = battery_current();
+	state->temperature = battery_temperature();
+	battery_snapshot_end();
+}
+
+static void count_callback(nyx_device_handle_t handle, nyx_callback_status_t status,
+                           void *context)
+{
+	nyx_battery_status_t state;
+
+	read_status(&state);
+	callbacks++;
+}
+
+int main(int argc, char **argv)
+{
+	const char *window = "0";
+	int steps = 10000;
+	gchar *path = NULL;
+	GString *profile;
+	uint32_t raw, delivered;
+	gint64 start;
+	double seconds;
+	int fd, opt, i;
+
+	while ((opt = getopt(argc, argv, "n:w:")) != -1)
+	{
+		switch (opt)
+		{
+			case 'n':
+				steps = atoi(optarg);
+				break;
+
+			case 'w':
+				window = optarg;
+				break;
+
+			default:
+				fprintf(stderr, "usage: %s [-n steps] [-w window ms]\n", argv[0]);
+				return 1;
+		}
+	}
+
+	if (steps < 2)
+	{
+		steps = 2;
+	}
+
+	profile = g_string_new("0 present=1 capacity=50 current_now=-400000 voltage_now=3900000 temp=250\n");
+
+	for (i = 1; i < steps; i++)
+	{
+		g_string_append_printf(profile, "%d capacity=%d%s\n", i * 10, 50 + i % 2,
+		                       i % 100 == 0 ? (i % 200 ? " plug" : " unplug") : "");
+	}
+
+	fd = g_file_open_tmp("bench_battery_simulator-XXXXXX", &path, NULL);
+
+	if (fd < 0 || write(fd, profile->str, profile->len) != (ssize_t)profile->len)
+	{
+		fprintf(stderr, "cannot write the profile\n");
+		return 1;
+	}
+
+	close(fd);
+	g_string_free(profile, TRUE);
+
+	setenv("NYX_BATTERY_SIMULATE", path, 1);
+	setenv("NYX_BATTERY_SIMULATE_SPEED", "0", 1);
+	setenv("NYX_POWER_SUPPLY_COALESCE_MS", window, 1);
+	battery_callback = count_callback;
+
+	if (battery_init() != NYX_ERROR_NONE)
+	{
+		fprintf(stderr, "cannot simulate the battery\n");
+		return 1;
+	}
+
+	start = g_get_monotonic_time();
+
+	while (battery_simulator_running() || event_coalescer_pending(&battery_events))
+	{
+		g_main_context_iteration(NULL, TRUE);
+	}
+
+	seconds = (g_get_monotonic_time() - start) / (double) G_USEC_PER_SEC;
+	battery_get_event_counters(&raw, &delivered);
+
+	printf("%d steps, coalescing window %s ms\n", steps, window);
+	printf("  events     %8u  %10.0f /s\n", raw, raw / seconds);
+	printf("  callbacks  %8u  %10.0f /s\n", callbacks, callbacks / seconds);
+
+	battery_deinit();
+	g_unlink(path);
+	g_free(path);
+	return 0;
+}
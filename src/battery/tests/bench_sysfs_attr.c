@@ -0,0 +1,139 @@
+// Copyright (c) 2024 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+//
+// Compares a read through sysfs_attr_read_int (one pread on a kept fd) with
+// nyx_utils_read_value (open, read, close) on the same attribute.
+//
+//     bench_sysfs_attr [-n reads] [attribute]
+//
+// e.g. bench_sysfs_attr /sys/class/power_supply/battery/capacity. Without an
+// attribute a temporary file is used, which leaves out the cost of the
+// driver's show() callback but not that of the path walk.
+//
+
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <nyx/module/nyx_utils.h>
+
+#include "utils.h"
+
+static double elapsed_ns(gint64 start, int reads)
+{
+	return (g_get_monotonic_time() - start) * 1000.0 / reads;
+}
+
+int main(int argc, char **argv)
+{
+	sysfs_attr_t attr = SYSFS_ATTR_INIT;
+	gchar *tmp_path = NULL;
+	const char *path;
+	int reads = 100000;
+	int32_t value;
+	int64_t sum_attr = 0, sum_utils = 0;
+	gint64 start;
+	double attr_ns, utils_ns;
+	int opt, i;
+
+	while ((opt = getopt(argc, argv, "n:")) != -1)
+	{
+		switch (opt)
+		{
+			case 'n':
+				reads = atoi(optarg);
+				break;
+
+			default:
+				fprintf(stderr, "usage: %s [-n reads] [attribute]\n", argv[0]);
+				return 1;
+		}
+	}
+
+	if (reads <= 0)
+	{
+		reads = 1;
+	}
+
+	if (optind < argc)
+	{
+		path = argv[optind];
+	}
+	else
+	{
+		int fd = g_file_open_tmp("bench_sysfs_attr-XXXXXX", &tmp_path, NULL);
+
+		if (fd < 0 || write(fd, "3950000\n", 8) != 8)
+		{
+			fprintf(stderr, "cannot create a temporary attribute\n");
+			return 1;
+		}
+
+		close(fd);
+		path = tmp_path;
+	}
+
+	snprintf(attr.path, SYSFS_ATTR_PATH_LEN, "%s", path);
+
+	if (sysfs_attr_read_int(&attr, &value) < 0)
+	{
+		fprintf(stderr, "%s: not a numeric attribute\n", path);
+		return 1;
+	}
+
+	start = g_get_monotonic_time();
+
+	for (i = 0; i < reads; i++)
+	{
+		sysfs_attr_read_int(&attr, &value);
+		sum_attr += value;
+	}
+
+	attr_ns = elapsed_ns(start, reads);
+
+	start = g_get_monotonic_time();
+
+	for (i = 0; i < reads; i++)
+	{
+		sum_utils += nyx_utils_read_value((char *)path);
+	}
+
+	utils_ns = elapsed_ns(start, reads);
+
+	printf("%s, %d reads\n", path, reads);
+	printf("  nyx_utils_read_value  %8.0f ns/read\n", utils_ns);
+	printf("  sysfs_attr_read_int   %8.0f ns/read  (%.1fx)\n", attr_ns,
+	       attr_ns > 0 ? utils_ns / attr_ns : 0.0);
+
+	if (sum_attr != sum_utils)
+	{
+		printf("  values differ: the attribute changed during the run\n");
+	}
+
+	sysfs_attr_close(&attr);
+
+	if (tmp_path)
+	{
+		g_unlink(tmp_path);
+		g_free(tmp_path);
+	}
+
+	return 0;
+}
@@ -0,0 +1,223 @@
+// Copyright (c) 2024 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <stdio.h>
+#include <sys/wait.h>
+
+#include <nyx/nyx_module.h>
+#include <nyx/module/nyx_utils.h>
+
+#undef nyx_info
+#define nyx_info(m, args...) {}
+#undef nyx_debug
+#define nyx_debug(m, args...) {}
+#undef nyx_error
+#define nyx_error(m, args...) {}
+
+// Pull in the unit under test
+#include "../battery_history.c"
+
+static void make_sample(nyx_battery_history_sample_t *sample, int64_t time, int percentage)
+{
+	memset(sample, 0, sizeof(*sample));
+	sample->time = time;
+	sample->percentage = percentage;
+	sample->voltage = 3876543;
+	sample->current = -1234567;
+	sample->temperature = 251;
+	sample->charging = true;
+	sample->present = true;
+}
+
+static gchar *history_path(void)
+{
+	gchar *dir = g_dir_make_tmp("battery-history-XXXXXX", NULL);
+	gchar *path;
+
+	g_assert(dir != NULL);
+	path = g_build_filename(dir, "history", NULL);
+	g_free(dir);
+	return path;
+}
+
+static void remove_history(gchar *path)
+{
+	gchar *dir = g_path_get_dirname(path);
+
+	g_unlink(path);
+	g_rmdir(dir);
+	g_free(dir);
+	g_free(path);
+}
+
+static void test_history_query(void)
+{
+	nyx_battery_history_sample_t sample, out[8];
+	int i;
+
+	battery_history_open(NULL, 16);
+
+	for (i = 0; i < 5; i++)
+	{
+		make_sample(&sample, 1000 + i * 60, 50 + i);
+		g_assert(battery_history_add(&sample));
+	}
+
+	g_assert_cmpuint(battery_history_query(1060, 1180, out, 8), ==, 3);
+	g_assert_cmpint(out[0].time, ==, 1060);
+	g_assert_cmpint(out[2].time, ==, 1180);
+	g_assert_cmpint(out[0].percentage, ==, 51);
+
+	/* stored at mV and mA resolution */
+	g_assert_cmpint(out[0].voltage, ==, 3876000);
+	g_assert_cmpint(out[0].current, ==, -1234000);
+	g_assert_cmpint(out[0].temperature, ==, 251);
+	g_assert(out[0].charging);
+	g_assert(out[0].present);
+
+	g_assert_cmpuint(battery_history_query(0, G_MAXINT64, out, 2), ==, 2);
+	g_assert_cmpint(out[1].time, ==, 1060);
+	g_assert_cmpuint(battery_history_query(2000, 3000, out, 8), ==, 0);
+
+	/* unchanged state is not stored again within the minimum spacing */
+	make_sample(&sample, 1245, 54);
+	g_assert(!battery_history_add(&sample));
+	make_sample(&sample, 1245, 53);
+	g_assert(battery_history_add(&sample));
+	g_assert_cmpint(battery_history_last_time(), ==, 1245);
+
+	battery_history_close();
+}
+
+static void test_history_wrap(void)
+{
+	nyx_battery_history_sample_t sample, out[8];
+	int i;
+
+	battery_history_open(NULL, 4);
+
+	for (i = 0; i < 10; i++)
+	{
+		make_sample(&sample, 1000 + i * 60, i);
+		battery_history_add(&sample);
+	}
+
+	g_assert_cmpuint(battery_history_query(0, G_MAXINT64, out, 8), ==, 4);
+
+	for (i = 0; i < 4; i++)
+	{
+		g_assert_cmpint(out[i].percentage, ==, 6 + i);
+	}
+
+	battery_history_close();
+}
+
+static void test_history_persist(void)
+{
+	gchar *path = history_path();
+	nyx_battery_history_sample_t sample, out[8];
+	FILE *file;
+
+	battery_history_open(path, 8);
+	g_assert(history_mapped);
+	make_sample(&sample, 1000, 80);
+	battery_history_add(&sample);
+	make_sample(&sample, 1060, 79);
+	battery_history_add(&sample);
+	battery_history_close();
+
+	battery_history_open(path, 8);
+	g_assert_cmpuint(battery_history_query(0, G_MAXINT64, out, 8), ==, 2);
+	g_assert_cmpint(out[1].percentage, ==, 79);
+	battery_history_close();
+
+	/* a file of another layout starts an empty history */
+	battery_history_open(path, 16);
+	g_assert_cmpuint(battery_history_query(0, G_MAXINT64, out, 8), ==, 0);
+	battery_history_close();
+
+	file = fopen(path, "r+");
+	g_assert(file != NULL);
+	fputs("garbage", file);
+	fclose(file);
+
+	battery_history_open(path, 16);
+	g_assert_cmpuint(battery_history_query(0, G_MAXINT64, out, 8), ==, 0);
+	battery_history_close();
+
+	remove_history(path);
+}
+
+static void test_history_second_owner(void)
+{
+	gchar *path = history_path();
+	nyx_battery_history_sample_t sample, out[8];
+	pid_t pid;
+	int status;
+
+	battery_history_open(path, 8);
+	g_assert(history_mapped);
+	make_sample(&sample, 1000, 80);
+	battery_history_add(&sample);
+
+	/* another process opening the same file must not write into the ring */
+	pid = fork();
+	g_assert(pid >= 0);
+
+	if (pid == 0)
+	{
+		battery_history_open(path, 8);
+
+		if (history_mapped || battery_history_query(0, G_MAXINT64, out, 8) != 0)
+		{
+			_exit(1);
+		}
+
+		make_sample(&sample, 1060, 10);
+		battery_history_add(&sample);
+		battery_history_add(&sample);
+		battery_history_close();
+		_exit(0);
+	}
+
+	g_assert_cmpint(waitpid(pid, &status, 0), ==, pid);
+	g_assert(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+
+	g_assert_cmpuint(battery_history_query(0, G_MAXINT64, out, 8), ==, 1);
+	g_assert_cmpint(out[0].percentage, ==, 80);
+	battery_history_close();
+
+	/* the lock goes with the owner */
+	battery_history_open(path, 8);
+	g_assert(history_mapped);
+	battery_history_close();
+
+	remove_history(path);
+}
+
+int main(int argc, char **argv)
+{
+	g_test_init(&argc, &argv, NULL);
+
+	g_test_add_func("/battery/history/query", test_history_query);
+	g_test_add_func("/battery/history/wrap", test_history_wrap);
+	g_test_add_func("/battery/history/persist", test_history_persist);
+	g_test_add_func("/battery/history/second_owner", test_history_second_owner);
+
+	return g_test_run();
+}
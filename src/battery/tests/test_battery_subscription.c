@@ -0,0 +1,141 @@
+// Copyright (c) 2024 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <stdio.h>
+
+#include <nyx/nyx_module.h>
+#include <nyx/module/nyx_utils.h>
+
+#undef nyx_info
+#define nyx_info(m, args...) {}
+#undef nyx_debug
+#define nyx_debug(m, args...) {}
+#undef nyx_error
+#define nyx_error(m, args...) {}
+
+
+// Pull in the unit under test
+#include "../battery_subscription.c"
+
+static int test_calls[2];
+
+static void test_callback(nyx_device_handle_t handle, nyx_callback_status_t status,
+                          void *context)
+{
+	g_assert(status == NYX_CALLBACK_STATUS_DONE);
+	test_calls[GPOINTER_TO_INT(context)]++;
+}
+
+static uint32_t test_unsubscribe_id = 0;
+
+static void unsubscribe_callback(nyx_device_handle_t handle, nyx_callback_status_t status,
+                                 void *context)
+{
+	test_calls[GPOINTER_TO_INT(context)]++;
+	battery_subscription_remove(test_unsubscribe_id);
+}
+
+static void make_sample(nyx_battery_history_sample_t *sample, int percentage,
+                        int voltage, int temperature, bool charging)
+{
+	memset(sample, 0, sizeof(*sample));
+	sample->present = true;
+	sample->percentage = percentage;
+	sample->voltage = voltage;
+	sample->temperature = temperature;
+	sample->charging = charging;
+}
+
+static void test_subscription_thresholds(void)
+{
+	nyx_battery_subscription_t steps = { .percentage_step = 5 };
+	nyx_battery_subscription_t bands = { .voltage_low = 3500000, .voltage_high = 4200000,
+	                                     .temperature_low = 0, .temperature_high = 450,
+	                                     .charging = true };
+	nyx_battery_history_sample_t sample;
+	int i;
+
+	memset(test_calls, 0, sizeof(test_calls));
+	make_sample(&sample, 52, 3800000, 250, false);
+	g_assert(battery_subscription_add(&steps, test_callback, GINT_TO_POINTER(0), &sample));
+	g_assert(battery_subscription_add(&bands, test_callback, GINT_TO_POINTER(1), &sample));
+
+	// Only crossing 50% and 45% calls the first listener
+	for (i = 51; i >= 40; i--)
+	{
+		make_sample(&sample, i, 3800000, 250, false);
+		battery_subscription_notify(NULL, &sample);
+	}
+
+	g_assert_cmpint(test_calls[0], ==, 2);
+	g_assert_cmpint(test_calls[1], ==, 0);
+
+	// Leaving and entering a band, and the charging transition
+	make_sample(&sample, 40, 3400000, 250, false);
+	g_assert_cmpuint(battery_subscription_notify(NULL, &sample), ==, 1);
+	make_sample(&sample, 40, 3450000, 250, false);
+	g_assert_cmpuint(battery_subscription_notify(NULL, &sample), ==, 0);
+	make_sample(&sample, 40, 3450000, 460, false);
+	g_assert_cmpuint(battery_subscription_notify(NULL, &sample), ==, 1);
+	make_sample(&sample, 40, 3450000, 460, true);
+	g_assert_cmpuint(battery_subscription_notify(NULL, &sample), ==, 1);
+	g_assert_cmpint(test_calls[1], ==, 3);
+	g_assert_cmpint(test_calls[0], ==, 2);
+
+	battery_subscription_clear();
+}
+
+static void test_subscription_remove(void)
+{
+	nyx_battery_subscription_t presence = { .presence = true };
+	nyx_battery_subscription_t none = { 0 };
+	nyx_battery_subscription_t inverted = { .voltage_low = 4000000, .voltage_high = 3000000 };
+	nyx_battery_history_sample_t sample;
+	uint32_t first, second;
+
+	memset(test_calls, 0, sizeof(test_calls));
+	make_sample(&sample, 50, 3800000, 250, false);
+	g_assert(!battery_subscription_add(&none, test_callback, NULL, &sample));
+	g_assert(!battery_subscription_add(&inverted, test_callback, NULL, &sample));
+
+	// The first listener removes the second one while being called
+	first = battery_subscription_add(&presence, unsubscribe_callback, GINT_TO_POINTER(0), &sample);
+	second = battery_subscription_add(&presence, test_callback, GINT_TO_POINTER(1), &sample);
+	g_assert(first && second && first != second);
+	test_unsubscribe_id = second;
+
+	sample.present = false;
+	g_assert_cmpuint(battery_subscription_notify(NULL, &sample), ==, 1);
+	g_assert_cmpint(test_calls[0], ==, 1);
+	g_assert_cmpint(test_calls[1], ==, 0);
+	g_assert(!battery_subscription_remove(second));
+
+	g_assert(battery_subscription_remove(first));
+	sample.present = true;
+	g_assert_cmpuint(battery_subscription_notify(NULL, &sample), ==, 0);
+}
+
+int main(int argc, char **argv)
+{
+	g_test_init(&argc, &argv, NULL);
+
+	g_test_add_func("/battery/subscription/thresholds", test_subscription_thresholds);
+	g_test_add_func("/battery/subscription/remove", test_subscription_remove);
+
+	return g_test_run();
+}
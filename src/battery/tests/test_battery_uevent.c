@@ -0,0 +1,614 @@
+// Copyright (c) 2014-2018 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <stdio.h>
+
+#include <nyx/nyx_module.h>
+#include <nyx/module/nyx_utils.h>
+
+#undef nyx_info
+#define nyx_info(m, args...) {}
+#undef nyx_debug
+#define nyx_debug(m, args...) {}
+#undef nyx_error
+#define nyx_error(m, args...) {}
+
+// mock out externals defined in batterylib.c
+nyx_device_t *nyxDev = NULL;
+void *battery_callback_context = NULL;
+nyx_device_callback_function_t battery_callback = NULL;
+
+// Pull in the unit under test
+#include "../battery.c"
+
+static gchar *test_dir = NULL;
+
+static void write_attr(const char *name, const char *contents)
+{
+	gchar *path = g_build_filename(test_dir, name, NULL);
+
+	g_assert(g_file_set_contents(path, contents, -1, NULL));
+	g_free(path);
+}
+
+static void remove_attr(const char *name)
+{
+	gchar *path = g_build_filename(test_dir, name, NULL);
+
+	g_unlink(path);
+	g_free(path);
+}
+
+static void setup_battery_dir(void)
+{
+	test_dir = g_dir_make_tmp("battery-XXXXXX", NULL);
+	g_assert(test_dir != NULL);
+
+	battery_sysfs_path = g_strdup(test_dir);
+	sysfs_attr_init(&batt_capacity, test_dir, "capacity");
+	sysfs_attr_init(&batt_energy_now, test_dir, "energy_now");
+	sysfs_attr_init(&batt_energy_full, test_dir, "energy_full");
+	sysfs_attr_init(&batt_charge_now, test_dir, "charge_now");
+	sysfs_attr_init(&batt_charge_full, test_dir, "charge_full");
+	sysfs_attr_init(&batt_charge_full_design, test_dir, "charge_full_design");
+	sysfs_attr_init(&batt_charge_counter, test_dir, "charge_counter");
+	sysfs_attr_init(&batt_temperature, test_dir, "temp");
+	sysfs_attr_init(&batt_voltage, test_dir, "voltage_now");
+	sysfs_attr_init(&batt_current, test_dir, "current_now");
+	sysfs_attr_init(&batt_present, test_dir, "present");
+	sysfs_attr_init(&batt_status, test_dir, "status");
+}
+
+static void teardown_battery_dir(void)
+{
+	const char *names[] = { "uevent", "charge_now", "charge_full", "capacity", "present" };
+	unsigned int i;
+
+	battery_cleanup();
+
+	for (i = 0; i < G_N_ELEMENTS(names); i++)
+	{
+		remove_attr(names[i]);
+	}
+
+	g_rmdir(test_dir);
+	g_free(test_dir);
+	test_dir = NULL;
+}
+
+static void test_power_supply_read_uevent(void)
+{
+	power_supply_uevent_t uevent;
+	sysfs_attr_t attr = SYSFS_ATTR_INIT;
+	int32_t value;
+
+	setup_battery_dir();
+	write_attr("uevent",
+	           "POWER_SUPPLY_NAME=battery\n"
+	           "POWER_SUPPLY_STATUS=Discharging\n"
+	           "POWER_SUPPLY_PRESENT=1\n"
+	           "POWER_SUPPLY_CAPACITY=87\n"
+	           "POWER_SUPPLY_CURRENT_NOW=-412000\n"
+	           "POWER_SUPPLY_TECHNOLOGY=Li-ion\n"
+	           "POWER_SUPPLY_TEMP=not-a-number\n");
+
+	g_assert(power_supply_read_uevent(test_dir, &uevent) == 0);
+	g_assert(strcmp(uevent.status, "Discharging") == 0);
+
+	g_assert(power_supply_uevent_get(&uevent, POWER_SUPPLY_CAPACITY, &value));
+	g_assert(value == 87);
+	g_assert(power_supply_uevent_get(&uevent, POWER_SUPPLY_CURRENT_NOW, &value));
+	g_assert(value == -412000);
+	g_assert(power_supply_uevent_get(&uevent, POWER_SUPPLY_PRESENT, NULL));
+
+	// Not reported, or not a number
+	g_assert(!power_supply_uevent_get(&uevent, POWER_SUPPLY_VOLTAGE_NOW, &value));
+	g_assert(!power_supply_uevent_get(&uevent, POWER_SUPPLY_TEMP, &value));
+	g_assert(uevent.usb_type[0] == '\0');
+
+	// The USB type in use, whether the others are listed or not
+	g_assert(power_supply_uevent_set(&uevent, "POWER_SUPPLY_USB_TYPE", "Unknown SDP [DCP] CDP"));
+	g_assert(strcmp(uevent.usb_type, "DCP") == 0);
+	g_assert(power_supply_uevent_set(&uevent, "POWER_SUPPLY_USB_TYPE", "PD"));
+	g_assert(strcmp(uevent.usb_type, "PD") == 0);
+
+	// Same values through a uevent attribute kept open
+	sysfs_attr_init(&attr, test_dir, "uevent");
+	g_assert(power_supply_read_uevent_attr(&attr, &uevent) == 0);
+	g_assert(power_supply_uevent_get(&uevent, POWER_SUPPLY_CAPACITY, &value));
+	g_assert(value == 87);
+	sysfs_attr_close(&attr);
+
+	remove_attr("uevent");
+	g_assert(power_supply_read_uevent(test_dir, &uevent) == -1);
+	g_assert(uevent.valid == 0);
+
+	teardown_battery_dir();
+}
+
+static void test_battery_snapshot_fallback(void)
+{
+	setup_battery_dir();
+	write_attr("uevent",
+	           "POWER_SUPPLY_PRESENT=1\n"
+	           "POWER_SUPPLY_CAPACITY=64\n"
+	           "POWER_SUPPLY_TEMP=312\n"
+	           "POWER_SUPPLY_VOLTAGE_NOW=3950000\n"
+	           "POWER_SUPPLY_CURRENT_NOW=250000\n"
+	           "POWER_SUPPLY_CHARGE_FULL=2800000\n");
+	write_attr("charge_now", "1500000\n");
+	write_attr("capacity", "1\n");
+
+	battery_snapshot_begin();
+
+	g_assert(battery_is_present());
+	g_assert(battery_percent() == 64);
+	g_assert(battery_temperature() == 312);
+	g_assert(battery_voltage() == 3950000);
+	g_assert(battery_current() == 250000);
+	g_assert(battery_full40() == 2800.0);
+	g_assert(batt_capacity.fd < 0);
+
+	// Missing from the uevent: read from its own attribute
+	g_assert(battery_coulomb() == 1500.0);
+	g_assert(batt_charge_now.fd >= 0);
+
+	battery_snapshot_end();
+
+	// Outside a snapshot every value is read from its attribute again
+	g_assert(battery_percent() == 1);
+	g_assert(batt_capacity.fd >= 0);
+
+	teardown_battery_dir();
+}
+
+static void test_sysfs_attr_read(void)
+{
+	sysfs_attr_t attr = SYSFS_ATTR_INIT;
+	char buf[16];
+	int32_t value;
+
+	setup_battery_dir();
+
+	// Not there yet: fails, and succeeds once the attribute appears
+	sysfs_attr_init(&attr, test_dir, "charge_now");
+	g_assert(!sysfs_attr_exists(&attr));
+	g_assert(sysfs_attr_read_int(&attr, &value) == -1);
+
+	write_attr("charge_now", "-1234 \n");
+	g_assert(sysfs_attr_exists(&attr));
+	g_assert(sysfs_attr_read_int(&attr, &value) == 0);
+	g_assert(value == -1234);
+
+	// Every read sees the value from the start of the attribute
+	g_assert(sysfs_attr_read_int(&attr, &value) == 0);
+	g_assert(value == -1234);
+	g_assert(sysfs_attr_read(&attr, buf, sizeof(buf)) == 5);
+	g_assert(strcmp(buf, "-1234") == 0);
+
+	sysfs_attr_close(&attr);
+	g_assert(attr.fd == -1);
+
+	write_attr("charge_now", "Charging\n");
+	g_assert(sysfs_attr_read(&attr, buf, sizeof(buf)) == 8);
+	g_assert(strcmp(buf, "Charging") == 0);
+	g_assert(sysfs_attr_read_int(&attr, &value) == -1);
+	sysfs_attr_close(&attr);
+
+	// Events name their supply by the last component of its directory
+	sysfs_attr_init(&attr, "/sys/class/power_supply/battery", "present");
+	g_assert(sysfs_attr_of_supply(&attr, "battery"));
+	g_assert(!sysfs_attr_of_supply(&attr, "batt"));
+	g_assert(!sysfs_attr_of_supply(&attr, "battery0"));
+	g_assert(!sysfs_attr_of_supply(&attr, "present"));
+
+	// An unset attribute never opens anything
+	sysfs_attr_init(&attr, NULL, "charge_now");
+	g_assert(!sysfs_attr_exists(&attr));
+	g_assert(!sysfs_attr_of_supply(&attr, "battery"));
+	g_assert(attr.fd == -1);
+
+	teardown_battery_dir();
+}
+
+static void make_supply(const char *class_dir, const char *name, const char *type)
+{
+	gchar *dir = g_build_filename(class_dir, name, NULL);
+	gchar *path = g_build_filename(dir, "type", NULL);
+
+	g_assert(g_mkdir_with_parents(dir, 0755) == 0);
+	g_assert(g_file_set_contents(path, type, -1, NULL));
+	g_free(path);
+	g_free(dir);
+}
+
+static void remove_supply(const char *class_dir, const char *name)
+{
+	gchar *dir = g_build_filename(class_dir, name, NULL);
+	gchar *path = g_build_filename(dir, "type", NULL);
+
+	g_unlink(path);
+	g_rmdir(dir);
+	g_free(path);
+	g_free(dir);
+}
+
+static void test_power_supply_index(void)
+{
+	const char *names[] = { "bq27000", "usb", "ac", "ac2" };
+	gchar *class_dir = g_dir_make_tmp("power_supply-XXXXXX", NULL);
+	gchar *expected;
+	unsigned int i;
+
+	make_supply(class_dir, "bq27000", "Battery\n");
+	make_supply(class_dir, "usb", "USB\n");
+	make_supply(class_dir, "ac", "Mains\n");
+	make_supply(class_dir, "ac2", "Mains\n");
+
+	power_supply_index_scan(class_dir);
+
+	expected = g_build_filename(class_dir, "bq27000", NULL);
+	g_assert(g_strcmp0(power_supply_path_by_type("Battery"), expected) == 0);
+	g_assert(g_strcmp0(power_supply_path_by_name("bq27000"), expected) == 0);
+	g_free(expected);
+
+	expected = g_build_filename(class_dir, "usb", NULL);
+	g_assert(g_strcmp0(power_supply_path_by_type("USB"), expected) == 0);
+	g_free(expected);
+
+	// Either one of the two, but always one of them
+	g_assert(power_supply_path_by_type("Mains") != NULL);
+	g_assert(power_supply_path_by_name("ac2") != NULL);
+	g_assert(power_supply_path_by_type("Wireless") == NULL);
+	g_assert(power_supply_path_by_name("battery") == NULL);
+
+	// The index is not rescanned behind the caller's back
+	remove_supply(class_dir, "usb");
+	g_assert(power_supply_path_by_type("USB") != NULL);
+	power_supply_index_scan(class_dir);
+	g_assert(power_supply_path_by_type("USB") == NULL);
+
+	power_supply_index_clear();
+
+	for (i = 0; i < G_N_ELEMENTS(names); i++)
+	{
+		remove_supply(class_dir, names[i]);
+	}
+
+	g_rmdir(class_dir);
+	g_free(class_dir);
+}
+
+static int test_flush_count = 0;
+
+static bool count_flush(void *data)
+{
+	test_flush_count++;
+	return test_flush_count == 1;
+}
+
+static void run_until_flushed(event_coalescer_t *coalescer)
+{
+	gint64 deadline = g_get_monotonic_time() + G_USEC_PER_SEC;
+
+	while (event_coalescer_pending(coalescer) && g_get_monotonic_time() < deadline)
+	{
+		g_main_context_iteration(NULL, TRUE);
+	}
+}
+
+static void test_event_coalescer(void)
+{
+	event_coalescer_t coalescer = { 0 };
+	int i;
+
+	// A burst is evaluated once, when its window is over
+	event_coalescer_init(&coalescer, 20, count_flush, NULL);
+
+	for (i = 0; i < 5; i++)
+	{
+		event_coalescer_push(&coalescer);
+	}
+
+	g_assert(event_coalescer_pending(&coalescer));
+	g_assert(test_flush_count == 0);
+
+	run_until_flushed(&coalescer);
+	g_assert(test_flush_count == 1);
+	g_assert(coalescer.raw_events == 5);
+	g_assert(coalescer.evaluations == 1);
+	g_assert(coalescer.delivered == 1);
+
+	// The next event opens a new window
+	event_coalescer_push(&coalescer);
+	run_until_flushed(&coalescer);
+	g_assert(test_flush_count == 2);
+	g_assert(coalescer.evaluations == 2);
+	g_assert(coalescer.delivered == 1);
+
+	// A cancelled window is never evaluated
+	event_coalescer_push(&coalescer);
+	event_coalescer_cancel(&coalescer);
+	g_assert(!event_coalescer_pending(&coalescer));
+	g_assert(test_flush_count == 2);
+
+	// Without a window every event is evaluated at once
+	event_coalescer_init(&coalescer, 0, count_flush, NULL);
+	event_coalescer_push(&coalescer);
+	event_coalescer_push(&coalescer);
+	g_assert(!event_coalescer_pending(&coalescer));
+	g_assert(test_flush_count == 4);
+	g_assert(coalescer.evaluations == 2);
+}
+
+static void test_battery_flush_events(void)
+{
+	uint32_t raw, delivered;
+
+	setup_battery_dir();
+	write_attr("capacity", "10\n");
+	event_coalescer_init(&battery_events, 20, battery_flush_events, NULL);
+	current_battery_present = true;
+	current_battery_percentage = 10;
+
+	// Only the last uevent of a burst is evaluated
+	g_assert(power_supply_uevent_set(&battery_event, "POWER_SUPPLY_PRESENT", "1"));
+	g_assert(power_supply_uevent_set(&battery_event, "POWER_SUPPLY_CAPACITY", "11"));
+	battery_event_valid = true;
+	event_coalescer_push(&battery_events);
+	g_assert(power_supply_uevent_set(&battery_event, "POWER_SUPPLY_CAPACITY", "12"));
+	event_coalescer_push(&battery_events);
+
+	run_until_flushed(&battery_events);
+	g_assert(current_battery_percentage == 12);
+	g_assert(!battery_event_valid);
+
+	battery_get_event_counters(&raw, &delivered);
+	g_assert(raw == 2);
+	// No battery callback is registered
+	g_assert(delivered == 0);
+	g_assert(battery_events.evaluations == 1);
+
+	teardown_battery_dir();
+}
+
+static void write_battery_uevent(const char *status, const char *current)
+{
+	gchar *contents = g_strdup_printf("POWER_SUPPLY_STATUS=%s\n"
+	                                  "POWER_SUPPLY_PRESENT=1\n"
+	                                  "POWER_SUPPLY_CURRENT_NOW=%s\n"
+	                                  "POWER_SUPPLY_CHARGE_NOW=1000000\n"
+	                                  "POWER_SUPPLY_CHARGE_FULL=2000000\n"
+	                                  "POWER_SUPPLY_CHARGE_FULL_DESIGN=2500000\n",
+	                                  status, current);
+
+	write_attr("uevent", contents);
+	g_free(contents);
+}
+
+static void test_battery_estimate(void)
+{
+	nyx_battery_estimate_t estimate;
+
+	setup_battery_dir();
+
+	// The first sample starts the average
+	write_battery_uevent("Discharging", "-500000");
+	battery_snapshot_begin();
+	battery_estimate_update();
+	battery_get_estimate(&estimate);
+	g_assert(!estimate.charging);
+	g_assert(estimate.avg_current == -500000);
+	g_assert(estimate.time_to_empty == 7200);
+	g_assert(estimate.time_to_full == -1);
+	g_assert(battery_age() == 80.0);
+	g_assert(battery_rawcoulomb() == 1000.0);
+	battery_snapshot_end();
+
+	// A sample one time constant later moves it half way
+	current_ewma_time -= BATTERY_CURRENT_EWMA_TAU_S * G_USEC_PER_SEC;
+	write_battery_uevent("Discharging", "-300000");
+	battery_snapshot_begin();
+	battery_estimate_update();
+	g_assert(battery_avg_current() <= -399000 && battery_avg_current() >= -400000);
+	g_assert(battery_current() == -300000);
+	battery_snapshot_end();
+
+	// Plugging in restarts it
+	write_battery_uevent("Charging", "1000000");
+	battery_snapshot_begin();
+	battery_estimate_update();
+	battery_get_estimate(&estimate);
+	g_assert(estimate.charging);
+	g_assert(estimate.avg_current == 1000000);
+	g_assert(estimate.time_to_empty == -1);
+	g_assert(estimate.time_to_full == 3600);
+	battery_snapshot_end();
+
+	write_battery_uevent("Full", "0");
+	battery_snapshot_begin();
+	battery_estimate_update();
+	battery_get_estimate(&estimate);
+	g_assert(!estimate.charging);
+	g_assert(estimate.time_to_full == 0);
+	battery_snapshot_end();
+
+	teardown_battery_dir();
+	g_assert(battery_avg_current() == -1);
+}
+
+static void test_battery_sample(void)
+{
+	nyx_battery_history_sample_t sample;
+	int64_t now = g_get_real_time() / G_USEC_PER_SEC;
+
+	setup_battery_dir();
+	battery_history_open(NULL, 8);
+
+	// The status says whether it charges, whatever the sign of the current
+	write_battery_uevent("Charging", "-20000");
+	battery_snapshot_begin();
+	battery_sample(&sample);
+	battery_snapshot_end();
+	g_assert(sample.charging);
+	g_assert(sample.current == -20000);
+
+	write_battery_uevent("Full", "15000");
+	battery_snapshot_begin();
+	battery_sample(&sample);
+	battery_snapshot_end();
+	g_assert(!sample.charging);
+
+	// A newest sample from the future does not hold off the periodic one
+	sample.time = now + 3600;
+	g_assert(battery_history_add(&sample));
+	battery_sample_timer_cb(NULL);
+	g_assert(battery_history_last_time() >= now && battery_history_last_time() <= now + 60);
+
+	teardown_battery_dir();
+}
+
+static int test_callbacks = 0;
+
+static void count_callback(nyx_device_handle_t handle, nyx_callback_status_t status,
+                           void *context)
+{
+	test_callbacks++;
+}
+
+static void test_battery_simulator(void)
+{
+	gchar *profile, *bad;
+
+	setup_battery_dir();
+	profile = g_build_filename(test_dir, "profile", NULL);
+	bad = g_build_filename(test_dir, "bad", NULL);
+	g_assert(g_file_set_contents(profile,
+	                             "# ms attribute=value\n"
+	                             "0 present=1 capacity=80 current_now=-450000 voltage_now=3912000 temp=251\n"
+	                             "10 capacity=79\n"
+	                             "20 voltage_now=3905000\n"
+	                             "\n"
+	                             "30 plug current_now=1200000 capacity=80\n", -1, NULL));
+
+	// Invalid profiles are refused
+	g_assert(!battery_simulator_start("/nonexistent", 0, 1, battery_push_event));
+	write_attr("bad", "0 capacity=80\n10 capacity\n");
+	g_assert(!battery_simulator_start(bad, 0, 1, battery_push_event));
+	write_attr("bad", "10 capacity=80\n0 capacity=79\n");
+	g_assert(!battery_simulator_start(bad, 0, 1, battery_push_event));
+	g_assert(battery_simulator_state() == NULL);
+
+	// The first step is the initial state, read like a snapshot
+	event_coalescer_init(&battery_events, 0, battery_flush_events, NULL);
+	g_assert(battery_simulator_start(profile, 0, 2, battery_push_event));
+	battery_snapshot_begin();
+	g_assert(battery_percent() == 80);
+	g_assert(battery_temperature() == 251);
+	battery_snapshot_end();
+	current_battery_present = true;
+	current_battery_percentage = 80;
+
+	battery_callback = count_callback;
+
+	while (battery_simulator_running())
+	{
+		g_main_context_iteration(NULL, TRUE);
+	}
+
+	battery_callback = NULL;
+
+	// 79, 79 (voltage only), 80 and in the second loop 80 (no change), 79, 79, 80
+	g_assert_cmpint(battery_events.raw_events, ==, 7);
+	g_assert_cmpint(test_callbacks, ==, 4);
+	g_assert(strcmp(battery_simulator_state()->status, "Charging") == 0);
+	battery_snapshot_begin();
+	g_assert(battery_current() == 1200000);
+	battery_snapshot_end();
+
+	g_unlink(profile);
+	g_unlink(bad);
+	g_free(profile);
+	g_free(bad);
+	teardown_battery_dir();
+	g_assert(battery_simulator_state() == NULL);
+}
+
+static void push_battery_status(const char *status, const char *current)
+{
+	g_assert(power_supply_uevent_set(&battery_event, "POWER_SUPPLY_PRESENT", "1"));
+	g_assert(power_supply_uevent_set(&battery_event, "POWER_SUPPLY_STATUS", status));
+	g_assert(power_supply_uevent_set(&battery_event, "POWER_SUPPLY_CURRENT_NOW", current));
+	battery_event_valid = true;
+	event_coalescer_push(&battery_events);
+	run_until_flushed(&battery_events);
+}
+
+static void test_battery_subscription_status(void)
+{
+	nyx_battery_subscription_t criteria = { .charging = true };
+	nyx_battery_history_sample_t sample;
+
+	setup_battery_dir();
+	write_attr("capacity", "10\n");
+	battery_history_open(NULL, 8);
+	event_coalescer_init(&battery_events, 20, battery_flush_events, NULL);
+	current_battery_present = true;
+	current_battery_percentage = 10;
+
+	write_battery_uevent("Discharging", "-20000");
+	battery_snapshot_begin();
+	battery_sample(&sample);
+	battery_snapshot_end();
+	g_assert(battery_subscription_add(&criteria, count_callback, NULL, &sample) != 0);
+	test_callbacks = 0;
+
+	// A weak charger: the status flips while the current stays negative
+	push_battery_status("Charging", "-20000");
+	g_assert_cmpint(test_callbacks, ==, 1);
+
+	push_battery_status("Charging", "-25000");
+	g_assert_cmpint(test_callbacks, ==, 1);
+
+	push_battery_status("Discharging", "-25000");
+	g_assert_cmpint(test_callbacks, ==, 2);
+
+	// Neither does noise on the current change it
+	push_battery_status("Discharging", "5000");
+	g_assert_cmpint(test_callbacks, ==, 2);
+
+	teardown_battery_dir();
+}
+
+int main(int argc, char **argv)
+{
+	g_test_init(&argc, &argv, NULL);
+
+	g_test_add_func("/battery/uevent/read", test_power_supply_read_uevent);
+	g_test_add_func("/battery/uevent/snapshot_fallback", test_battery_snapshot_fallback);
+	g_test_add_func("/battery/sysfs_attr/read", test_sysfs_attr_read);
+	g_test_add_func("/battery/uevent/coalescer", test_event_coalescer);
+	g_test_add_func("/battery/power_supply/index", test_power_supply_index);
+	g_test_add_func("/battery/uevent/flush_events", test_battery_flush_events);
+	g_test_add_func("/battery/estimate", test_battery_estimate);
+	g_test_add_func("/battery/sample", test_battery_sample);
+	g_test_add_func("/battery/simulator", test_battery_simulator);
+	g_test_add_func("/battery/subscription/status", test_battery_subscription_status);
+
+	return g_test_run();
+}
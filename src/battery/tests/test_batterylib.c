@@ -100,6 +100,20 @@ double test_battery_age_retval = 99.21875;
 bool test_battery_is_present_retval = true;
 
 // Mock the battery.c functions (from battery_read.h)
+int test_battery_snapshot_depth = 0;
+int test_battery_snapshot_count = 0;
+
+void battery_snapshot_begin(void)
+{
+	test_battery_snapshot_depth++;
+	test_battery_snapshot_count++;
+}
+
+void battery_snapshot_end(void)
+{
+	test_battery_snapshot_depth--;
+}
+
 int battery_percent(void)
 {
 	return test_battery_percent_retval;
@@ -150,6 +164,39 @@ bool battery_is_present(void)
 	return test_battery_is_present_retval;
 }
 
+void battery_get_estimate(nyx_battery_estimate_t *estimate)
+{
+	estimate->avg_current = test_battery_avg_current_retval;
+	estimate->charging = test_battery_avg_current_retval > 0;
+	estimate->time_to_empty = -1;
+	estimate->time_to_full = -1;
+}
+
+uint32_t battery_history_query(int64_t from, int64_t to,
+                               nyx_battery_history_sample_t *samples, uint32_t max)
+{
+	return 0;
+}
+
+void battery_sample(nyx_battery_history_sample_t *sample)
+{
+	memset(sample, 0, sizeof(nyx_battery_history_sample_t));
+	sample->present = test_battery_is_present_retval;
+	sample->percentage = test_battery_percent_retval;
+}
+
+uint32_t battery_subscription_add(const nyx_battery_subscription_t *criteria,
+                                  nyx_device_callback_function_t callback, void *context,
+                                  const nyx_battery_history_sample_t *sample)
+{
+	return 1;
+}
+
+bool battery_subscription_remove(uint32_t id)
+{
+	return id == 1;
+}
+
 bool battery_is_authenticated(const char *pair_challenge,
                               const char *pair_response)
 {
@@ -167,6 +214,16 @@ void battery_set_wakeup_percent(int percentage)
 	return;
 }
 
+void battery_set_fakemode(bool enable)
+{
+	return;
+}
+
+nyx_error_t battery_get_fakemode(bool *enable)
+{
+	return NYX_ERROR_NONE;
+}
+
 #define CHARGE_MIN_TEMPERATURE_C 0
 #define CHARGE_MAX_TEMPERATURE_C 57
 #define BATTERY_MAX_TEMPERATURE_C  60
@@ -336,9 +393,14 @@ static void test_battery_query_battery_status(api_test_fixture *fixture,
 
 	// Check for no error
 	resetTestBatteryStatus(&testBatteryStatus);
+	test_battery_snapshot_count = 0;
 	g_assert_true(NYX_ERROR_NONE == battery_query_battery_status(
 	                  fixture->fixture_device, &testBatteryStatus));
 
+	// All values come from one snapshot, which is released again
+	g_assert_true(test_battery_snapshot_count == 1);
+	g_assert_true(test_battery_snapshot_depth == 0);
+
 	// Check to make sure values returned have changed:
 	g_assert_true(testBatteryStatus.present != init_present);
 	g_assert_true(testBatteryStatus.charging != init_charging);
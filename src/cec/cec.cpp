@@ -88,9 +88,8 @@ nyx_error_t nyx_module_open(nyx_instance_t i, nyx_device_t **d)
     *d = (nyx_device_t *)nyx_dev;
 
     nyx_debug("Called CEC init");
+    // cec-client starts and scans the bus in the background
     CecHandler::getInst().init();
-    CecHandler::getInst().addRequest("internalScan", "scan");
-    CecHandler::getInst().getResponse();
     return NYX_ERROR_NONE;
 }
 
@@ -111,7 +110,7 @@ nyx_error_t nyx_module_close(nyx_device_handle_t d)
     }
 
     nyx_debug("Called CEC deinit");
-    CecHandler::getInst().addRequest("sendCommand", "q");
+    CecHandler::getInst().sendRequest("sendCommand", "q");
     CecHandler::getInst().deinit();
 
     return NYX_ERROR_NONE;
@@ -218,8 +217,7 @@ nyx_error_t cec_send_command(nyx_device_handle_t handle, nyx_cec_command_t *comm
             return NYX_ERROR_NOT_IMPLEMENTED;
         if (!cmd.empty())
         {
-            CecHandler::getInst().addRequest(cmdType, cmd);
-            response = CecHandler::getInst().getResponse();
+            response = CecHandler::getInst().sendRequest(cmdType, cmd);
         if(response.empty())
         response.push_back("response: success");
     }
@@ -240,6 +238,9 @@ nyx_error_t cec_get_physical_address(nyx_device_handle_t handle, char **address)
 
     nyx_debug("Called CEC physical_address");
 
+    if (CecHandler::getInst().isScanPending())
+        return NYX_ERROR_DEVICE_UNAVAILABLE;
+
     std::string addr = CecHandler::getInst().getAddress();
     strcpy(*address, addr.c_str());
     return NYX_ERROR_NONE;
@@ -263,6 +264,10 @@ nyx_error_t cec_get_config(nyx_device_handle_t handle, char *type, char **value)
     nyx_debug("Called CEC get_config");
     std::string cmdType = type;
     std::string resp;
+    // Only the adapter details are known before the initial scan is done
+    if (cmdType != "vendorId" && cmdType != "logicalAddress" &&
+        CecHandler::getInst().isScanPending())
+        return NYX_ERROR_DEVICE_UNAVAILABLE;
     if(cmdType == "version")
         resp = CecHandler::getInst().getVersion();
     else if(cmdType == "vendorId")
@@ -298,6 +303,9 @@ nyx_error_t cec_get_version(nyx_device_handle_t handle, char **version)
 
     nyx_debug("Called CEC get_config");
 
+    if (CecHandler::getInst().isScanPending())
+        return NYX_ERROR_DEVICE_UNAVAILABLE;
+
     std::string ver = CecHandler::getInst().getVersion();
     strcpy(*version, ver.c_str());
 
@@ -22,6 +22,7 @@
 #include "cec_operation.h"
 #include <sstream>
 #include <stdio.h>
+#include <signal.h>
 
 int fd1[2], fd2[2];
 std::string trim(std::string str)
@@ -37,7 +38,42 @@ std::string trim(std::string str)
     return res;
 }
 
-CecHandler::CecHandler() : runFlag(true), reqProcFlag(false), respReadyFlag(false)
+// How long cec-client may take to answer a command
+static std::chrono::milliseconds responseTimeout(const std::string &cmd)
+{
+    if (cmd == "scan" || cmd == "internalScan")
+        return std::chrono::milliseconds(10000);
+    return std::chrono::milliseconds(5000);
+}
+
+// What the answer of cec-client to a command ends with: a line that contains
+// the returned text; nullptr for commands that are done once they are written
+static const char *replyMarker(const std::string &cmd)
+{
+    static const std::map<std::string, const char *> markers = {
+        {"scan", "currently active source:"},
+        {"pow", "power status:"},
+        {"ven", "vendor id:"},
+        {"ver", "CEC version"},
+        {"name", "OSD name"},
+        {"lang", "menu language"},
+        {"ad", "logical address"},
+        {"volup", "volume up:"},
+        {"voldown", "volume down:"},
+        {"mute", "mute:"},
+    };
+    auto it = markers.find(cmd.substr(0, cmd.find(' ')));
+    return it == markers.end() ? nullptr : it->second;
+}
+
+// How long cec-client may take to print its ready banner
+static const std::chrono::milliseconds readyTimeout(5000);
+
+// How long cec-client may take to quit before it is terminated
+static const std::chrono::milliseconds quitTimeout(1000);
+
+CecHandler::CecHandler() : mChildPid(0), runFlag(true), reqProcFlag(false), respReadyFlag(false),
+    readyFlag(false), scanPending(false)
 {
 }
 
@@ -55,20 +91,71 @@ CecHandler& CecHandler::getInst()
 void CecHandler::init()
 {
     runFlag = true;
-    parseConfigData(executeSingleCommand("cec-client -l"));
+    parseConfigData(executeSingleCommand(std::string(EXE_NAME) + " -l"));
+    {
+        std::lock_guard<std::mutex> lock(respMutex);
+        readyFlag = false;
+        scanPending = true;
+        readyDeadline = std::chrono::steady_clock::now() + readyTimeout;
+    }
     mProcThread = std::thread(std::bind(&CecHandler::cmdDispatcher, this));
-    //Waiting for 5 secs to initialise the child process
-    sleep(5);
-    mProcThread.detach();
+    // The child process is ready when it says so; until the scan is done the
+    // values it reports are pending
+    mScanThread = std::thread(std::bind(&CecHandler::initialScan, this));
 }
 
 void CecHandler::deinit()
 {
-    runFlag = false;
+    {
+        std::unique_lock<std::mutex> lock(respMutex);
+        runFlag = false;
+        respCond.notify_all();
+        // cec-client quits on the "q" of nyx_module_close(); one that does not
+        // is terminated, so that no part of this session outlives it
+        if (!respCond.wait_for(lock, quitTimeout, [this] { return mChildPid == 0; }))
+            kill(mChildPid, SIGTERM);
+    }
     if (mProcThread.joinable())
     {
         mProcThread.join();
     }
+    if (mScanThread.joinable())
+    {
+        mScanThread.join();
+    }
+}
+
+void CecHandler::initialScan()
+{
+    sendRequest("internalScan", "scan");
+    std::lock_guard<std::mutex> lock(respMutex);
+    scanPending = false;
+}
+
+bool CecHandler::isScanPending()
+{
+    std::lock_guard<std::mutex> lock(respMutex);
+    return scanPending;
+}
+
+// Wait for the ready banner of cec-client; without one, go on at the deadline
+bool CecHandler::waitReady()
+{
+    std::unique_lock<std::mutex> lock(respMutex);
+    respCond.wait_until(lock, readyDeadline, [this] { return readyFlag || !runFlag; });
+    readyFlag = true;
+    return runFlag;
+}
+
+std::vector<std::string> CecHandler::sendRequest(std::string name, std::string cmd)
+{
+    if (!waitReady())
+        return std::vector<std::string>();
+    std::lock_guard<std::mutex> lock(reqMutex);
+    if (!runFlag)
+        return std::vector<std::string>();
+    addRequest(name, cmd);
+    return getResponse();
 }
 
 std::vector<std::string> CecHandler::executeSingleCommand(std::string cmd)
@@ -115,13 +202,14 @@ void CecHandler::cmdDispatcher()
     pid_t pid;
     if (pipe(fd1) < 0 || pipe(fd2) < 0) return;
     signal(SIGHUP, SIG_IGN);
-    if ((pid = fork()) > 0)
     {
-        std::thread t1(std::bind(&CecHandler::responseHandler, this));
-        wait(NULL);
-        t1.join();
+        // A session closed before it got here starts no cec-client
+        std::lock_guard<std::mutex> lock(respMutex);
+        pid = runFlag ? fork() : -1;
+        if (pid > 0)
+            mChildPid = pid;
     }
-    else
+    if (pid == 0)
     {
         // Child
         dup2(fd1[0], 0);
@@ -129,27 +217,49 @@ void CecHandler::cmdDispatcher()
         close(fd1[1]);
         close(fd2[0]);
         execl(EXE_NAME, EXE_NAME, "-d", "1", "-o", "webOS-CEC", NULL);
+        _exit(1);
+    }
+    close(fd1[0]);
+    // Without a child the reader sees the end of the output right away
+    std::thread t1(std::bind(&CecHandler::responseHandler, this));
+    if (pid > 0)
+    {
+        // Wait without reaping, so that deinit() never signals a recycled pid
+        siginfo_t info;
+        waitid(P_PID, pid, &info, WEXITED | WNOWAIT);
+        {
+            std::lock_guard<std::mutex> lock(respMutex);
+            mChildPid = 0;
+        }
+        respCond.notify_all();
+        waitpid(pid, NULL, 0);
     }
+    t1.join();
+    {
+        std::lock_guard<std::mutex> lock(reqMutex);
+        close(fd1[1]);
+        fd1[1] = -1;
+    }
+    close(fd2[0]);
 }
 
 std::vector<std::string> CecHandler::getResponse()
 {
-    int maxRetry = 25;
-    if (cmdName == "scan" || cmdName == "internalScan")
-         maxRetry = 50;
-    while (!respReadyFlag)
+    std::vector<std::string> response;
+    std::string name;
     {
-        std::this_thread::sleep_for(std::chrono::milliseconds(200));
-        maxRetry--;
-        if (maxRetry == 0) break;
+        // responseHandler wakes us up as soon as cec-client has answered
+        std::unique_lock<std::mutex> lock(respMutex);
+        respCond.wait_until(lock, respDeadline, [this] { return respReadyFlag || !runFlag; });
+        respReadyFlag = false;
+        reqProcFlag = false;
+        response.swap(resp);
+        name = cmdName;
     }
-    respReadyFlag = false;
-    reqProcFlag = false;
-    std::vector<std::string> response = resp;
-    resp.clear();
-    if (cmdName == "scan" || cmdName == "internalScan")
+    if (name == "scan" || name == "internalScan")
     {
-        for (std::size_t i=0; i<response.size(); ++i)
+        std::lock_guard<std::mutex> lock(respMutex);
+        for (std::size_t i=0; i+7<response.size(); ++i)
         {
             if (response[i].find("device #" + deviceNum + ":") != std::string::npos)
             {
@@ -173,29 +283,63 @@ void CecHandler::responseHandler()
 {
     dup2(fd2[0], 0);
     close(fd2[1]);
+    // Left at end of file by the cec-client of an earlier session
+    clearerr(stdin);
+    std::cin.clear();
     std::string str;
     while(std::getline(std::cin, str))
     {
-       if (reqProcFlag)
-          resp.push_back(trim(str));
-       if (cmdName == "scan" || cmdName == "internalScan")
+       bool ready = false;
        {
-           if (str.find("currently active source:") != std::string::npos) respReadyFlag = true;
+           std::lock_guard<std::mutex> lock(respMutex);
+           if (reqProcFlag && !respReadyFlag)
+           {
+               // A scan answers with a report, anything else with one line;
+               // log and bus traffic in between is not part of the answer
+               const char *marker = replyMarker(cmdName);
+               ready = marker && str.find(marker) != std::string::npos;
+               if (ready || cmdName == "scan")
+                  resp.push_back(trim(str));
+               respReadyFlag = ready;
+           }
+           if (!readyFlag && str.find(EXE_READY_BANNER) != std::string::npos)
+           {
+               readyFlag = true;
+               ready = true;
+           }
        }
-       else respReadyFlag = true;
+       if (ready)
+          respCond.notify_all();
        if(!runFlag)
           break;
     }
+    // cec-client is gone: nothing more will be answered
+    {
+        std::lock_guard<std::mutex> lock(respMutex);
+        runFlag = false;
+        readyFlag = true;
+        respReadyFlag = true;
+    }
+    respCond.notify_all();
 }
 
 void CecHandler::addRequest(std::string name, std::string cmd)
 {
-    reqProcFlag = true;
-    respReadyFlag = false;
-    cmdName = cmd;
-    dup2(fd1[1], 1);
-    close(fd1[0]);
-    std::cout << cmd << std::endl;
+    {
+        std::lock_guard<std::mutex> lock(respMutex);
+        reqProcFlag = true;
+        respReadyFlag = !replyMarker(cmd);
+        resp.clear();
+        cmdName = cmd;
+        respDeadline = std::chrono::steady_clock::now() + responseTimeout(cmd);
+    }
+    // Straight into the pipe, leaving the stdout of the process alone
+    std::string line = cmd + "\n";
+    if (write(fd1[1], line.c_str(), line.size()) != (ssize_t)line.size())
+    {
+        std::lock_guard<std::mutex> lock(respMutex);
+        respReadyFlag = true;
+    }
 }
 
 std::vector<std::string> CecHandler::listAdapters()
@@ -207,12 +351,14 @@ std::vector<std::string> CecHandler::listAdapters()
 
 std::string CecHandler::getAddress()
 {
+    std::lock_guard<std::mutex> lock(respMutex);
     std::string resp = "address: " + physicalAddress;
     return resp;
 }
 
 std::string CecHandler::getVersion()
 {
+    std::lock_guard<std::mutex> lock(respMutex);
     std::string resp = "CEC version: " + version;
     return resp;
 }
@@ -225,18 +371,21 @@ std::string CecHandler::getVendorId()
 
 std::string CecHandler::getOsdName()
 {
+    std::lock_guard<std::mutex> lock(respMutex);
     std::string resp = "osd string: " + osdName;
     return resp;
 }
 
 std::string CecHandler::getPowerStatus()
 {
+    std::lock_guard<std::mutex> lock(respMutex);
     std::string resp = "power status: " + powerStatus;
     return resp;
 }
 
 std::string CecHandler::getLang()
 {
+    std::lock_guard<std::mutex> lock(respMutex);
     std::string resp = "language: " + lang;
     return resp;
 }
@@ -249,6 +398,7 @@ std::string CecHandler::getLogicalAddress()
 
 std::string CecHandler::getDeviceType()
 {
+    std::lock_guard<std::mutex> lock(respMutex);
     std::string resp = "type: " + deviceType;
     return resp;
 }
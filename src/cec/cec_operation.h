@@ -36,19 +36,39 @@
 #include <thread>
 #include <mutex>
 #include <condition_variable>
+#include <atomic>
+#include <chrono>
 
+#ifndef EXE_NAME
 #define EXE_NAME "/usr/bin/cec-client"
+#endif
+// What cec-client prints once it takes commands
+#define EXE_READY_BANNER "waiting for input"
 
 class CecHandler
 {
 private:
     CecHandler();
     void parseConfigData(std::vector<std::string>);
+    bool waitReady();
+    void initialScan();
     std::thread mProcThread;
+    std::thread mScanThread;
+    // cec-client of the running session, 0 once it has exited
+    pid_t mChildPid;
     std::vector<std::string> resp;
-    bool runFlag;
+    std::atomic<bool> runFlag;
+    // resp, the flags and cmdName are shared with responseHandler under respMutex
     bool reqProcFlag;
     bool respReadyFlag;
+    bool readyFlag;
+    bool scanPending;
+    std::mutex respMutex;
+    std::condition_variable respCond;
+    std::chrono::steady_clock::time_point respDeadline;
+    std::chrono::steady_clock::time_point readyDeadline;
+    // One request to cec-client at a time
+    std::mutex reqMutex;
     std::string deviceNum;
     std::string physicalAddress;
     std::string version;
@@ -69,6 +89,8 @@ public:
     void responseHandler();
     std::vector<std::string> getResponse();
     void addRequest(std::string, std::string);
+    std::vector<std::string> sendRequest(std::string, std::string);
+    bool isScanPending();
     std::vector<std::string> executeSingleCommand(std::string);
     std::vector<std::string> listAdapters();
     std::string getAddress();
@@ -0,0 +1,151 @@
+// Copyright (c) 2024 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+//
+// Start-up of the CEC module against tests/cec-client-stub, which takes
+// 0.5 s to start and 1 s to scan: opening must not wait for either.
+//
+
+#include <glib.h>
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+
+// Pull in the code under test
+#include "../cec_operation.cpp"
+#include "../cec.cpp"
+
+static nyx_instance_t the_instance = (nyx_instance_t) "an instance";
+static char last_response[256];
+
+extern "C" nyx_error_t nyx_module_register_method(nyx_instance_t instance,
+        nyx_device_t *device_in_ptr, module_method_t method, const char *symbol_str)
+{
+	return NYX_ERROR_NONE;
+}
+
+static void response_cb(nyx_cec_response_t *response)
+{
+	g_strlcpy(last_response, response->size ? response->responses[0] : "",
+	          sizeof(last_response));
+}
+
+static long elapsed_ms(std::chrono::steady_clock::time_point start)
+{
+	return std::chrono::duration_cast<std::chrono::milliseconds>(
+	           std::chrono::steady_clock::now() - start).count();
+}
+
+static void wait_for_scan(void)
+{
+	int i;
+
+	for (i = 0; i < 1000 && CecHandler::getInst().isScanPending(); i++)
+	{
+		g_usleep(10000);
+	}
+	g_assert(!CecHandler::getInst().isScanPending());
+}
+
+static void send_get_power_state(nyx_device_t *device)
+{
+	nyx_cec_command_t command;
+
+	memset(&command, 0, sizeof(command));
+	strcpy(command.name, "get-power-state");
+	command.size = 1;
+	strcpy(command.params[0].name, "destAddress");
+	strcpy(command.params[0].value, "0");
+	last_response[0] = '\0';
+	g_assert(cec_send_command(device, &command) == NYX_ERROR_NONE);
+}
+
+static void test_cec_open(void)
+{
+	nyx_device_t *device = NULL;
+	nyx_cec_callbacks_t callbacks;
+	nyx_cec_command_t command;
+	char buffer[256];
+	char *value = buffer;
+	char type[32];
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	g_assert(nyx_module_open(the_instance, &device) == NYX_ERROR_NONE);
+	g_test_message("nyx_module_open: %ld ms", elapsed_ms(start));
+	g_assert_cmpint(elapsed_ms(start), <, 1000);
+
+	// The adapter is known right away, the bus only once it is scanned
+	strcpy(type, "logicalAddress");
+	g_assert(cec_get_config(device, type, &value) == NYX_ERROR_NONE);
+	g_assert_cmpstr(buffer, ==, "logical address: 1");
+	strcpy(type, "powerState");
+	g_assert(cec_get_config(device, type, &value) == NYX_ERROR_DEVICE_UNAVAILABLE);
+
+	wait_for_scan();
+	g_test_message("initial scan: %ld ms", elapsed_ms(start));
+	g_assert(cec_get_config(device, type, &value) == NYX_ERROR_NONE);
+	g_assert_cmpstr(buffer, ==, "power status: on");
+
+	// A query returns as soon as cec-client answers
+	callbacks.response_cb = response_cb;
+	g_assert(cec_set_callback(device, &callbacks) == NYX_ERROR_NONE);
+
+	start = std::chrono::steady_clock::now();
+	send_get_power_state(device);
+	g_test_message("get-power-state: %ld ms", elapsed_ms(start));
+	g_assert_cmpint(elapsed_ms(start), <, 200);
+	g_assert_cmpstr(last_response, ==, "power status:on");
+
+	// Commands cec-client does not answer are done once they are sent
+	memset(&command, 0, sizeof(command));
+	strcpy(command.name, "active");
+	start = std::chrono::steady_clock::now();
+	g_assert(cec_send_command(device, &command) == NYX_ERROR_NONE);
+	g_assert_cmpint(elapsed_ms(start), <, 200);
+	g_assert_cmpstr(last_response, ==, "response: success");
+
+	g_assert(nyx_module_close(device) == NYX_ERROR_NONE);
+}
+
+// The session of a closed device must leave the next one alone
+static void test_cec_reopen(void)
+{
+	nyx_device_t *device = NULL;
+	nyx_cec_callbacks_t callbacks;
+	int i;
+
+	callbacks.response_cb = response_cb;
+	// Each one opened right after the last one is closed
+	for (i = 0; i < 3; i++)
+	{
+		g_assert(nyx_module_open(the_instance, &device) == NYX_ERROR_NONE);
+		g_assert(cec_set_callback(device, &callbacks) == NYX_ERROR_NONE);
+		wait_for_scan();
+		send_get_power_state(device);
+		g_assert_cmpstr(last_response, ==, "power status:on");
+		g_assert(nyx_module_close(device) == NYX_ERROR_NONE);
+	}
+}
+
+int main(int argc, char **argv)
+{
+	g_test_init(&argc, &argv, NULL);
+
+	g_test_add_func("/cec/open", test_cec_open);
+	g_test_add_func("/cec/reopen", test_cec_reopen);
+
+	return g_test_run();
+}
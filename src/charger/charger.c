@@ -27,19 +27,34 @@
 #include <pthread.h>
 #include <unistd.h>
 #include <time.h>
-#include <libudev.h>
 #include <utils.h>
+#include <power_supply_monitor.h>
 
 #include <nyx/nyx_module.h>
 #include <nyx/module/nyx_utils.h>
 #include "msgid.h"
+#include "charger.h"
 
 #define STATUS_LEN 64
-#define PATH_LEN 128
 
-struct udev *udev = NULL;
-struct udev_monitor *mon = NULL;
-guint watch = 0;
+/* what a USB source offers when it does not report voltage_max, in uV */
+#define CHARGER_USB_DEFAULT_VOLTAGE 5000000
+
+/* Sampling periods of the battery temperature and voltage, in s, by how
+ * close they are to their limits (in 0.1 degC and uV) */
+#define CHARGER_SAMPLER_FAST_S 5
+#define CHARGER_SAMPLER_MEDIUM_S 20
+#define CHARGER_SAMPLER_SLOW_S 60
+#define CHARGER_SAMPLER_NEAR_TEMPERATURE 50
+#define CHARGER_SAMPLER_NEAR_VOLTAGE 100000
+#define CHARGER_SAMPLER_MEDIUM_TEMPERATURE 150
+#define CHARGER_SAMPLER_MEDIUM_VOLTAGE 300000
+
+/* a limit event clears only once the value is back this far inside */
+#define CHARGER_LIMIT_TEMPERATURE_HYSTERESIS 10
+#define CHARGER_LIMIT_VOLTAGE_HYSTERESIS 50000
+
+static bool listening = false;
 
 extern nyx_device_t *nyxDev;
 extern void *charger_status_callback_context;
@@ -48,14 +63,102 @@ extern nyx_device_callback_function_t charger_status_callback;
 extern nyx_device_callback_function_t state_change_callback;
 
 nyx_battery_status_t *curr_battery_state = NULL;
-char *battery_status = NULL;
 
-char batt_present_path[PATH_LEN] = {0,};
-char batt_status_path[PATH_LEN] = {0,};
-char charger_usb_sysfs_online_path[PATH_LEN] = {0,};
-char charger_ac_sysfs_online_path[PATH_LEN] = {0,};
-char charger_touch_sysfs_online_path[PATH_LEN] = {0,};
-char charger_wireless_sysfs_online_path[PATH_LEN] = {0,};
+/* POWER_SUPPLY_STATUS of the battery */
+typedef enum
+{
+	BATTERY_STATUS_UNKNOWN,
+	BATTERY_STATUS_CHARGING,
+	BATTERY_STATUS_DISCHARGING,
+	BATTERY_STATUS_NOT_CHARGING,
+	BATTERY_STATUS_FULL
+} battery_status_t;
+
+static battery_status_t battery_status = BATTERY_STATUS_UNKNOWN;
+
+/*
+ * State of the charge the events are raised for: the battery status, and
+ * a fault when a charger is online but the battery reports "Not charging".
+ * "Discharging" with a charger online is not one, the battery reports it
+ * for a moment after every plug.
+ */
+typedef enum
+{
+	CHARGE_STATE_UNKNOWN,
+	CHARGE_STATE_CHARGING,
+	CHARGE_STATE_DISCHARGING,
+	CHARGE_STATE_FULL,
+	CHARGE_STATE_FAULT,
+	CHARGE_STATE_COUNT
+} charge_state_t;
+
+typedef struct
+{
+	nyx_charger_event_t set;
+	nyx_charger_event_t clear;
+} charge_transition_t;
+
+/* events raised and cleared by each change of charge state; no entry, no event */
+static const charge_transition_t charge_transitions[CHARGE_STATE_COUNT][CHARGE_STATE_COUNT] =
+{
+	[CHARGE_STATE_UNKNOWN][CHARGE_STATE_FULL] = { NYX_CHARGE_COMPLETE, NYX_CHARGE_RESTART },
+	[CHARGE_STATE_UNKNOWN][CHARGE_STATE_FAULT] = { NYX_CHARGER_FAULT, 0 },
+	[CHARGE_STATE_CHARGING][CHARGE_STATE_FULL] = { NYX_CHARGE_COMPLETE, NYX_CHARGE_RESTART },
+	[CHARGE_STATE_CHARGING][CHARGE_STATE_FAULT] = { NYX_CHARGER_FAULT, 0 },
+	[CHARGE_STATE_DISCHARGING][CHARGE_STATE_FAULT] = { NYX_CHARGER_FAULT, 0 },
+	[CHARGE_STATE_FULL][CHARGE_STATE_CHARGING] = { NYX_CHARGE_RESTART, NYX_CHARGE_COMPLETE },
+	[CHARGE_STATE_FULL][CHARGE_STATE_FAULT] = { NYX_CHARGER_FAULT, 0 },
+	[CHARGE_STATE_FAULT][CHARGE_STATE_UNKNOWN] = { 0, NYX_CHARGER_FAULT },
+	[CHARGE_STATE_FAULT][CHARGE_STATE_CHARGING] = { 0, NYX_CHARGER_FAULT },
+	[CHARGE_STATE_FAULT][CHARGE_STATE_DISCHARGING] = { 0, NYX_CHARGER_FAULT },
+	[CHARGE_STATE_FAULT][CHARGE_STATE_FULL] = { NYX_CHARGE_COMPLETE, NYX_CHARGE_RESTART | NYX_CHARGER_FAULT },
+};
+
+sysfs_attr_t batt_present = SYSFS_ATTR_INIT;
+sysfs_attr_t batt_status = SYSFS_ATTR_INIT;
+sysfs_attr_t batt_temperature = SYSFS_ATTR_INIT;
+sysfs_attr_t batt_voltage = SYSFS_ATTR_INIT;
+/* the uevent attribute of a source carries its online, current_max,
+ * voltage_max and usb_type, read all at once */
+sysfs_attr_t charger_usb_uevent = SYSFS_ATTR_INIT;
+sysfs_attr_t charger_ac_uevent = SYSFS_ATTR_INIT;
+sysfs_attr_t charger_touch_uevent = SYSFS_ATTR_INIT;
+sysfs_attr_t charger_wireless_uevent = SYSFS_ATTR_INIT;
+
+static sysfs_attr_t *charger_attrs[] =
+{
+	&batt_present, &batt_status, &batt_temperature, &batt_voltage,
+	&charger_usb_uevent, &charger_ac_uevent, &charger_touch_uevent,
+	&charger_wireless_uevent,
+};
+
+typedef enum
+{
+	CHARGER_USB = NYX_CHARGER_SOURCE_USB,
+	CHARGER_AC = NYX_CHARGER_SOURCE_AC,
+	CHARGER_TOUCH = NYX_CHARGER_SOURCE_TOUCH,
+	CHARGER_WIRELESS = NYX_CHARGER_SOURCE_WIRELESS,
+	CHARGER_SUPPLY_COUNT = NYX_CHARGER_SOURCE_COUNT
+} charger_supply_t;
+
+static sysfs_attr_t *charger_uevent_attrs[CHARGER_SUPPLY_COUNT] =
+{
+	[CHARGER_USB] = &charger_usb_uevent,
+	[CHARGER_AC] = &charger_ac_uevent,
+	[CHARGER_TOUCH] = &charger_touch_uevent,
+	[CHARGER_WIRELESS] = &charger_wireless_uevent,
+};
+
+/* last known state of each source, from its uevent attribute or its uevents */
+static nyx_charger_source_t charger_sources[CHARGER_SUPPLY_COUNT];
+
+/* 1 if the attribute reads 1, like nyx_utils_read_value(path) == 1 */
+static bool _attr_is_one(sysfs_attr_t *attr)
+{
+	int32_t value;
+
+	return sysfs_attr_read_int(attr, &value) == 0 && value == 1;
+}
 
 static nyx_charger_event_t current_event = NYX_NO_NEW_EVENT;
 nyx_charger_status_t gChargerStatus =
@@ -67,31 +170,120 @@ nyx_charger_status_t gChargerStatus =
 	.is_charging = false,
 };
 
-nyx_error_t core_charger_read_status(nyx_charger_status_t *status)
+/* Fold the sources into the status the charger queries return */
+static void _charger_update_status(void)
 {
+	nyx_charger_source_t *usb = &charger_sources[CHARGER_USB];
+	nyx_charger_source_t *ac = &charger_sources[CHARGER_AC];
+	int i;
+
 	/* before we start to update the charger status we reset it completely */
 	memset(&gChargerStatus, 0, sizeof(nyx_charger_status_t));
 
-	/* function returns -1 on invalid file path, so check for 1, instead of true */
-	if (nyx_utils_read_value(charger_usb_sysfs_online_path) == 1)
+	if (usb->online)
 	{
 		gChargerStatus.connected |= NYX_CHARGER_PC_CONNECTED;
 		gChargerStatus.powered |= NYX_CHARGER_USB_POWERED;
 	}
-	else if (nyx_utils_read_value(charger_ac_sysfs_online_path) == 1)
+	else if (ac->online)
 	{
 		gChargerStatus.connected |= NYX_CHARGER_WALL_CONNECTED;
 		gChargerStatus.powered |= NYX_CHARGER_DIRECT_POWERED;
 	}
 
-	if ((nyx_utils_read_value(charger_usb_sysfs_online_path) == 1) ||
-	        (nyx_utils_read_value(charger_ac_sysfs_online_path) == 1) ||
-	        (nyx_utils_read_value(charger_touch_sysfs_online_path) == 1) ||
-	        (nyx_utils_read_value(charger_wireless_sysfs_online_path) == 1))
+	if (charger_sources[CHARGER_TOUCH].online || charger_sources[CHARGER_WIRELESS].online)
+	{
+		gChargerStatus.connected |= NYX_CHARGER_INDUCTIVE_CONNECTED;
+		gChargerStatus.powered |= NYX_CHARGER_INDUCTIVE_POWERED;
+	}
+
+	for (i = 0; i < CHARGER_SUPPLY_COUNT; i++)
 	{
+		if (!charger_sources[i].online)
+		{
+			continue;
+		}
+
 		gChargerStatus.is_charging = true;
+
+		/* in mA, of the strongest source */
+		if (charger_sources[i].current_max / 1000 > gChargerStatus.charger_max_current)
+		{
+			gChargerStatus.charger_max_current = charger_sources[i].current_max / 1000;
+		}
 	}
+}
 
+/**
+ * Set a source from the values of its uevent. The kernel reports every
+ * property of the supply in it, so what is missing was not reported.
+ */
+static void _charger_update_source(charger_supply_t supply,
+                                   const power_supply_uevent_t *uevent)
+{
+	nyx_charger_source_t *source = &charger_sources[supply];
+	int32_t value;
+	int voltage;
+
+	memset(source, 0, sizeof(nyx_charger_source_t));
+
+	source->online = power_supply_uevent_get(uevent, POWER_SUPPLY_ONLINE, &value) &&
+	                 value == 1;
+
+	if (power_supply_uevent_get(uevent, POWER_SUPPLY_CURRENT_MAX, &value) && value > 0)
+	{
+		source->current_max = value;
+	}
+
+	if (power_supply_uevent_get(uevent, POWER_SUPPLY_VOLTAGE_MAX, &value) && value > 0)
+	{
+		source->voltage_max = value;
+	}
+
+	g_strlcpy(source->usb_type, uevent->usb_type, NYX_CHARGER_USB_TYPE_LEN);
+
+	voltage = source->voltage_max;
+
+	if (!voltage && supply == CHARGER_USB)
+	{
+		voltage = CHARGER_USB_DEFAULT_VOLTAGE;
+	}
+
+	if (source->online)
+	{
+		/* uA x uV = 1e-12 W */
+		source->power_max = (int)((int64_t)source->current_max * voltage / 1000000000);
+	}
+}
+
+/* Read a source again: one pread() of its uevent attribute */
+static void _charger_read_source(charger_supply_t supply)
+{
+	power_supply_uevent_t uevent;
+
+	/* a source that is not there reads as offline */
+	power_supply_read_uevent_attr(charger_uevent_attrs[supply], &uevent);
+	_charger_update_source(supply, &uevent);
+}
+
+static void _charger_read_sources(void)
+{
+	int i;
+
+	for (i = 0; i < CHARGER_SUPPLY_COUNT; i++)
+	{
+		_charger_read_source(i);
+	}
+
+	_charger_update_status();
+}
+
+/**
+ * The charger status as of the last uevent; the uevents keep it up to date,
+ * so the query does not read sysfs.
+ */
+nyx_error_t core_charger_read_status(nyx_charger_status_t *status)
+{
 	if (status)
 	{
 		memcpy(status, &gChargerStatus, sizeof(nyx_charger_status_t));
@@ -100,55 +292,113 @@ nyx_error_t core_charger_read_status(nyx_charger_status_t *status)
 	return NYX_ERROR_NONE;
 }
 
-void _battery_read_status()
+void core_charger_query_source(nyx_charger_source_type_t type,
+                               nyx_charger_source_t *source)
 {
-	if (curr_battery_state && battery_status)
+	memcpy(source, &charger_sources[type], sizeof(nyx_charger_source_t));
+}
+
+/**
+ * Parse a POWER_SUPPLY_STATUS value: "Unknown", "Charging", "Discharging",
+ * "Not charging" or "Full". Their first letters differ, which is enough.
+ */
+static battery_status_t _parse_battery_status(const char *status)
+{
+	switch (status[0])
 	{
-		memset(curr_battery_state, 0, sizeof(nyx_battery_status_t));
-		memset(battery_status, 0, sizeof(battery_status));
-		char status[STATUS_LEN];
+		case 'C':
+			return BATTERY_STATUS_CHARGING;
 
-		curr_battery_state->present = ((nyx_utils_read_value(batt_present_path)) == 1) ?
-		                              true : false;
+		case 'D':
+			return BATTERY_STATUS_DISCHARGING;
 
-		if (FileGetString(batt_status_path, status, STATUS_LEN) != -1)
-		{
-			strcpy(battery_status, status);
-		}
+		case 'N':
+			return BATTERY_STATUS_NOT_CHARGING;
+
+		case 'F':
+			return BATTERY_STATUS_FULL;
+
+		default:
+			return BATTERY_STATUS_UNKNOWN;
 	}
 }
 
-bool _has_charger_state_changed(char *old_state, char *new_state)
+/**
+ * Update the battery state from the values of a battery uevent, reading
+ * sysfs for those it did not carry. Without an event everything is read.
+ */
+static void _battery_update_status(const power_supply_uevent_t *uevent)
 {
-	if (new_state && !old_state && (strcmp(new_state, "Full") == 0))
+	if (curr_battery_state)
 	{
-		current_event &= ~NYX_CHARGE_RESTART;
-		current_event |= NYX_CHARGE_COMPLETE;
-		return true;
-	}
+		int32_t present;
+		char status[STATUS_LEN];
 
-	if (old_state && new_state && (strcmp(old_state, new_state) != 0))
-	{
-		if ((strcmp(old_state, "Charging") == 0) && (strcmp(new_state, "Full") == 0))
+		memset(curr_battery_state, 0, sizeof(nyx_battery_status_t));
+
+		if (uevent && power_supply_uevent_get(uevent, POWER_SUPPLY_PRESENT, &present))
 		{
-			current_event &= ~NYX_CHARGE_RESTART;
-			current_event |= NYX_CHARGE_COMPLETE;
+			curr_battery_state->present = (present == 1);
 		}
-		else if ((strcmp(old_state, "Full") == 0) &&
-		         (strcmp(new_state, "Charging") == 0))
+		else
 		{
-			current_event &= ~NYX_CHARGE_COMPLETE;
-			current_event |= NYX_CHARGE_RESTART;
+			curr_battery_state->present = _attr_is_one(&batt_present);
+		}
+
+		if (uevent && uevent->status[0])
+		{
+			battery_status = _parse_battery_status(uevent->status);
+		}
+		else if (sysfs_attr_read(&batt_status, status, STATUS_LEN) != -1)
+		{
+			battery_status = _parse_battery_status(status);
 		}
 		else
 		{
-			return false;
+			battery_status = BATTERY_STATUS_UNKNOWN;
 		}
+	}
+}
 
-		return true;
+void _battery_read_status()
+{
+	_battery_update_status(NULL);
+}
+
+static charge_state_t _charge_state(void)
+{
+	switch (battery_status)
+	{
+		case BATTERY_STATUS_CHARGING:
+			return CHARGE_STATE_CHARGING;
+
+		case BATTERY_STATUS_DISCHARGING:
+			return CHARGE_STATE_DISCHARGING;
+
+		case BATTERY_STATUS_NOT_CHARGING:
+			return gChargerStatus.is_charging ? CHARGE_STATE_FAULT :
+			       CHARGE_STATE_DISCHARGING;
+
+		case BATTERY_STATUS_FULL:
+			return CHARGE_STATE_FULL;
+
+		default:
+			return CHARGE_STATE_UNKNOWN;
 	}
+}
 
-	return false;
+bool _has_charger_state_changed(charge_state_t old_state, charge_state_t new_state)
+{
+	const charge_transition_t *transition = &charge_transitions[old_state][new_state];
+
+	if (!transition->set && !transition->clear)
+	{
+		return false;
+	}
+
+	current_event &= ~transition->clear;
+	current_event |= transition->set;
+	return true;
 }
 
 bool _has_battery_state_changed(int old_state, int new_state)
@@ -193,204 +443,388 @@ bool _has_charger_connected_state_changed(bool old_state, bool new_state)
 	return false;
 }
 
-gboolean _handle_power_supply_event(GIOChannel *channel, GIOCondition condition,
-                                    gpointer data)
+void _detect_charger_sysfs_paths()
 {
-	struct udev_device *dev;
-	bool fire_charger_status_cb = false;
-	bool fire_state_change_cb = false;
+	const char *battery_sysfs_path = power_supply_path_by_type("Battery");
+	const char *charger_usb_sysfs_path = power_supply_path_by_type("USB");
+	const char *charger_ac_sysfs_path = power_supply_path_by_type("Mains");
+	const char *charger_touch_sysfs_path = power_supply_path_by_type("Touch");
+	const char *charger_wireless_sysfs_path = power_supply_path_by_type("Wireless");
+
+	/* a supply that is not there leaves its attribute unset */
+	sysfs_attr_init(&charger_usb_uevent, charger_usb_sysfs_path, "uevent");
+	sysfs_attr_init(&charger_ac_uevent, charger_ac_sysfs_path, "uevent");
+	sysfs_attr_init(&charger_touch_uevent, charger_touch_sysfs_path, "uevent");
+	sysfs_attr_init(&charger_wireless_uevent, charger_wireless_sysfs_path, "uevent");
+	sysfs_attr_init(&batt_present, battery_sysfs_path, "present");
+	sysfs_attr_init(&batt_status, battery_sysfs_path, "status");
+	sysfs_attr_init(&batt_temperature, battery_sysfs_path, "temp");
+	sysfs_attr_init(&batt_voltage, battery_sysfs_path, "voltage_now");
+}
 
-	if ((condition & G_IO_IN) == G_IO_IN)
+/*
+ * Sampler of the battery temperature and voltage. The kernel sends no
+ * uevent when they change, so they are polled, but only while a state change
+ * callback is registered and a battery is present, and the further they are
+ * from their limits the slower.
+ */
+static guint sampler_timer = 0;
+static unsigned int sampler_interval = 0;
+
+bool _has_battery_limit_changed(nyx_charger_event_t limit, bool reached)
+{
+	if (((current_event & limit) != 0) == reached)
 	{
-		dev = udev_monitor_receive_device(mon);
+		return false;
+	}
 
-		if (dev)
-		{
-			/* something related to power supply has changed; set the modified event and notify connected clients so
-			 * they can query the new status */
-
-			/* Check for event changes and initiate state callback for particular events as below:
-			 * NYX_CHARGE_COMPLETE if battery/status from NULL/Charging to Full, NYX_CHARGE_RESTART if battery/status from Full to Charging,
-			 * NYX_CHARGER_CONNECTED if USB,AC or any other charger online is from 0 to 1,
-			 * NYX_CHARGER_DISCONNECTED if any charger online from 1 to 0,
-			 * NYX_CHARGER_FAULT if online=1 and battery/status=Not Charging/Discharging? - TODO: not implemented since we are not sure of the state change for this event
-			 * NYX_BATTERY_PRESENT if battery is present (0-1)
-			 * NYX_BATTERY_ABSENT if battery is absent (1-0)
-			 * NYX_BATTERY_CRITICAL_VOLTAGE if Battery voltage below threshold - TODO: not implemented since we do not get kobject for voltage changes
-			 * NYX_BATTERY_TEMPERATURE_LIMIT if Battery temperature below/above limits - TODO: not implemented since we do not get kobject for temperature changes
-			 */
-
-			bool prev_charging = gChargerStatus.is_charging;
-			core_charger_read_status(NULL);
-
-			if (_has_charger_connected_state_changed(prev_charging,
-			        gChargerStatus.is_charging))
-			{
-				fire_charger_status_cb = true;
-				fire_state_change_cb = true;
-			}
+	if (reached)
+	{
+		current_event |= limit;
+	}
+	else
+	{
+		current_event &= ~limit;
+	}
 
-			if (fire_charger_status_cb && charger_status_callback)
-			{
-				charger_status_callback(nyxDev, NYX_CALLBACK_STATUS_DONE,
-				                        charger_status_callback_context);
-				fire_charger_status_cb = false;
-			}
+	return true;
+}
 
-			/* Keep a note of previous values */
-			char *prev_batt_status = g_strdup(battery_status);
-			int prev_batt_present = curr_battery_state->present;
+/**
+ * Sampling period for a temperature (0.1 degC) and voltage (uV); a value
+ * that could not be read is not taken into account.
+ */
+unsigned int _charger_sampler_interval(bool has_temperature, int32_t temperature,
+                                       bool has_voltage, int32_t voltage)
+{
+	int32_t temperature_margin = G_MAXINT32;
+	int32_t voltage_margin = G_MAXINT32;
 
-			_battery_read_status();
+	if (has_temperature)
+	{
+		temperature_margin = MIN(temperature - BATTERY_CHARGE_MIN_TEMPERATURE_C * 10,
+		                         BATTERY_CHARGE_MAX_TEMPERATURE_C * 10 - temperature);
+	}
 
-			if ((_has_charger_state_changed(prev_batt_status, battery_status)) ||
-			        (_has_battery_state_changed(prev_batt_present, curr_battery_state->present)))
-			{
-				fire_state_change_cb = true;
-			}
+	if (has_voltage)
+	{
+		voltage_margin = voltage - BATTERY_CRITICAL_VOLTAGE_MV * 1000;
+	}
 
-			g_free(prev_batt_status);
+	if (temperature_margin < CHARGER_SAMPLER_NEAR_TEMPERATURE ||
+	        voltage_margin < CHARGER_SAMPLER_NEAR_VOLTAGE)
+	{
+		return CHARGER_SAMPLER_FAST_S;
+	}
 
-			if (fire_state_change_cb && state_change_callback)
-			{
-				state_change_callback(nyxDev, NYX_CALLBACK_STATUS_DONE,
-				                      state_change_callback_context);
-				fire_state_change_cb = false;
-			}
-		}
+	if (temperature_margin < CHARGER_SAMPLER_MEDIUM_TEMPERATURE ||
+	        voltage_margin < CHARGER_SAMPLER_MEDIUM_VOLTAGE)
+	{
+		return CHARGER_SAMPLER_MEDIUM_S;
 	}
 
-	return TRUE;
+	return CHARGER_SAMPLER_SLOW_S;
 }
 
-void _charger_init_events()
+/**
+ * Read the battery temperature and voltage, update the limit events and
+ * call back if one of them changed.
+ *
+ * @retval the period to sample them again at
+ */
+static unsigned int _charger_sample_limits(void)
 {
-	_has_charger_state_changed(NULL, battery_status);
-	_has_battery_state_changed(0, curr_battery_state->present);
-	_has_charger_connected_state_changed(0, gChargerStatus.is_charging);
+	int32_t temperature = 0, voltage = 0;
+	bool has_temperature = sysfs_attr_read_int(&batt_temperature, &temperature) == 0;
+	bool has_voltage = sysfs_attr_read_int(&batt_voltage, &voltage) == 0;
+	bool changed = false;
+
+	if (has_temperature)
+	{
+		int32_t slack = (current_event & NYX_BATTERY_TEMPERATURE_LIMIT) ?
+		                CHARGER_LIMIT_TEMPERATURE_HYSTERESIS : 0;
+
+		changed |= _has_battery_limit_changed(NYX_BATTERY_TEMPERATURE_LIMIT,
+		                                      temperature < BATTERY_CHARGE_MIN_TEMPERATURE_C * 10 + slack ||
+		                                      temperature > BATTERY_CHARGE_MAX_TEMPERATURE_C * 10 - slack);
+	}
+
+	if (has_voltage)
+	{
+		int32_t slack = (current_event & NYX_BATTERY_CRITICAL_VOLTAGE) ?
+		                CHARGER_LIMIT_VOLTAGE_HYSTERESIS : 0;
+
+		changed |= _has_battery_limit_changed(NYX_BATTERY_CRITICAL_VOLTAGE,
+		                                      voltage < BATTERY_CRITICAL_VOLTAGE_MV * 1000 + slack);
+	}
+
+	if (changed && state_change_callback)
+	{
+		state_change_callback(nyxDev, NYX_CALLBACK_STATUS_DONE,
+		                      state_change_callback_context);
+	}
+
+	return _charger_sampler_interval(has_temperature, temperature, has_voltage, voltage);
 }
 
-void _detect_charger_sysfs_paths()
+static gboolean _charger_sampler_cb(gpointer data)
 {
-	char *battery_sysfs_path = find_power_supply_sysfs_path("Battery");
-	char *charger_usb_sysfs_path = find_power_supply_sysfs_path("USB");
-	char *charger_ac_sysfs_path = find_power_supply_sysfs_path("Mains");
-	char *charger_touch_sysfs_path = find_power_supply_sysfs_path("Touch");
-	char *charger_wireless_sysfs_path = find_power_supply_sysfs_path("Wireless");
+	unsigned int interval = _charger_sample_limits();
 
-	if (charger_usb_sysfs_path)
+	if (interval == sampler_interval)
 	{
-		snprintf(charger_usb_sysfs_online_path, PATH_LEN, "%s/online",
-		         charger_usb_sysfs_path);
+		return TRUE;
 	}
 
-	if (charger_ac_sysfs_path)
+	sampler_interval = interval;
+	sampler_timer = g_timeout_add_seconds(sampler_interval, _charger_sampler_cb, NULL);
+	return FALSE;
+}
+
+/**
+ * Start the sampler when somebody listens for state changes of a present
+ * battery, stop it otherwise. The first sample is taken from the main loop,
+ * so the state change callback never runs inside its own registration.
+ */
+void core_charger_update_sampler(void)
+{
+	bool run = listening && state_change_callback && curr_battery_state &&
+	           curr_battery_state->present &&
+	           (sysfs_attr_exists(&batt_temperature) || sysfs_attr_exists(&batt_voltage));
+
+	if (run && !sampler_timer)
 	{
-		snprintf(charger_ac_sysfs_online_path, PATH_LEN, "%s/online",
-		         charger_ac_sysfs_path);
+		/* no period yet, so the first sample arms the timeout */
+		sampler_interval = 0;
+		sampler_timer = g_idle_add(_charger_sampler_cb, NULL);
 	}
-
-	if (charger_touch_sysfs_path)
+	else if (!run && sampler_timer)
 	{
-		snprintf(charger_touch_sysfs_online_path, PATH_LEN, "%s/online",
-		         charger_touch_sysfs_path);
+		g_source_remove(sampler_timer);
+		sampler_timer = 0;
 	}
+}
+
+/*
+ * Coalescing of power_supply uevents: a burst (one charger plug touches the
+ * USB, Mains and Battery supplies) is applied to the cached state as it
+ * arrives, but evaluated only once when it is over, against the state the
+ * last evaluation left.
+ */
+static event_coalescer_t power_supply_events;
+static bool window_charging;
+static charge_state_t window_charge_state;
+static int window_batt_present;
+/* what the burst left to read from sysfs when it is evaluated */
+static bool refresh_charger;
+static bool refresh_battery;
+
+/**
+ * Apply a power_supply uevent to the cached charger and battery state.
+ * Only an event of a supply we do not know, or one without values, makes
+ * everything be read again from sysfs.
+ */
+static void _apply_power_supply_event(const power_supply_event_t *event)
+{
+	int i;
 
-	if (charger_wireless_sysfs_path)
+	/* a supply that comes or goes changes the attributes to watch */
+	if (event->index_changed)
 	{
-		snprintf(charger_wireless_sysfs_online_path, PATH_LEN, "%s/online",
-		         charger_wireless_sysfs_path);
+		_detect_charger_sysfs_paths();
+		refresh_charger = true;
+		refresh_battery = true;
+		return;
 	}
 
-	if (battery_sysfs_path)
+	if (event->has_values)
 	{
-		snprintf(batt_present_path, PATH_LEN, "%s/present", battery_sysfs_path);
-		snprintf(batt_status_path, PATH_LEN, "%s/status", battery_sysfs_path);
+		for (i = 0; i < CHARGER_SUPPLY_COUNT; i++)
+		{
+			if (!sysfs_attr_of_supply(charger_uevent_attrs[i], event->sysname))
+			{
+				continue;
+			}
+
+			if (power_supply_uevent_get(&event->values, POWER_SUPPLY_ONLINE, NULL))
+			{
+				_charger_update_source(i, &event->values);
+			}
+			else
+			{
+				_charger_read_source(i);
+			}
+
+			_charger_update_status();
+			/* the battery status follows the charger, often before its own uevent */
+			refresh_battery = true;
+			return;
+		}
+
+		if (sysfs_attr_of_supply(&batt_present, event->sysname))
+		{
+			_battery_update_status(&event->values);
+			return;
+		}
 	}
+
+	refresh_charger = true;
+	refresh_battery = true;
 }
 
-static void _charger_cleanup(void)
+/**
+ * Evaluate a burst of uevents: at most one call of each callback.
+ */
+static bool _flush_power_supply_events(void *data)
 {
-	// _charger_init sets g_io_channel_set_close_on_unref, and calls g_io_channel_unref.
-	// This leaves one ref associated with the watch, so removing the watch should close the channel.
-	if (0 != watch)
+	bool fire_charger_status_cb = false;
+	bool fire_state_change_cb = false;
+	bool delivered = false;
+
+	if (refresh_charger)
 	{
-		g_source_remove(watch);
-		watch = 0;
+		_charger_read_sources();
 	}
 
-	if (NULL != curr_battery_state)
+	if (refresh_battery)
 	{
-		free(curr_battery_state);
-		curr_battery_state = NULL;
+		_battery_read_status();
 	}
 
-	if (NULL != battery_status)
+	refresh_charger = false;
+	refresh_battery = false;
+
+	nyx_debug("%s: %u uevents, %u evaluations, %u delivered", __FUNCTION__,
+	          power_supply_events.raw_events, power_supply_events.evaluations,
+	          power_supply_events.delivered);
+
+	if (_has_charger_connected_state_changed(window_charging,
+	        gChargerStatus.is_charging))
 	{
-		free(battery_status);
-		battery_status = NULL;
+		fire_charger_status_cb = true;
+		fire_state_change_cb = true;
 	}
 
-	if (NULL != mon)
+	if (fire_charger_status_cb && charger_status_callback)
 	{
-		udev_monitor_filter_remove(mon);
-		mon = NULL;
+		charger_status_callback(nyxDev, NYX_CALLBACK_STATUS_DONE,
+		                        charger_status_callback_context);
+		delivered = true;
 	}
 
-	if (NULL != udev)
+	if ((_has_charger_state_changed(window_charge_state, _charge_state())) ||
+	        (_has_battery_state_changed(window_batt_present, curr_battery_state->present)))
 	{
-		udev_unref(udev);
-		udev = NULL;
+		fire_state_change_cb = true;
 	}
 
-	return;
+	if (fire_state_change_cb && state_change_callback)
+	{
+		state_change_callback(nyxDev, NYX_CALLBACK_STATUS_DONE,
+		                      state_change_callback_context);
+		delivered = true;
+	}
+
+	/* a battery that came or went starts or stops the sampler */
+	core_charger_update_sampler();
+
+	return delivered;
 }
 
-nyx_error_t core_charger_init(void)
+/**
+ * Counters of the uevent coalescing: power_supply uevents received and
+ * evaluations that called back
+ */
+void core_charger_get_event_counters(uint32_t *raw_events, uint32_t *delivered)
 {
-	int fd;
-	GIOChannel *channel = NULL;
+	if (raw_events)
+	{
+		*raw_events = power_supply_events.raw_events;
+	}
 
-	udev = udev_new();
+	if (delivered)
+	{
+		*delivered = power_supply_events.delivered;
+	}
+}
 
-	if (!udev)
+void _handle_power_supply_event(const power_supply_event_t *event, void *data)
+{
+	if (!event->dev)
 	{
-		nyx_error(MSGID_NYX_MOD_CHARG_ERR, 0,
-		          "Could not initialize udev component; charger status updates will not be available");
-		return NYX_ERROR_GENERIC;
+		return;
 	}
 
-	mon = udev_monitor_new_from_netlink(udev, "kernel");
+	/* something related to power supply has changed; set the modified event and notify connected clients so
+	 * they can query the new status */
+
+	/* Check for event changes and initiate state callback for particular events as below:
+	 * NYX_CHARGE_COMPLETE if battery/status from NULL/Charging to Full, NYX_CHARGE_RESTART if battery/status from Full to Charging,
+	 * NYX_CHARGER_CONNECTED if USB,AC or any other charger online is from 0 to 1,
+	 * NYX_CHARGER_DISCONNECTED if any charger online from 1 to 0,
+	 * NYX_CHARGER_FAULT if any charger is online and battery/status is Not charging, cleared when either changes
+	 * NYX_BATTERY_PRESENT if battery is present (0-1)
+	 * NYX_BATTERY_ABSENT if battery is absent (1-0)
+	 * NYX_BATTERY_CRITICAL_VOLTAGE and NYX_BATTERY_TEMPERATURE_LIMIT come from the sampler instead, since we do not get kobject for voltage or temperature changes
+	 */
 
-	if (mon == NULL)
+	if (!event_coalescer_pending(&power_supply_events))
 	{
-		nyx_error(MSGID_NYX_MOD_NETLINK_ERR, 0,
-		          "Failed to create udev monitor for kernel events");
-		_charger_cleanup();
-		return NYX_ERROR_GENERIC;
+		/* Keep a note of the values the burst starts from */
+		window_charging = gChargerStatus.is_charging;
+		window_charge_state = _charge_state();
+		window_batt_present = curr_battery_state->present;
 	}
 
-	if (udev_monitor_filter_add_match_subsystem_devtype(mon, "power_supply",
-	        NULL) < 0)
+	_apply_power_supply_event(event);
+	event_coalescer_push(&power_supply_events);
+}
+
+void _charger_init_events()
+{
+	_has_charger_state_changed(CHARGE_STATE_UNKNOWN, _charge_state());
+	_has_battery_state_changed(0, curr_battery_state->present);
+	_has_charger_connected_state_changed(0, gChargerStatus.is_charging);
+}
+
+static void _charger_cleanup(void)
+{
+	unsigned int i;
+
+	for (i = 0; i < G_N_ELEMENTS(charger_attrs); i++)
 	{
-		nyx_error(MSGID_NYX_MOD_CHR_SUB_ERR, 0,
-		          "Failed to setup udev filter for power_supply subsytem events");
-		_charger_cleanup();
-		return NYX_ERROR_GENERIC;
+		sysfs_attr_close(charger_attrs[i]);
 	}
 
-	if (udev_monitor_enable_receiving(mon) < 0)
+	if (listening)
 	{
-		nyx_error(MSGID_NYX_MOD_ENABLE_REV_ERR, 0,
-		          "Failed to enable receiving kernel events for power_supply subsytem\n");
-		_charger_cleanup();
-		return NYX_ERROR_GENERIC;
+		power_supply_monitor_remove_listener(_handle_power_supply_event, NULL);
+		listening = false;
 	}
 
+	core_charger_update_sampler();
+
+	event_coalescer_cancel(&power_supply_events);
+	battery_status = BATTERY_STATUS_UNKNOWN;
+	memset(charger_sources, 0, sizeof(charger_sources));
+	refresh_charger = false;
+	refresh_battery = false;
+
+	if (NULL != curr_battery_state)
+	{
+		free(curr_battery_state);
+		curr_battery_state = NULL;
+	}
+
+	return;
+}
+
+nyx_error_t core_charger_init(void)
+{
 	/* Initialize charger sysfs paths */
 	_detect_charger_sysfs_paths();
 	/* Initialize battery and charger status */
-	core_charger_read_status(NULL);
+	_charger_read_sources();
 	curr_battery_state = (nyx_battery_status_t *) malloc(sizeof(
 	                         nyx_battery_status_t));
 
@@ -400,51 +834,24 @@ nyx_error_t core_charger_init(void)
 		return NYX_ERROR_OUT_OF_MEMORY;
 	}
 
-	battery_status = (char *)malloc(STATUS_LEN);
-
-	if (NULL == battery_status)
-	{
-		_charger_cleanup();
-		return NYX_ERROR_OUT_OF_MEMORY;
-	}
-
 	_battery_read_status();
 
 	/* Initialize events */
 	_charger_init_events();
+	event_coalescer_init(&power_supply_events, power_supply_coalesce_ms(),
+	                     _flush_power_supply_events, NULL);
 
-	/* Setup io watch for uevents */
-	fd = udev_monitor_get_fd(mon);
-
-	if (-1 == fd)
-	{
-		_charger_cleanup();
-		return NYX_ERROR_GENERIC;
-	}
-
-	channel = g_io_channel_unix_new(fd);
-
-	if (!channel)
-	{
-		_charger_cleanup();
-		return NYX_ERROR_GENERIC;
-	}
-
-	/* add watch event (which adds a ref) before calling g_io_channel_unref */
-	watch = g_io_add_watch(channel, G_IO_IN | G_IO_HUP | G_IO_NVAL,
-	                       _handle_power_supply_event, NULL);
-
-	/* Remove the ref from g_io_channel_unix_new so we won't leak the channel if g_io_add_watch failed */
-	/* watch holds another ref which is removed in _charger_cleanup */
-	g_io_channel_set_close_on_unref(channel, TRUE);
-	g_io_channel_unref(channel);
-
-	if (0 == watch)
+	/* uevents come from the monitor shared with the battery module */
+	if (power_supply_monitor_add_listener(_handle_power_supply_event, NULL) < 0)
 	{
+		nyx_error(MSGID_NYX_MOD_CHARG_ERR, 0,
+		          "Could not monitor power_supply events; charger status updates will not be available");
 		_charger_cleanup();
 		return NYX_ERROR_GENERIC;
 	}
 
+	listening = true;
+	core_charger_update_sampler();
 	return NYX_ERROR_NONE;
 }
 
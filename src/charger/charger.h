@@ -17,11 +17,16 @@
 #ifndef CHARGER_H_
 #define CHARGER_H_
 
+#include "charger_source.h"
+
 nyx_error_t core_charger_init(void);
 nyx_error_t core_charger_deinit(void);
 nyx_error_t core_charger_read_status(nyx_charger_status_t *status);
 nyx_error_t core_charger_enable_charging(nyx_charger_status_t *status);
 nyx_error_t core_charger_disable_charging(nyx_charger_status_t *status);
 nyx_error_t core_charger_query_charger_event(nyx_charger_event_t *event);
+void core_charger_query_source(nyx_charger_source_type_t type, nyx_charger_source_t *source);
+void core_charger_get_event_counters(uint32_t *raw_events, uint32_t *delivered);
+void core_charger_update_sampler(void);
 
 #endif
@@ -0,0 +1,69 @@
+// Copyright (c) 2024 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+/**
+ * @file charger_source.h
+ *
+ * @brief What each power source of the charger module negotiated.
+ *
+ * Installed as <nyx-charger/charger_source.h>. nyx-lib fixes the method
+ * table of a module, so the query is not a nyx method; clients look it up
+ * in the charger module nyx_device_open() loaded and call it with the
+ * handle they got:
+ *
+ *     void *module = dlopen(<charger module library>, RTLD_NOW | RTLD_NOLOAD);
+ *     charger_query_source_function_t query_source =
+ *         (charger_query_source_function_t) dlsym(module, CHARGER_QUERY_SOURCE_SYMBOL);
+ */
+
+#ifndef CHARGER_SOURCE_H_
+#define CHARGER_SOURCE_H_
+
+#include <stdbool.h>
+#include <nyx/nyx_module.h>
+
+#define NYX_CHARGER_USB_TYPE_LEN 16
+
+typedef enum
+{
+	NYX_CHARGER_SOURCE_USB,
+	NYX_CHARGER_SOURCE_AC,
+	NYX_CHARGER_SOURCE_TOUCH,
+	NYX_CHARGER_SOURCE_WIRELESS,
+	NYX_CHARGER_SOURCE_COUNT
+} nyx_charger_source_type_t;
+
+typedef struct
+{
+	bool online;
+	int current_max;        /* uA the source may draw, 0 if not reported */
+	int voltage_max;        /* uV, 0 if not reported */
+	int power_max;          /* mW negotiated, 0 if offline or unknown */
+	char usb_type[NYX_CHARGER_USB_TYPE_LEN];  /* "SDP", "DCP", "PD"...; empty if not reported */
+} nyx_charger_source_t;
+
+/**
+ * Read the last known state of a power source. The module refreshes it
+ * from the uevents of the source, so this does not touch sysfs.
+ */
+nyx_error_t charger_query_source(nyx_device_handle_t handle,
+                                 nyx_charger_source_type_t type, nyx_charger_source_t *source);
+
+#define CHARGER_QUERY_SOURCE_SYMBOL "charger_query_source"
+typedef nyx_error_t (*charger_query_source_function_t)(nyx_device_handle_t handle,
+        nyx_charger_source_type_t type, nyx_charger_source_t *source);
+
+#endif /* CHARGER_SOURCE_H_ */
@@ -202,6 +202,9 @@ nyx_error_t charger_register_state_change_callback(nyx_device_handle_t handle,
 	state_change_callback = callback_func;
 	state_change_callback_context = context;
 
+	/* temperature and voltage are only sampled for a state change callback */
+	core_charger_update_sampler();
+
 	return NYX_ERROR_NONE;
 }
 
@@ -220,3 +223,21 @@ nyx_error_t charger_query_charger_event(nyx_device_handle_t handle,
 
 	return core_charger_query_charger_event(event);
 }
+
+nyx_error_t charger_query_source(nyx_device_handle_t handle,
+                                 nyx_charger_source_type_t type, nyx_charger_source_t *source)
+{
+	if (handle != nyxDev)
+	{
+		return NYX_ERROR_INVALID_HANDLE;
+	}
+
+	if ((unsigned int) type >= NYX_CHARGER_SOURCE_COUNT || !source)
+	{
+		return NYX_ERROR_INVALID_VALUE;
+	}
+
+	core_charger_query_source(type, source);
+
+	return NYX_ERROR_NONE;
+}
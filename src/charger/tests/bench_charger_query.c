@@ -0,0 +1,141 @@
+// Copyright (c) 2024 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+//
+// Cost of the charger query and uevent paths against a fake power_supply
+// tree: microseconds and file syscalls per call.
+//
+//     bench_charger_query [-n iterations] [-d parent directory]
+//
+// The tree is created in the parent directory (default $TMPDIR); use a
+// tmpfs such as /dev/shm to leave the disk out. Uevents are injected
+// straight into the charger listener, with coalescing off so that each one
+// is evaluated and calls back.
+//
+
+#include <glib.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <nyx/nyx_module.h>
+#include <nyx/module/nyx_utils.h>
+
+#undef nyx_debug
+#define nyx_debug(m, args...) {}
+
+// Pull in the code under test
+#include "../chargerlib.c"
+#include "../charger.c"
+
+#include "../../utils/tests/bench_power_supply.h"
+
+static uint32_t callbacks = 0;
+
+static void count_callback(nyx_device_handle_t handle, nyx_callback_status_t status,
+                           void *context)
+{
+	callbacks++;
+}
+
+int main(int argc, char **argv)
+{
+	nyx_device_t device;
+	nyx_charger_status_t status;
+	power_supply_event_t event;
+	bench_counters_t start, end;
+	const char *parent = NULL;
+	gchar *class_dir;
+	int iterations = 10000;
+	int opt, i;
+
+	while ((opt = getopt(argc, argv, "n:d:")) != -1)
+	{
+		switch (opt)
+		{
+			case 'n':
+				iterations = atoi(optarg);
+				break;
+
+			case 'd':
+				parent = optarg;
+				break;
+
+			default:
+				fprintf(stderr, "usage: %s [-n iterations] [-d parent directory]\n", argv[0]);
+				return 1;
+		}
+	}
+
+	if (!(class_dir = bench_power_supply_create(parent)))
+	{
+		fprintf(stderr, "cannot create a power_supply tree\n");
+		return 1;
+	}
+
+	// what core_charger_init() does, without the udev monitor
+	power_supply_index_scan(class_dir);
+	_detect_charger_sysfs_paths();
+	_charger_read_sources();
+	curr_battery_state = (nyx_battery_status_t *) calloc(1, sizeof(nyx_battery_status_t));
+	_battery_read_status();
+	event_coalescer_init(&power_supply_events, 0, _flush_power_supply_events, NULL);
+	nyxDev = &device;
+	charger_status_callback = count_callback;
+
+	printf("%s, %d iterations\n", class_dir, iterations);
+
+	bench_counters_get(&start);
+
+	for (i = 0; i < iterations; i++)
+	{
+		charger_query_charger_status(nyxDev, &status);
+	}
+
+	bench_counters_get(&end);
+	bench_counters_report("charger_query_charger_status", iterations, &start, &end);
+
+	// every uevent plugs or unplugs the usb charger, so each one calls back
+	memset(&event, 0, sizeof(event));
+	event.dev = (struct udev_device *) &device;     // never dereferenced by the listener
+	event.action = "change";
+	event.sysname = "usb";
+	event.has_values = true;
+	power_supply_uevent_set(&event.values, "POWER_SUPPLY_CURRENT_MAX", "500000");
+	power_supply_uevent_set(&event.values, "POWER_SUPPLY_VOLTAGE_MAX", "5000000");
+	power_supply_uevent_set(&event.values, "POWER_SUPPLY_USB_TYPE", "Unknown [SDP] DCP CDP");
+
+	bench_counters_get(&start);
+
+	for (i = 0; i < iterations; i++)
+	{
+		power_supply_uevent_set(&event.values, "POWER_SUPPLY_ONLINE", i % 2 ? "0" : "1");
+		_handle_power_supply_event(&event, NULL);
+	}
+
+	bench_counters_get(&end);
+	bench_counters_report("uevent to charger callback", iterations, &start, &end);
+
+	if (callbacks != (uint32_t) iterations)
+	{
+		printf("  %u callbacks for %d uevents\n", callbacks, iterations);
+	}
+
+	_charger_cleanup();
+	power_supply_index_clear();
+	bench_power_supply_remove(class_dir);
+	return 0;
+}
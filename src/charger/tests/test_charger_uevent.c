@@ -0,0 +1,489 @@
+// Copyright (c) 2024 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <stdarg.h>
+#include <stdio.h>
+
+#include <nyx/nyx_module.h>
+#include <nyx/module/nyx_utils.h>
+
+#undef nyx_info
+#define nyx_info(m, args...) {}
+#undef nyx_debug
+#define nyx_debug(m, args...) {}
+#undef nyx_error
+#define nyx_error(m, args...) {}
+
+// mock out externals defined in chargerlib.c
+nyx_device_t *nyxDev = NULL;
+void *charger_status_callback_context = NULL;
+void *state_change_callback_context = NULL;
+nyx_device_callback_function_t charger_status_callback = NULL;
+nyx_device_callback_function_t state_change_callback = NULL;
+
+// Pull in the unit under test
+#include "../charger.c"
+
+static gchar *test_dir = NULL;
+static int status_callbacks = 0;
+static int state_callbacks = 0;
+
+static void count_status_callback(nyx_device_handle_t handle, nyx_callback_status_t status,
+                                  void *context)
+{
+	status_callbacks++;
+}
+
+static void count_state_callback(nyx_device_handle_t handle, nyx_callback_status_t status,
+                                 void *context)
+{
+	state_callbacks++;
+}
+
+static void write_attr(const char *supply, const char *name, const char *contents)
+{
+	gchar *path = g_build_filename(test_dir, supply, name, NULL);
+
+	g_assert(g_file_set_contents(path, contents, -1, NULL));
+	g_free(path);
+}
+
+static void remove_attr(const char *supply, const char *name)
+{
+	gchar *path = g_build_filename(test_dir, supply, name, NULL);
+
+	g_unlink(path);
+	g_free(path);
+}
+
+/* A battery, usb and ac supply, named like the sysnames of their uevents */
+static void setup_charger_dir(void)
+{
+	const char *supplies[] = { "battery", "usb", "ac" };
+	gchar *battery, *usb, *ac;
+	unsigned int i;
+
+	test_dir = g_dir_make_tmp("charger-XXXXXX", NULL);
+	g_assert(test_dir != NULL);
+
+	for (i = 0; i < G_N_ELEMENTS(supplies); i++)
+	{
+		gchar *dir = g_build_filename(test_dir, supplies[i], NULL);
+
+		g_assert(g_mkdir_with_parents(dir, 0755) == 0);
+		g_free(dir);
+	}
+
+	write_attr("battery", "present", "1\n");
+	write_attr("battery", "status", "Discharging\n");
+	write_attr("usb", "uevent", "POWER_SUPPLY_ONLINE=0\n");
+	write_attr("ac", "uevent", "POWER_SUPPLY_ONLINE=0\n");
+
+	battery = g_build_filename(test_dir, "battery", NULL);
+	usb = g_build_filename(test_dir, "usb", NULL);
+	ac = g_build_filename(test_dir, "ac", NULL);
+
+	sysfs_attr_init(&batt_present, battery, "present");
+	sysfs_attr_init(&batt_status, battery, "status");
+	sysfs_attr_init(&batt_temperature, battery, "temp");
+	sysfs_attr_init(&batt_voltage, battery, "voltage_now");
+	sysfs_attr_init(&charger_usb_uevent, usb, "uevent");
+	sysfs_attr_init(&charger_ac_uevent, ac, "uevent");
+	sysfs_attr_init(&charger_touch_uevent, NULL, "uevent");
+	sysfs_attr_init(&charger_wireless_uevent, NULL, "uevent");
+
+	g_free(battery);
+	g_free(usb);
+	g_free(ac);
+
+	// What core_charger_init() does, without the uevent monitor
+	_charger_read_sources();
+	curr_battery_state = calloc(1, sizeof(nyx_battery_status_t));
+	_battery_read_status();
+	current_event = NYX_NO_NEW_EVENT;
+	_charger_init_events();
+	event_coalescer_init(&power_supply_events, 20, _flush_power_supply_events, NULL);
+
+	charger_status_callback = count_status_callback;
+	state_change_callback = count_state_callback;
+	status_callbacks = 0;
+	state_callbacks = 0;
+}
+
+static void teardown_charger_dir(void)
+{
+	const char *attrs[][2] =
+	{
+		{ "battery", "present" }, { "battery", "status" }, { "battery", "temp" },
+		{ "battery", "voltage_now" }, { "usb", "uevent" }, { "ac", "uevent" },
+	};
+	const char *supplies[] = { "battery", "usb", "ac" };
+	unsigned int i;
+
+	charger_status_callback = NULL;
+	state_change_callback = NULL;
+	_charger_cleanup();
+	current_event = NYX_NO_NEW_EVENT;
+
+	for (i = 0; i < G_N_ELEMENTS(attrs); i++)
+	{
+		remove_attr(attrs[i][0], attrs[i][1]);
+	}
+
+	for (i = 0; i < G_N_ELEMENTS(supplies); i++)
+	{
+		gchar *dir = g_build_filename(test_dir, supplies[i], NULL);
+
+		g_rmdir(dir);
+		g_free(dir);
+	}
+
+	g_rmdir(test_dir);
+	g_free(test_dir);
+	test_dir = NULL;
+}
+
+/* Deliver a uevent of sysname carrying the given key, value pairs */
+static void send_event(const char *sysname, ...)
+{
+	power_supply_event_t event;
+	const char *key;
+	va_list args;
+
+	memset(&event, 0, sizeof(event));
+	event.dev = (struct udev_device *) &event;
+	event.action = "change";
+	event.sysname = sysname;
+	event.has_values = true;
+
+	va_start(args, sysname);
+
+	while ((key = va_arg(args, const char *)) != NULL)
+	{
+		g_assert(power_supply_uevent_set(&event.values, key, va_arg(args, const char *)));
+	}
+
+	va_end(args);
+
+	_handle_power_supply_event(&event, NULL);
+}
+
+static void run_until_flushed(void)
+{
+	gint64 deadline = g_get_monotonic_time() + G_USEC_PER_SEC;
+
+	while (event_coalescer_pending(&power_supply_events) && g_get_monotonic_time() < deadline)
+	{
+		g_main_context_iteration(NULL, TRUE);
+	}
+}
+
+static nyx_charger_event_t transition(charge_state_t from, charge_state_t to,
+                                      nyx_charger_event_t before)
+{
+	current_event = before;
+	_has_charger_state_changed(from, to);
+	return current_event;
+}
+
+static void test_charger_transitions(void)
+{
+	charge_state_t from, to;
+
+	// Staying in a state never raises anything
+	for (from = 0; from < CHARGE_STATE_COUNT; from++)
+	{
+		g_assert(!_has_charger_state_changed(from, from));
+	}
+
+	// Neither do these
+	g_assert(!_has_charger_state_changed(CHARGE_STATE_CHARGING, CHARGE_STATE_DISCHARGING));
+	g_assert(!_has_charger_state_changed(CHARGE_STATE_DISCHARGING, CHARGE_STATE_CHARGING));
+	g_assert(!_has_charger_state_changed(CHARGE_STATE_DISCHARGING, CHARGE_STATE_FULL));
+	g_assert(!_has_charger_state_changed(CHARGE_STATE_FULL, CHARGE_STATE_DISCHARGING));
+
+	// Complete and restart replace each other, from Unknown as from Charging
+	g_assert_cmpint(transition(CHARGE_STATE_UNKNOWN, CHARGE_STATE_FULL, NYX_CHARGE_RESTART), ==,
+	                NYX_CHARGE_COMPLETE);
+	g_assert_cmpint(transition(CHARGE_STATE_CHARGING, CHARGE_STATE_FULL, NYX_CHARGE_RESTART), ==,
+	                NYX_CHARGE_COMPLETE);
+	g_assert_cmpint(transition(CHARGE_STATE_FULL, CHARGE_STATE_CHARGING, NYX_CHARGE_COMPLETE), ==,
+	                NYX_CHARGE_RESTART);
+
+	// Any state can fault, and the fault keeps the other events
+	for (from = 0; from < CHARGE_STATE_COUNT; from++)
+	{
+		if (from != CHARGE_STATE_FAULT)
+		{
+			g_assert_cmpint(transition(from, CHARGE_STATE_FAULT, NYX_CHARGER_CONNECTED), ==,
+			                NYX_CHARGER_CONNECTED | NYX_CHARGER_FAULT);
+		}
+	}
+
+	// Leaving the fault clears it; ending up full completes the charge as well
+	for (to = 0; to < CHARGE_STATE_COUNT; to++)
+	{
+		if (to != CHARGE_STATE_FAULT)
+		{
+			g_assert_cmpint(transition(CHARGE_STATE_FAULT, to, NYX_CHARGER_FAULT | NYX_CHARGE_RESTART), ==,
+			                to == CHARGE_STATE_FULL ? NYX_CHARGE_COMPLETE : NYX_CHARGE_RESTART);
+		}
+	}
+
+	// "Not charging" is a fault only with a charger online
+	battery_status = BATTERY_STATUS_NOT_CHARGING;
+	gChargerStatus.is_charging = true;
+	g_assert(_charge_state() == CHARGE_STATE_FAULT);
+	gChargerStatus.is_charging = false;
+	g_assert(_charge_state() == CHARGE_STATE_DISCHARGING);
+
+	g_assert(_parse_battery_status("Full") == BATTERY_STATUS_FULL);
+	g_assert(_parse_battery_status("Charging") == BATTERY_STATUS_CHARGING);
+	g_assert(_parse_battery_status("Unknown") == BATTERY_STATUS_UNKNOWN);
+	g_assert(_parse_battery_status("") == BATTERY_STATUS_UNKNOWN);
+
+	battery_status = BATTERY_STATUS_UNKNOWN;
+	current_event = NYX_NO_NEW_EVENT;
+}
+
+static void test_charger_flush_events(void)
+{
+	uint32_t raw, delivered;
+
+	setup_charger_dir();
+	g_assert_cmpint(current_event, ==, NYX_BATTERY_PRESENT);
+
+	// A plug touches usb and battery: one evaluation, one call of each callback
+	send_event("usb", "POWER_SUPPLY_ONLINE", "1", "POWER_SUPPLY_CURRENT_MAX", "500000", NULL);
+	send_event("battery", "POWER_SUPPLY_STATUS", "Discharging", NULL);
+	send_event("battery", "POWER_SUPPLY_STATUS", "Charging", NULL);
+	g_assert(event_coalescer_pending(&power_supply_events));
+	g_assert_cmpint(state_callbacks, ==, 0);
+
+	// The cached state follows every event of the burst at once
+	g_assert(gChargerStatus.is_charging);
+	g_assert(battery_status == BATTERY_STATUS_CHARGING);
+
+	run_until_flushed();
+	g_assert_cmpint(status_callbacks, ==, 1);
+	g_assert_cmpint(state_callbacks, ==, 1);
+	g_assert_cmpint(current_event, ==, NYX_BATTERY_PRESENT | NYX_CHARGER_CONNECTED);
+	g_assert_cmpuint(power_supply_events.evaluations, ==, 1);
+
+	core_charger_get_event_counters(&raw, &delivered);
+	g_assert_cmpuint(raw, ==, 3);
+	g_assert_cmpuint(delivered, ==, 1);
+
+	// A burst that ends where it started calls nobody
+	send_event("battery", "POWER_SUPPLY_STATUS", "Discharging", NULL);
+	send_event("battery", "POWER_SUPPLY_STATUS", "Charging", NULL);
+	run_until_flushed();
+	g_assert_cmpint(state_callbacks, ==, 1);
+
+	// Online but not charging is a fault, until charging resumes
+	send_event("battery", "POWER_SUPPLY_STATUS", "Not charging", NULL);
+	run_until_flushed();
+	g_assert_cmpint(state_callbacks, ==, 2);
+	g_assert(current_event & NYX_CHARGER_FAULT);
+
+	send_event("battery", "POWER_SUPPLY_STATUS", "Charging", NULL);
+	run_until_flushed();
+	g_assert_cmpint(state_callbacks, ==, 3);
+	g_assert(!(current_event & NYX_CHARGER_FAULT));
+
+	send_event("battery", "POWER_SUPPLY_STATUS", "Full", NULL);
+	run_until_flushed();
+	g_assert_cmpint(state_callbacks, ==, 4);
+	g_assert(current_event & NYX_CHARGE_COMPLETE);
+
+	// Unplugging is read back from sysfs when the event has no values
+	write_attr("usb", "uevent", "POWER_SUPPLY_ONLINE=0\n");
+	write_attr("battery", "status", "Discharging\n");
+	send_event("usb", NULL);
+	run_until_flushed();
+	g_assert_cmpint(status_callbacks, ==, 2);
+	g_assert_cmpint(state_callbacks, ==, 5);
+	g_assert(current_event & NYX_CHARGER_DISCONNECTED);
+	g_assert(!gChargerStatus.is_charging);
+	g_assert(battery_status == BATTERY_STATUS_DISCHARGING);
+
+	teardown_charger_dir();
+}
+
+static void write_limits(int temperature, int voltage)
+{
+	gchar *value = g_strdup_printf("%d\n", temperature);
+
+	write_attr("battery", "temp", value);
+	g_free(value);
+
+	value = g_strdup_printf("%d\n", voltage);
+	write_attr("battery", "voltage_now", value);
+	g_free(value);
+}
+
+static void test_charger_sampler(void)
+{
+	const int max_temperature = BATTERY_CHARGE_MAX_TEMPERATURE_C * 10;
+	const int critical_voltage = BATTERY_CRITICAL_VOLTAGE_MV * 1000;
+
+	// The closer to a limit, the faster; values that could not be read do not count
+	g_assert_cmpuint(_charger_sampler_interval(false, 0, false, 0), ==, CHARGER_SAMPLER_SLOW_S);
+	g_assert_cmpuint(_charger_sampler_interval(true, 250, true, 3900000), ==, CHARGER_SAMPLER_SLOW_S);
+	g_assert_cmpuint(_charger_sampler_interval(true, max_temperature - 100, true, 3900000), ==,
+	                 CHARGER_SAMPLER_MEDIUM_S);
+	g_assert_cmpuint(_charger_sampler_interval(true, 20, true, 3900000), ==, CHARGER_SAMPLER_FAST_S);
+	g_assert_cmpuint(_charger_sampler_interval(true, 250, true, critical_voltage + 200000), ==,
+	                 CHARGER_SAMPLER_MEDIUM_S);
+	g_assert_cmpuint(_charger_sampler_interval(true, 250, true, critical_voltage + 50000), ==,
+	                 CHARGER_SAMPLER_FAST_S);
+	g_assert_cmpuint(_charger_sampler_interval(false, 20, true, 3900000), ==, CHARGER_SAMPLER_SLOW_S);
+
+	setup_charger_dir();
+	current_event = NYX_NO_NEW_EVENT;
+
+	write_limits(250, 3900000);
+	g_assert_cmpuint(_charger_sample_limits(), ==, CHARGER_SAMPLER_SLOW_S);
+	g_assert_cmpint(current_event, ==, NYX_NO_NEW_EVENT);
+	g_assert_cmpint(state_callbacks, ==, 0);
+
+	// Entering a limit calls back once
+	write_limits(max_temperature + 1, 3900000);
+	g_assert_cmpuint(_charger_sample_limits(), ==, CHARGER_SAMPLER_FAST_S);
+	g_assert_cmpint(current_event, ==, NYX_BATTERY_TEMPERATURE_LIMIT);
+	g_assert_cmpint(state_callbacks, ==, 1);
+	_charger_sample_limits();
+	g_assert_cmpint(state_callbacks, ==, 1);
+
+	// Back inside but within the hysteresis it stays set
+	write_limits(max_temperature - CHARGER_LIMIT_TEMPERATURE_HYSTERESIS / 2, 3900000);
+	_charger_sample_limits();
+	g_assert_cmpint(current_event, ==, NYX_BATTERY_TEMPERATURE_LIMIT);
+	g_assert_cmpint(state_callbacks, ==, 1);
+
+	write_limits(max_temperature - CHARGER_LIMIT_TEMPERATURE_HYSTERESIS - 1, 3900000);
+	_charger_sample_limits();
+	g_assert_cmpint(current_event, ==, NYX_NO_NEW_EVENT);
+	g_assert_cmpint(state_callbacks, ==, 2);
+
+	// Same for the voltage
+	write_limits(250, critical_voltage - 1);
+	_charger_sample_limits();
+	g_assert_cmpint(current_event, ==, NYX_BATTERY_CRITICAL_VOLTAGE);
+	write_limits(250, critical_voltage + CHARGER_LIMIT_VOLTAGE_HYSTERESIS / 2);
+	_charger_sample_limits();
+	g_assert_cmpint(current_event, ==, NYX_BATTERY_CRITICAL_VOLTAGE);
+	write_limits(250, critical_voltage + CHARGER_LIMIT_VOLTAGE_HYSTERESIS + 1);
+	_charger_sample_limits();
+	g_assert_cmpint(current_event, ==, NYX_NO_NEW_EVENT);
+	g_assert_cmpint(state_callbacks, ==, 4);
+
+	// Runs only while someone listens to a present battery, and calls back
+	// from the main loop rather than from the call that started it
+	write_limits(max_temperature + 1, 3900000);
+	listening = true;
+	core_charger_update_sampler();
+	g_assert(sampler_timer != 0);
+	g_assert_cmpint(state_callbacks, ==, 4);
+
+	g_main_context_iteration(NULL, FALSE);
+	g_assert_cmpint(state_callbacks, ==, 5);
+	g_assert_cmpint(current_event, ==, NYX_BATTERY_TEMPERATURE_LIMIT);
+	g_assert_cmpuint(sampler_interval, ==, CHARGER_SAMPLER_FAST_S);
+	g_assert(sampler_timer != 0);
+
+	write_attr("battery", "present", "0\n");
+	send_event("battery", "POWER_SUPPLY_PRESENT", "0", NULL);
+	run_until_flushed();
+	g_assert(current_event & NYX_BATTERY_ABSENT);
+	g_assert(sampler_timer == 0);
+
+	// The cleanup would remove the uevent listener it never added
+	listening = false;
+	teardown_charger_dir();
+}
+
+static void test_charger_source(void)
+{
+	nyx_charger_source_t source;
+	nyx_charger_status_t status;
+
+	setup_charger_dir();
+
+	// Offline sources negotiated nothing
+	core_charger_query_source(NYX_CHARGER_SOURCE_USB, &source);
+	g_assert(!source.online);
+	g_assert_cmpint(source.power_max, ==, 0);
+
+	// A USB source without voltage_max is taken at 5 V
+	write_attr("usb", "uevent",
+	           "POWER_SUPPLY_ONLINE=1\n"
+	           "POWER_SUPPLY_CURRENT_MAX=500000\n"
+	           "POWER_SUPPLY_USB_TYPE=Unknown [SDP] DCP CDP\n");
+	_charger_read_sources();
+	core_charger_query_source(NYX_CHARGER_SOURCE_USB, &source);
+	g_assert(source.online);
+	g_assert_cmpint(source.current_max, ==, 500000);
+	g_assert_cmpint(source.voltage_max, ==, 0);
+	g_assert_cmpint(source.power_max, ==, 2500);
+	g_assert_cmpstr(source.usb_type, ==, "SDP");
+
+	core_charger_read_status(&status);
+	g_assert_cmpint(status.charger_max_current, ==, 500);
+	g_assert_cmpint(status.connected, ==, NYX_CHARGER_PC_CONNECTED);
+	g_assert_cmpint(status.powered, ==, NYX_CHARGER_USB_POWERED);
+
+	// A uevent with values replaces the snapshot without reading sysfs
+	send_event("usb", "POWER_SUPPLY_ONLINE", "1", "POWER_SUPPLY_CURRENT_MAX", "3000000",
+	           "POWER_SUPPLY_VOLTAGE_MAX", "9000000", "POWER_SUPPLY_USB_TYPE", "PD", NULL);
+	core_charger_query_source(NYX_CHARGER_SOURCE_USB, &source);
+	g_assert_cmpint(source.voltage_max, ==, 9000000);
+	g_assert_cmpint(source.power_max, ==, 27000);
+	g_assert_cmpstr(source.usb_type, ==, "PD");
+	g_assert_cmpint(gChargerStatus.charger_max_current, ==, 3000);
+
+	// Mains without current_max is online at an unknown power
+	send_event("ac", "POWER_SUPPLY_ONLINE", "1", NULL);
+	core_charger_query_source(NYX_CHARGER_SOURCE_AC, &source);
+	g_assert(source.online);
+	g_assert_cmpint(source.power_max, ==, 0);
+	g_assert_cmpstr(source.usb_type, ==, "");
+
+	// Sources that are not there read as offline
+	core_charger_query_source(NYX_CHARGER_SOURCE_WIRELESS, &source);
+	g_assert(!source.online);
+	g_assert(!(gChargerStatus.connected & NYX_CHARGER_INDUCTIVE_CONNECTED));
+
+	run_until_flushed();
+	teardown_charger_dir();
+
+	core_charger_query_source(NYX_CHARGER_SOURCE_USB, &source);
+	g_assert(!source.online);
+}
+
+int main(int argc, char **argv)
+{
+	g_test_init(&argc, &argv, NULL);
+
+	g_test_add_func("/charger/transitions", test_charger_transitions);
+	g_test_add_func("/charger/uevent/flush_events", test_charger_flush_events);
+	g_test_add_func("/charger/sampler", test_charger_sampler);
+	g_test_add_func("/charger/source", test_charger_source);
+
+	return g_test_run();
+}
@@ -27,6 +27,8 @@
 
 #include "parser_interface.h"
 #include "gps_storage.h"
+#include "gps_batch.h"
+#include "gps_session.h"
 
 NYX_DECLARE_MODULE(NYX_DEVICE_GPS, "Gps");
 
@@ -89,6 +91,11 @@ nyx_gps_sv_status_t         *nyx_gps_sv_status = NULL;
 char                        *nmea_sentence = NULL;
 int                         nmea_length = 0;
 
+nyx_gps_location_t          *nyx_gps_batch = NULL;
+uint32_t                    nyx_gps_batch_length = 0;
+nyx_gps_batch_callback_t    nyx_gps_batch_cb = NULL;
+void                        *nyx_gps_batch_user_data = NULL;
+
 void gps_location_cb(GpsLocation* location)
 {
     if (nyx_gps_cbs == NULL || nyx_gps_cbs->location_cb == NULL)
@@ -114,6 +121,38 @@ void gps_location_cb(GpsLocation* location)
     (* (nyx_gps_cbs->location_cb))(nyx_gps_location, nyx_gps_cbs->user_data);
 }
 
+void gps_batch_cb(GpsLocation* locations, uint32_t count)
+{
+    uint32_t i;
+
+    if (nyx_gps_batch_cb == NULL || locations == NULL || count == 0)
+        return;
+
+    if (nyx_gps_batch_length < count) {
+        nyx_gps_location_t *batch = (nyx_gps_location_t *)realloc(nyx_gps_batch, count * sizeof(nyx_gps_location_t));
+        if (batch == NULL)
+            return;
+        nyx_gps_batch = batch;
+        nyx_gps_batch_length = count;
+    }
+
+    memset(nyx_gps_batch, 0, count * sizeof(nyx_gps_location_t));
+    for (i = 0; i < count; i++) {
+        nyx_gps_batch[i].size = sizeof(nyx_gps_location_t);
+        nyx_gps_batch[i].flags = (nyx_gps_location_flags_t)locations[i].flags;
+        nyx_gps_batch[i].latitude = locations[i].latitude;
+        nyx_gps_batch[i].longitude = locations[i].longitude;
+        nyx_gps_batch[i].altitude = locations[i].altitude;
+        nyx_gps_batch[i].speed = locations[i].speed;
+        nyx_gps_batch[i].bearing = locations[i].bearing;
+        nyx_gps_batch[i].accuracy = locations[i].accuracy;
+        nyx_gps_batch[i].vertical_accuracy = -1.0;
+        nyx_gps_batch[i].timestamp = (int64_t)locations[i].timestamp;
+    }
+
+    (* nyx_gps_batch_cb)(nyx_gps_batch, count, nyx_gps_batch_user_data);
+}
+
 void gps_status_cb(GpsStatus* status)
 {
     if (nyx_gps_cbs == NULL || nyx_gps_cbs->status_cb == NULL)
@@ -360,6 +399,12 @@ nyx_error_t nyx_module_close(nyx_device_t *device)
         nmea_length = 0;
     }
 
+    if (nyx_gps_batch != NULL) {
+        free(nyx_gps_batch);
+        nyx_gps_batch = NULL;
+        nyx_gps_batch_length = 0;
+    }
+
     if (pGpsInterface) {
         pGpsInterface = NULL;
     }
@@ -577,6 +622,97 @@ nyx_error_t set_position_mode(nyx_device_handle_t handle,
                               uint32_t preferred_accuracy,
                               uint32_t preferred_time)
 {
+    if (nyx_dev == NULL)
+        return NYX_ERROR_DEVICE_NOT_EXIST;
+
+    if (handle != nyx_dev)
+        return NYX_ERROR_INVALID_HANDLE;
+
+    if (!pGpsInterface || pGpsInterface->set_position_mode(mode, recurrence, min_interval,
+                                                           preferred_accuracy, preferred_time) != 0)
+        return NYX_ERROR_DEVICE_UNAVAILABLE;
+
+    return NYX_ERROR_NONE;
+}
+
+nyx_error_t set_batching(nyx_device_handle_t handle,
+                         uint32_t batch_size,
+                         uint32_t period_ms,
+                         nyx_gps_batch_callback_t batch_cb,
+                         void *user_data)
+{
+    if (nyx_dev == NULL)
+        return NYX_ERROR_DEVICE_NOT_EXIST;
+
+    if (handle != nyx_dev)
+        return NYX_ERROR_INVALID_HANDLE;
+
+    if ((batch_size || period_ms) && batch_cb == NULL)
+        return NYX_ERROR_INVALID_VALUE;
+
+    if (!pGpsInterface)
+        return NYX_ERROR_DEVICE_UNAVAILABLE;
+
+    nyx_gps_batch_callback_t old_cb = nyx_gps_batch_cb;
+    void *old_user_data = nyx_gps_batch_user_data;
+
+    if (batch_size || period_ms) {
+        // What the old settings queued still goes to the old callback
+        if (old_cb)
+            pGpsInterface->flush_batch();
+
+        nyx_gps_batch_cb = batch_cb;
+        nyx_gps_batch_user_data = user_data;
+    }
+
+    if (pGpsInterface->set_batching(batch_size, period_ms, gps_batch_cb) != 0) {
+        // Rejected settings leave the running batcher, if any, as it was
+        nyx_gps_batch_cb = old_cb;
+        nyx_gps_batch_user_data = old_user_data;
+        return NYX_ERROR_INVALID_VALUE;
+    }
+
+    // Disabling flushes the last batch to the old callback first
+    if (!batch_size && !period_ms) {
+        nyx_gps_batch_cb = NULL;
+        nyx_gps_batch_user_data = NULL;
+    }
+
+    return NYX_ERROR_NONE;
+}
+
+nyx_error_t flush_batch(nyx_device_handle_t handle)
+{
+    if (nyx_dev == NULL)
+        return NYX_ERROR_DEVICE_NOT_EXIST;
+
+    if (handle != nyx_dev)
+        return NYX_ERROR_INVALID_HANDLE;
+
+    if (!pGpsInterface || pGpsInterface->flush_batch() != 0)
+        return NYX_ERROR_DEVICE_UNAVAILABLE;
+
+    return NYX_ERROR_NONE;
+}
+
+nyx_error_t get_session_stats(nyx_device_handle_t handle,
+                              nyx_gps_session_stats_t *stats,
+                              uint32_t max,
+                              uint32_t *count)
+{
+    if (nyx_dev == NULL)
+        return NYX_ERROR_DEVICE_NOT_EXIST;
+
+    if (handle != nyx_dev)
+        return NYX_ERROR_INVALID_HANDLE;
+
+    if ((stats == NULL && max) || count == NULL)
+        return NYX_ERROR_INVALID_VALUE;
+
+    if (!pGpsInterface)
+        return NYX_ERROR_DEVICE_UNAVAILABLE;
+
+    *count = pGpsInterface->get_session_stats(stats, max);
     return NYX_ERROR_NONE;
 }
 
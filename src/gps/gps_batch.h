@@ -0,0 +1,79 @@
+/* @@@LICENSE
+*
+* Copyright (c) 2024 LG Electronics, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* SPDX-License-Identifier: Apache-2.0
+*
+* LICENSE@@@ */
+
+/*
+* Batched location delivery of the GPS module.
+*
+* Installed as <nyx-gps/gps_batch.h>. nyx-lib fixes the method table of a
+* module, so these are not nyx methods; clients look them up in the GPS
+* module nyx_device_open() loaded and call them with the handle they got:
+*
+*     void *module = dlopen(<gps module library>, RTLD_NOW | RTLD_NOLOAD);
+*     gps_set_batching_function_t set_batching =
+*         (gps_set_batching_function_t) dlsym(module, GPS_SET_BATCHING_SYMBOL);
+*     gps_flush_batch_function_t flush_batch =
+*         (gps_flush_batch_function_t) dlsym(module, GPS_FLUSH_BATCH_SYMBOL);
+*******************************************************************/
+
+#ifndef _GPS_BATCH_H_
+#define _GPS_BATCH_H_
+
+#include <nyx/nyx_module.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Receives one batch of fixes, oldest first. The array is only valid for
+ * the duration of the call.
+ */
+typedef void (*nyx_gps_batch_callback_t)(nyx_gps_location_t *locations, uint32_t count, void *user_data);
+
+/**
+ * Enable batched location delivery: while enabled, fixes are not reported
+ * through location_cb but queued and handed to batch_cb once batch_size
+ * fixes are queued or every period_ms, whichever comes first. Either may
+ * be 0 to disable that trigger; both 0 turns batching off after flushing.
+ */
+nyx_error_t set_batching(nyx_device_handle_t handle,
+                         uint32_t batch_size,
+                         uint32_t period_ms,
+                         nyx_gps_batch_callback_t batch_cb,
+                         void *user_data);
+
+/**
+ * Deliver the queued fixes now.
+ */
+nyx_error_t flush_batch(nyx_device_handle_t handle);
+
+#define GPS_SET_BATCHING_SYMBOL "set_batching"
+typedef nyx_error_t (*gps_set_batching_function_t)(nyx_device_handle_t handle,
+        uint32_t batch_size, uint32_t period_ms, nyx_gps_batch_callback_t batch_cb,
+        void *user_data);
+
+#define GPS_FLUSH_BATCH_SYMBOL "flush_batch"
+typedef nyx_error_t (*gps_flush_batch_function_t)(nyx_device_handle_t handle);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // _GPS_BATCH_H_
@@ -0,0 +1,291 @@
+/* @@@LICENSE
+ * *
+ * * Copyright (c) 2024 LG Electronics, Inc.
+ * *
+ * * Licensed under the Apache License, Version 2.0 (the "License");
+ * * you may not use this file except in compliance with the License.
+ * * You may obtain a copy of the License at
+ * *
+ * * http://www.apache.org/licenses/LICENSE-2.0
+ * *
+ * * Unless required by applicable law or agreed to in writing, software
+ * * distributed under the License is distributed on an "AS IS" BASIS,
+ * * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * * See the License for the specific language governing permissions and
+ * * limitations under the License.
+ * * SPDX-License-Identifier: Apache-2.0
+ * *
+ * * LICENSE@@@ */
+
+/*
+ * *******************************************************************/
+
+#include <cmath>
+#include <cstring>
+
+#include <nyx/module/nyx_log.h>
+#include "gps_batcher.h"
+#include "gps_device.h"
+#include "gps_storage.h"
+
+GpsBatcher::GpsBatcher()
+    : mHead(0)
+    , mCount(0)
+    , mDropped(0)
+    , mBatchSize(0)
+    , mPeriodMs(0)
+    , mPeriodTimerId(0)
+    , mActive(false)
+    , mCallback(nullptr)
+    , mDelivering(false)
+{
+}
+
+GpsBatcher::~GpsBatcher()
+{
+    if (mPeriodTimerId)
+        g_source_remove(mPeriodTimerId);
+}
+
+GpsBatcher *GpsBatcher::getInstance()
+{
+    static GpsBatcher gpsBatcherObj;
+    return &gpsBatcherObj;
+}
+
+void GpsBatcher::init(const std::string &configFile)
+{
+    GKeyFile *keyfile = load_conf_file(configFile.c_str());
+    if (!keyfile)
+        return;
+
+    double tolerance = g_key_file_get_double(keyfile, GPS_DEVICE_INFO, "BATCH_TRACK_TOLERANCE", NULL);
+    g_key_file_free(keyfile);
+
+    setTrackTolerance(tolerance);
+}
+
+void GpsBatcher::setTrackTolerance(double toleranceMeters)
+{
+    std::lock_guard<std::mutex> lock(mLock);
+
+    mSimplifier.reset();
+    mSimplifier.setTolerance(toleranceMeters > 0 ? toleranceMeters : 0);
+}
+
+bool GpsBatcher::configure(unsigned int batchSize, unsigned int periodMs, gps_batch_callback callback)
+{
+    if (!callback || batchSize > GPS_BATCH_MAX_SIZE || (!batchSize && !periodMs))
+        return false;
+
+    // Whatever was queued under the old settings goes out first
+    flush();
+
+    std::lock_guard<std::mutex> lock(mLock);
+    mBatchSize = batchSize;
+    mPeriodMs = periodMs;
+    mCallback = callback;
+    mActive = true;
+
+    if (mPeriodTimerId)
+    {
+        g_source_remove(mPeriodTimerId);
+        mPeriodTimerId = 0;
+    }
+
+    nyx_info("GPS_BATCH", 0, "batching enabled, size: %u, period: %u ms", batchSize, periodMs);
+    return true;
+}
+
+void GpsBatcher::disable()
+{
+    if (!mActive)
+        return;
+
+    flush();
+
+    std::lock_guard<std::mutex> lock(mLock);
+    if (mPeriodTimerId)
+    {
+        g_source_remove(mPeriodTimerId);
+        mPeriodTimerId = 0;
+    }
+
+    mActive = false;
+    mCallback = nullptr;
+    mHead = mCount = 0;
+    mSimplifier.reset();
+
+    nyx_info("GPS_BATCH", 0, "batching disabled, %u fixes dropped", mDropped);
+    mDropped = 0;
+}
+
+void GpsBatcher::add(const GpsLocation *location)
+{
+    bool full = false;
+
+    if (!location)
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(mLock);
+        if (!mActive)
+            return;
+
+        // Armed by the first held fix, the period counts from there
+        if (mPeriodMs && !mPeriodTimerId)
+            mPeriodTimerId = g_timeout_add(mPeriodMs, periodCallback, this);
+
+        if (mSimplifier.getTolerance() > 0)
+        {
+            GpsLocation kept;
+            if (!mSimplifier.add(*location, kept))
+                return;
+            queue(&kept);
+        }
+        else
+        {
+            queue(location);
+        }
+
+        full = mBatchSize && mCount >= mBatchSize;
+    }
+
+    if (full)
+        flush();
+}
+
+void GpsBatcher::flush()
+{
+    {
+        std::lock_guard<std::mutex> lock(mLock);
+        if (!mActive)
+            return;
+
+        if (mPeriodTimerId)
+        {
+            g_source_remove(mPeriodTimerId);
+            mPeriodTimerId = 0;
+        }
+
+        // A held-back fix is the current end of the track, deliver it too
+        GpsLocation last;
+        if (mSimplifier.flush(last))
+            queue(&last);
+
+        if (mCount)
+        {
+            Batch batch;
+            batch.callback = mCallback;
+            batch.fixes.resize(mCount);
+            for (unsigned int i = 0; i < mCount; i++)
+                unpack(&mRing[(mHead + i) % GPS_BATCH_MAX_SIZE], &batch.fixes[i]);
+
+            mBatches.push_back(std::move(batch));
+            mHead = mCount = 0;
+        }
+
+        // Someone up the stack is already delivering and will pick this up
+        if (mDelivering || mBatches.empty())
+            return;
+        mDelivering = true;
+    }
+
+    deliver();
+}
+
+void GpsBatcher::deliver()
+{
+    for (;;)
+    {
+        Batch batch;
+        {
+            std::lock_guard<std::mutex> lock(mLock);
+            if (mBatches.empty())
+            {
+                mDelivering = false;
+                return;
+            }
+            batch = std::move(mBatches.front());
+            mBatches.pop_front();
+        }
+
+        // Fixes keep queueing while the client consumes this batch
+        batch.callback(batch.fixes.data(), batch.fixes.size());
+    }
+}
+
+void GpsBatcher::queue(const GpsLocation *location)
+{
+    pack(location, &mRing[(mHead + mCount) % GPS_BATCH_MAX_SIZE]);
+    if (mCount < GPS_BATCH_MAX_SIZE)
+    {
+        mCount++;
+    }
+    else
+    {
+        // Oldest fix was just overwritten
+        mHead = (mHead + 1) % GPS_BATCH_MAX_SIZE;
+        mDropped++;
+    }
+}
+
+unsigned int GpsBatcher::getPending()
+{
+    std::lock_guard<std::mutex> lock(mLock);
+    return mCount;
+}
+
+unsigned int GpsBatcher::getDropped()
+{
+    std::lock_guard<std::mutex> lock(mLock);
+    return mDropped;
+}
+
+gboolean GpsBatcher::periodCallback(gpointer user_data)
+{
+    GpsBatcher *ptr = (GpsBatcher *)user_data;
+
+    {
+        // flush() may already have replaced this timer with a newer one
+        std::lock_guard<std::mutex> lock(ptr->mLock);
+        if (ptr->mPeriodTimerId == g_source_get_id(g_main_current_source()))
+            ptr->mPeriodTimerId = 0;
+    }
+
+    ptr->flush();
+    return FALSE;
+}
+
+static uint16_t clampU16(double value)
+{
+    if (!(value > 0))
+        return 0;
+    return value >= UINT16_MAX ? UINT16_MAX : (uint16_t)lround(value);
+}
+
+void GpsBatcher::pack(const GpsLocation *location, gps_batch_record_t *record)
+{
+    record->timestamp = location->timestamp;
+    record->latitude = (int32_t)lround(location->latitude * 1e7);
+    record->longitude = (int32_t)lround(location->longitude * 1e7);
+    record->altitude = (int32_t)lround(location->altitude * 100);
+    record->speed = clampU16(location->speed * 100);
+    record->bearing = clampU16(location->bearing * 100);
+    record->accuracy = clampU16(location->accuracy * 10);
+    record->flags = location->flags;
+}
+
+void GpsBatcher::unpack(const gps_batch_record_t *record, GpsLocation *location)
+{
+    memset(location, 0, sizeof(GpsLocation));
+    location->size = sizeof(GpsLocation);
+    location->timestamp = record->timestamp;
+    location->latitude = record->latitude / 1e7;
+    location->longitude = record->longitude / 1e7;
+    location->altitude = record->altitude / 100.0;
+    location->speed = record->speed / 100.0f;
+    location->bearing = record->bearing / 100.0f;
+    location->accuracy = record->accuracy / 10.0f;
+    location->flags = record->flags;
+}
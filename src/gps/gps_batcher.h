@@ -0,0 +1,114 @@
+/* @@@LICENSE
+ * *
+ * * Copyright (c) 2024 LG Electronics, Inc.
+ * *
+ * * Licensed under the Apache License, Version 2.0 (the "License");
+ * * you may not use this file except in compliance with the License.
+ * * You may obtain a copy of the License at
+ * *
+ * * http://www.apache.org/licenses/LICENSE-2.0
+ * *
+ * * Unless required by applicable law or agreed to in writing, software
+ * * distributed under the License is distributed on an "AS IS" BASIS,
+ * * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * * See the License for the specific language governing permissions and
+ * * limitations under the License.
+ * * SPDX-License-Identifier: Apache-2.0
+ * *
+ * * LICENSE@@@ */
+
+/*
+ * *******************************************************************/
+
+#ifndef _GPS_BATCHER_H_
+#define _GPS_BATCHER_H_
+
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <glib.h>
+
+#include "parser_interface.h"
+#include "track_simplifier.h"
+
+constexpr unsigned int GPS_BATCH_MAX_SIZE = 256;
+
+/*
+ * Compact form of a fix while it waits in the batch ring, a fraction of the
+ * size of GpsLocation. Resolution: 1e-7 deg, 1 cm, 1 cm/s, 0.01 deg, 0.1 m.
+ */
+typedef struct {
+    int64_t  timestamp;
+    int32_t  latitude;
+    int32_t  longitude;
+    int32_t  altitude;
+    uint16_t speed;
+    uint16_t bearing;
+    uint16_t accuracy;
+    uint16_t flags;
+} gps_batch_record_t;
+
+/*
+ * Holds fixes instead of reporting them one by one, and hands them to the
+ * batch callback as one array when batchSize fixes are queued, when
+ * periodMs expires or on flush(). With batchSize 0 only the period and
+ * explicit flushes deliver; the ring then keeps the newest
+ * GPS_BATCH_MAX_SIZE fixes. The period timer only runs while a fix is
+ * held, so an idle batcher does not wake the main loop.
+ *
+ * The callback is invoked without any batcher lock held and may call back
+ * into configure(), flush() or disable(); batches taken meanwhile are
+ * delivered in order once it returns.
+ *
+ * With a track tolerance set, fixes pass through a TrackSimplifier before
+ * they are queued, so straight stretches cost a couple of records.
+ *     [GPSDEVICE]
+ *     BATCH_TRACK_TOLERANCE=5.0
+ */
+class GpsBatcher
+{
+public:
+    static GpsBatcher *getInstance();
+    void init(const std::string &configFile);
+    void setTrackTolerance(double toleranceMeters);
+    bool configure(unsigned int batchSize, unsigned int periodMs, gps_batch_callback callback);
+    void disable();
+    bool isActive() const { return mActive; }
+    void add(const GpsLocation *location);
+    void flush();
+    unsigned int getPending();
+    unsigned int getDropped();
+
+    static void pack(const GpsLocation *location, gps_batch_record_t *record);
+    static void unpack(const gps_batch_record_t *record, GpsLocation *location);
+
+private:
+    GpsBatcher();
+    ~GpsBatcher();
+    void queue(const GpsLocation *location);
+    void deliver();
+    static gboolean periodCallback(gpointer);
+
+    struct Batch {
+        gps_batch_callback callback;
+        std::vector<GpsLocation> fixes;
+    };
+
+    gps_batch_record_t mRing[GPS_BATCH_MAX_SIZE];
+    unsigned int mHead;
+    unsigned int mCount;
+    unsigned int mDropped;
+    unsigned int mBatchSize;
+    unsigned int mPeriodMs;
+    guint mPeriodTimerId;
+    std::atomic<bool> mActive;
+    gps_batch_callback mCallback;
+    std::deque<Batch> mBatches;
+    bool mDelivering;
+    TrackSimplifier mSimplifier;
+    std::mutex mLock;
+};
+
+#endif // _GPS_BATCHER_H_
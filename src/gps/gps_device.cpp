@@ -27,26 +27,20 @@
 #include "gps_storage.h"
 
 GPSDevice::GPSDevice()
-    : mFd(INVALID_FD)
-    , mGpsDevAvail(false)
-    , mReadChannel(nullptr)
-    , mIoWatchId(0)
+    : mGpsDevAvail(false)
     , mKeyfile(nullptr)
+    , mConfigFile(GPS_CONFIG_FILE)
+    , mStandby(false)
+    , mStandbyTimeout(0)
+    , mStandbyTimerId(0)
 {
 }
 
 GPSDevice::~GPSDevice()
 {
-    if (mReadChannel)
-    {
-        g_io_channel_shutdown(mReadChannel, true, NULL);
-        g_io_channel_unref(mReadChannel);
-        mReadChannel = NULL;
-    }
-    if (mFd != INVALID_FD)
-    {
-        close(mFd);
-    }
+    if (mStandbyTimerId)
+        g_source_remove(mStandbyTimerId);
+    mSource.reset();
     mData.clear();
 }
 
@@ -61,101 +55,73 @@ bool GPSDevice::isGpsDevAvail()
     return mGpsDevAvail;
 }
 
-void GPSDevice::handleGpsData()
+void GPSDevice::handleGpsData(size_t len)
 {
     CNMEAParserData::ERROR_E nErr;
 
-    if (!mData.empty() && mData.find("\r") != std::string::npos)
+    if ((nErr = processNmeaData(&mData[0], len)) != CNMEAParserData::ERROR_OK)
     {
-        std::string recvData = mData.replace(mData.find("\r"), mData.length(), "");
-        if ((nErr = CNMEAParser::ProcessNMEABuffer(const_cast<char *>(recvData.c_str()), recvData.length())) != CNMEAParserData::ERROR_OK)
-        {
-            nyx_error("GPS_DEVICE", 0, "ProcessNMEABuffer failed, error: %d \n", nErr);
-        }
+        nyx_error("GPS_DEVICE", 0, "ProcessNMEABuffer failed, error: %d \n", nErr);
     }
 }
 
-gboolean GPSDevice::readGpsData(GIOChannel *io, GIOCondition condition)
+void GPSDevice::readGpsData(const char *data, gsize len)
 {
+    nyx_debug("GPS_DEVICE : %s msg:[%.*s]", __FUNCTION__, (int)len, data);
+    mData.append(data, len);
 
-    char msg[MAX_BUFFER_SIZE + 1] = {0};
-    GError *err = NULL;
-    gsize len = 0;
-    if (G_IO_STATUS_NORMAL == g_io_channel_read_chars(io, msg, sizeof(msg), &len, &err))
+    // Hand over every complete sentence, keep the partial tail for the next read
+    size_t end = mData.rfind('\n');
+    if (end == std::string::npos)
     {
-        std::string temp = msg;
-        nyx_debug("GPS_DEVICE : %s msg:[%s]", __FUNCTION__, msg);
-        mData += temp;
-        if (!mData.empty() && mData.find("\n") != std::string::npos)
-        {
-            nyx_debug("GPS_DEVICE : %s received gps data:[%s]", __FUNCTION__, mData.c_str());
-            handleGpsData();
+        // A sentence is at most 82 chars; this much without a line end is noise
+        if (mData.size() > MAX_BUFFER_SIZE)
             mData.clear();
-        }
-        return TRUE;
+        return;
     }
-    return FALSE;
-}
-
-gboolean GPSDevice::ioCallback(GIOChannel *io, GIOCondition condition, gpointer user_data)
-{
 
-    GPSDevice *ptr = (GPSDevice *)user_data;
-    return ptr->readGpsData(io, condition);
+    nyx_debug("GPS_DEVICE : %s received gps data:[%.*s]", __FUNCTION__, (int)end, mData.c_str());
+    if (mStandby)
+        keepLastEpoch(end + 1);
+    else
+        handleGpsData(end + 1);
+    mData.erase(0, end + 1);
 }
 
-bool GPSDevice::openPort()
+/*
+ * In standby nothing is parsed; only the sentences of the most recent epoch
+ * (from its GGA on) are kept so a warm restart can report them at once.
+ */
+void GPSDevice::keepLastEpoch(size_t len)
 {
+    size_t start = 0;
 
-    struct termios tty;
-    memset(&tty, 0, sizeof(termios));
-    bool openPort = false;
-
-    if ((mFd = open(mPort.c_str(), O_RDONLY | O_NOCTTY | O_NONBLOCK)) != -1)
-    {
-        tty.c_iflag = 0;
-        tty.c_cflag |= CLOCAL | CREAD;
-        tcflush(mFd, TCIOFLUSH);
-        tcsetattr(mFd, TCSANOW, &tty);
-        tcflush(mFd, TCIOFLUSH);
-        tcflush(mFd, TCIOFLUSH);
-        cfsetospeed(&tty, B4800);
-        cfsetispeed(&tty, B4800);
-        cfmakeraw(&tty);
-        tcsetattr(mFd, TCSANOW, &tty);
-        openPort = true;
-        nyx_info("GPS_DEVICE", 0, "%s Port Open Success", mPort.c_str());
-    }
-    else
+    while (start < len)
     {
-        nyx_error("GPS_DEVICE", 0, "%s Port Open failed", mPort.c_str());
-    }
-    return openPort;
-}
+        size_t end = mData.find('\n', start);
+        if (end == std::string::npos || end >= len)
+            break;
 
-void GPSDevice::setReadChannel()
-{
-    if (mFd == INVALID_FD)
-    {
-        nyx_error("GPS_DEVICE", 0, "Invalid fd[%d]", mFd);
-        return;
-    }
+        // "$xxGGA," at least, anything shorter is noise
+        if (end - start >= 7 && mData[start] == '$' && mData.compare(start + 3, 4, "GGA,") == 0)
+            mLastEpoch.clear();
 
-    if (mReadChannel == NULL)
-    {
-        mReadChannel = g_io_channel_unix_new(mFd);
-        g_io_channel_set_close_on_unref(mReadChannel, TRUE);
-        g_io_channel_set_encoding(mReadChannel, NULL, NULL);
-        g_io_channel_set_buffered(mReadChannel, FALSE);
+        mLastEpoch.append(mData, start, end + 1 - start);
+        start = end + 1;
     }
 
-    if (mReadChannel && !mIoWatchId)
+    // No GGA for this long, whatever is kept is not a usable epoch
+    if (mLastEpoch.size() > MAX_EPOCH_SIZE)
     {
-        GIOCondition watchCond = static_cast<GIOCondition>(G_IO_IN | G_IO_PRI);
-        mIoWatchId = g_io_add_watch_full(mReadChannel, G_PRIORITY_HIGH, watchCond, ioCallback, this, NULL);
+        nyx_debug("GPS_DEVICE : %s dropping %zu bytes without GGA", __FUNCTION__, mLastEpoch.size());
+        mLastEpoch.clear();
     }
+}
 
-    nyx_info("GPS_DEVICE", 0, "setReadChannel Success");
+void GPSDevice::dataCallback(const char *data, gsize len, gpointer user_data)
+{
+    GPSDevice *ptr = (GPSDevice *)user_data;
+    ptr->readGpsData(data, len);
 }
 
 void GPSDevice::gpsDeviceDestroyed()
@@ -166,10 +132,18 @@ void GPSDevice::gpsDeviceDestroyed()
 void GPSDevice::configGPSDevicePort()
 {
 
-    if (loadGPSConfig(GPS_CONFIG_FILE))
+    if (loadGPSConfig(mConfigFile))
+    {
         mPort = getValue("PORT");
+        mStandbyTimeout = g_key_file_get_integer(mKeyfile, GPS_DEVICE_INFO, "STANDBY_TIMEOUT", NULL);
+        setFastDecode(g_key_file_get_boolean(mKeyfile, GPS_DEVICE_INFO, "FAST_NMEA_DECODE", NULL));
+    }
     else
+    {
         mPort = DEVICE_DEFAULT_PORT;
+        mStandbyTimeout = 0;
+        setFastDecode(false);
+    }
 }
 
 bool GPSDevice::init()
@@ -178,34 +152,119 @@ bool GPSDevice::init()
 
     configGPSDevicePort();
 
-    if (!mGpsDevAvail && openPort())
+    if (mStandby)
+    {
+        if (mSource && mSource->getName() == mPort)
+        {
+            g_source_remove(mStandbyTimerId);
+            mStandbyTimerId = 0;
+            mStandby = false;
+            nyx_info("GPS_DEVICE", 0, "%s warm restart", mPort.c_str());
+            return true;
+        }
+        // Port was reconfigured meanwhile
+        closeStandby();
+    }
+
+    if (!mGpsDevAvail)
     {
-        setReadChannel();
-        mGpsDevAvail = true;
+        mSource.reset(GpsInputSource::create(mPort));
+        mSource->setDataCallback(dataCallback, this);
+        mGpsDevAvail = mSource->open();
+        if (!mGpsDevAvail)
+            mSource.reset();
     }
 
     return mGpsDevAvail;
 }
 
+/*
+ * With STANDBY_TIMEOUT (seconds) set in gpsConfig.conf, stopping keeps the
+ * port open and the framer running for that long; a start within the window
+ * skips the reopen and tty setup and replays the last epoch.
+ */
 bool GPSDevice::deinit()
 {
     nyx_info("GPS_DEVICE", 0, "%s", __FUNCTION__);
-    if (mReadChannel)
+
+    if (mStandbyTimeout && mSource && !mStandby)
     {
-        mIoWatchId = 0;
-        g_io_channel_shutdown(mReadChannel, true, NULL);
-        g_io_channel_unref(mReadChannel);
-        mReadChannel = nullptr;
+        mStandby = true;
+        mLastEpoch.clear();
+        // Duty cycling may have left the input paused
+        mSource->resume();
+        mStandbyTimerId = g_timeout_add_seconds(mStandbyTimeout, standbyCallback, this);
+        nyx_info("GPS_DEVICE", 0, "%s standby for %u s", mPort.c_str(), mStandbyTimeout);
+        return true;
     }
-    if (mFd != INVALID_FD)
+
+    if (!mStandby)
+        closePort();
+    return true;
+}
+
+void GPSDevice::closePort()
+{
+    mSource.reset();
+    mData.clear();
+    mLastEpoch.clear();
+    mGpsDevAvail = false;
+}
+
+void GPSDevice::closeStandby()
+{
+    if (!mStandby)
+        return;
+
+    if (mStandbyTimerId)
     {
-        close(mFd);
-        mFd = INVALID_FD;
+        g_source_remove(mStandbyTimerId);
+        mStandbyTimerId = 0;
     }
+    mStandby = false;
+    closePort();
+    nyx_info("GPS_DEVICE", 0, "%s standby closed", mPort.c_str());
+}
 
+gboolean GPSDevice::standbyCallback(gpointer user_data)
+{
+    GPSDevice *ptr = (GPSDevice *)user_data;
+
+    ptr->mStandbyTimerId = 0;
+    ptr->closeStandby();
+    return FALSE;
+}
+
+void GPSDevice::replayLastEpoch()
+{
+    // Runs on the main loop like every other read of the port
+    g_idle_add(replayCallback, this);
+}
+
+gboolean GPSDevice::replayCallback(gpointer user_data)
+{
+    GPSDevice *ptr = (GPSDevice *)user_data;
+
+    if (!ptr->mStandby && !ptr->mLastEpoch.empty())
+    {
+        nyx_info("GPS_DEVICE", 0, "replaying %zu bytes of the last epoch", ptr->mLastEpoch.size());
+        ptr->processNmeaData(&ptr->mLastEpoch[0], ptr->mLastEpoch.size());
+        ptr->mLastEpoch.clear();
+    }
+    return FALSE;
+}
+
+void GPSDevice::pauseReading()
+{
+    if (mSource)
+        mSource->pause();
     mData.clear();
-    mGpsDevAvail = false;
-    return true;
+}
+
+void GPSDevice::resumeReading()
+{
+    if (mSource)
+        mSource->resume();
 }
 
 bool GPSDevice::loadGPSConfig(const std::string &fileName)
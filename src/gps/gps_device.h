@@ -36,14 +36,16 @@
 #include <unistd.h>
 #include <sys/ioctl.h>
 #include <errno.h>
+#include <memory>
 #include <gio/gio.h>
 #include "parser_nmea.h"
+#include "gps_input_source.h"
 
 constexpr char GPS_DEVICE_INFO[] = "GPSDEVICE";
 constexpr char GPS_CONFIG_FILE[] = "/etc/location/gpsConfig.conf";
 constexpr char DEVICE_DEFAULT_PORT[] = "/dev/ttyUSB0";
-constexpr int INVALID_FD = -1;
-constexpr int MAX_BUFFER_SIZE = 1024;
+// Room for one multi-GNSS epoch: GGA/RMC/VTG, a GSA and 3-5 GSV per constellation
+constexpr size_t MAX_EPOCH_SIZE = 8192;
 
 class GPSDevice : public ParserNmea
 {
@@ -55,25 +57,37 @@ public:
     bool isGpsDevAvail();
     bool init();
     bool deinit();
+    void pauseReading();
+    void resumeReading();
+    void setConfigFile(const std::string &fileName) { mConfigFile = fileName; }
+    const std::string &getConfigFile() const { return mConfigFile; }
+    bool isInStandby() const { return mStandby; }
+    void closeStandby();
+    void replayLastEpoch();
 
 private:
-    int mFd;
     bool mGpsDevAvail;
     GKeyFile *mKeyfile;
-    GIOChannel *mReadChannel;
-    guint mIoWatchId;
+    std::unique_ptr<GpsInputSource> mSource;
     std::string mData;
     std::string mPort;
-    void handleGpsData();
+    std::string mConfigFile;
+    bool mStandby;
+    guint mStandbyTimeout;
+    guint mStandbyTimerId;
+    std::string mLastEpoch;
+    void handleGpsData(size_t len);
+    void keepLastEpoch(size_t len);
+    void closePort();
+    static gboolean standbyCallback(gpointer);
+    static gboolean replayCallback(gpointer);
     bool isGPSConfigured();
     bool loadGPSConfig(const std::string &fileName);
     std::string getValue(const std::string &key);
-    bool openPort();
-    void setReadChannel();
     void configGPSDevicePort();
     void gpsDeviceDestroyed();
-    gboolean readGpsData(GIOChannel *, GIOCondition);
-    static gboolean ioCallback(GIOChannel *, GIOCondition, gpointer);
+    void readGpsData(const char *data, gsize len);
+    static void dataCallback(const char *, gsize, gpointer);
 };
 
 #endif /* GPSDEVICE_H_ */
@@ -0,0 +1,171 @@
+/* @@@LICENSE
+ * *
+ * * Copyright (c) 2024 LG Electronics, Inc.
+ * *
+ * * Licensed under the Apache License, Version 2.0 (the "License");
+ * * you may not use this file except in compliance with the License.
+ * * You may obtain a copy of the License at
+ * *
+ * * http://www.apache.org/licenses/LICENSE-2.0
+ * *
+ * * Unless required by applicable law or agreed to in writing, software
+ * * distributed under the License is distributed on an "AS IS" BASIS,
+ * * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * * See the License for the specific language governing permissions and
+ * * limitations under the License.
+ * * SPDX-License-Identifier: Apache-2.0
+ * *
+ * * LICENSE@@@ */
+
+/*
+ * *******************************************************************/
+
+#include <unistd.h>
+
+#include <nyx/module/nyx_log.h>
+#include "gps_input_source.h"
+#include "socket_input_source.h"
+#include "tty_input_source.h"
+
+GpsInputSource::GpsInputSource(const std::string &name)
+    : mFd(INVALID_FD)
+    , mName(name)
+    , mChannel(nullptr)
+    , mWatchId(0)
+    , mPaused(false)
+    , mCallback(nullptr)
+    , mUserData(nullptr)
+{
+}
+
+GpsInputSource::~GpsInputSource()
+{
+    detach();
+}
+
+GpsInputSource *GpsInputSource::create(const std::string &port)
+{
+    if (SocketInputSource::isSocketAddress(port))
+        return new SocketInputSource(port);
+
+    return new TtyInputSource(port);
+}
+
+void GpsInputSource::setDataCallback(DataCallback callback, gpointer user_data)
+{
+    mCallback = callback;
+    mUserData = user_data;
+}
+
+void GpsInputSource::close()
+{
+    detach();
+    mPaused = false;
+}
+
+void GpsInputSource::pause()
+{
+    mPaused = true;
+    removeWatch();
+}
+
+void GpsInputSource::resume()
+{
+    if (!mPaused)
+        return;
+
+    mPaused = false;
+    if (mFd == INVALID_FD)
+        return;
+
+    // Whatever queued up while paused is stale by now
+    discardPending();
+    addWatch();
+}
+
+void GpsInputSource::attach(int fd)
+{
+    detach();
+
+    mFd = fd;
+    mChannel = g_io_channel_unix_new(mFd);
+    g_io_channel_set_close_on_unref(mChannel, TRUE);
+    g_io_channel_set_encoding(mChannel, NULL, NULL);
+    g_io_channel_set_buffered(mChannel, FALSE);
+
+    if (!mPaused)
+        addWatch();
+
+    nyx_info("GPS_DEVICE", 0, "%s attached, fd[%d]", mName.c_str(), mFd);
+}
+
+void GpsInputSource::detach()
+{
+    removeWatch();
+
+    if (mChannel)
+    {
+        // Closes mFd through close_on_unref
+        g_io_channel_unref(mChannel);
+        mChannel = nullptr;
+    }
+    else if (mFd != INVALID_FD)
+    {
+        ::close(mFd);
+    }
+    mFd = INVALID_FD;
+}
+
+void GpsInputSource::addWatch()
+{
+    if (mChannel && !mWatchId)
+    {
+        GIOCondition watchCond = static_cast<GIOCondition>(G_IO_IN | G_IO_PRI | G_IO_HUP | G_IO_ERR);
+        mWatchId = g_io_add_watch_full(mChannel, G_PRIORITY_HIGH, watchCond, ioCallback, this, NULL);
+    }
+}
+
+void GpsInputSource::removeWatch()
+{
+    if (mWatchId)
+    {
+        g_source_remove(mWatchId);
+        mWatchId = 0;
+    }
+}
+
+void GpsInputSource::onDisconnected()
+{
+    nyx_error("GPS_DEVICE", 0, "%s read failed, closing", mName.c_str());
+    detach();
+}
+
+gboolean GpsInputSource::readData(GIOChannel *io, GIOCondition condition)
+{
+    char msg[MAX_BUFFER_SIZE];
+    gsize len = 0;
+
+    switch (g_io_channel_read_chars(io, msg, sizeof(msg), &len, NULL))
+    {
+    case G_IO_STATUS_NORMAL:
+        onDataReceived();
+        if (mCallback)
+            mCallback(msg, len, mUserData);
+        return TRUE;
+
+    case G_IO_STATUS_AGAIN:
+        return TRUE;
+
+    default:
+        // The watch goes away with FALSE, don't let detach() remove it twice
+        mWatchId = 0;
+        onDisconnected();
+        return FALSE;
+    }
+}
+
+gboolean GpsInputSource::ioCallback(GIOChannel *io, GIOCondition condition, gpointer user_data)
+{
+    GpsInputSource *ptr = (GpsInputSource *)user_data;
+    return ptr->readData(io, condition);
+}
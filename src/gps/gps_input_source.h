@@ -0,0 +1,83 @@
+/* @@@LICENSE
+ * *
+ * * Copyright (c) 2024 LG Electronics, Inc.
+ * *
+ * * Licensed under the Apache License, Version 2.0 (the "License");
+ * * you may not use this file except in compliance with the License.
+ * * You may obtain a copy of the License at
+ * *
+ * * http://www.apache.org/licenses/LICENSE-2.0
+ * *
+ * * Unless required by applicable law or agreed to in writing, software
+ * * distributed under the License is distributed on an "AS IS" BASIS,
+ * * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * * See the License for the specific language governing permissions and
+ * * limitations under the License.
+ * * SPDX-License-Identifier: Apache-2.0
+ * *
+ * * LICENSE@@@ */
+
+/*
+ * *******************************************************************/
+
+#ifndef _GPS_INPUT_SOURCE_H_
+#define _GPS_INPUT_SOURCE_H_
+
+#include <string>
+#include <glib.h>
+
+constexpr int INVALID_FD = -1;
+constexpr int MAX_BUFFER_SIZE = 1024;
+
+/*
+ * Byte stream GPSDevice reads NMEA from. Implementations only open and
+ * close the underlying fd; reading, pausing and the GLib watch are shared
+ * so every backend feeds the same framing path in GPSDevice.
+ *
+ * PORT in gpsConfig.conf selects the backend:
+ *     /dev/ttyUSB0           serial receiver
+ *     unix:/run/nmea.sock    local stream socket
+ *     tcp:192.168.0.10:2947  TCP relay
+ */
+class GpsInputSource
+{
+public:
+    typedef void (*DataCallback)(const char *data, gsize len, gpointer user_data);
+
+    explicit GpsInputSource(const std::string &name);
+    virtual ~GpsInputSource();
+
+    static GpsInputSource *create(const std::string &port);
+
+    void setDataCallback(DataCallback callback, gpointer user_data);
+    virtual bool open() = 0;
+    virtual void close();
+    bool isOpen() const { return mFd != INVALID_FD; }
+    void pause();
+    void resume();
+    const std::string &getName() const { return mName; }
+
+protected:
+    void attach(int fd);
+    void detach();
+    virtual void discardPending() {}
+    virtual void onDataReceived() {}
+    virtual void onDisconnected();
+
+    int mFd;
+    std::string mName;
+
+private:
+    void addWatch();
+    void removeWatch();
+    gboolean readData(GIOChannel *io, GIOCondition condition);
+    static gboolean ioCallback(GIOChannel *, GIOCondition, gpointer);
+
+    GIOChannel *mChannel;
+    guint mWatchId;
+    bool mPaused;
+    DataCallback mCallback;
+    gpointer mUserData;
+};
+
+#endif // _GPS_INPUT_SOURCE_H_
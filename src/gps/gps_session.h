@@ -0,0 +1,76 @@
+/* @@@LICENSE
+*
+* Copyright (c) 2024 LG Electronics, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* SPDX-License-Identifier: Apache-2.0
+*
+* LICENSE@@@ */
+
+/*
+* Session quality statistics of the GPS module.
+*
+* Installed as <nyx-gps/gps_session.h>. nyx-lib fixes the method table of a
+* module, so the query is not a nyx method; clients look it up in the GPS
+* module nyx_device_open() loaded, as described in <nyx-gps/gps_batch.h>:
+*
+*     gps_get_session_stats_function_t get_session_stats =
+*         (gps_get_session_stats_function_t) dlsym(module, GPS_GET_SESSION_STATS_SYMBOL);
+*******************************************************************/
+
+#ifndef _GPS_SESSION_H_
+#define _GPS_SESSION_H_
+
+#include <nyx/nyx_module.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define NYX_GPS_SESSION_STATS_MAX   16
+
+/**
+ * Quality figures of one positioning session, SESSION_BEGIN to SESSION_END.
+ */
+typedef struct {
+    int64_t  start_time;        /* wall clock, ms since epoch */
+    uint32_t duration_ms;
+    int32_t  ttff_ms;           /* first fix, -1 if none */
+    int32_t  ttf3d_ms;          /* first 3D fix (GSA mode 3), -1 if none */
+    uint32_t fix_epochs;        /* GGA epochs with a fix */
+    uint32_t total_epochs;      /* all GGA epochs */
+    float    avg_sats_used;     /* over epochs with a fix */
+    float    availability;      /* fix_epochs / total_epochs, in percent */
+    uint32_t longest_gap_ms;    /* longest time between two fixes */
+} nyx_gps_session_stats_t;
+
+/**
+ * Copy the statistics of up to max finished sessions into stats, newest
+ * first, and their number into count. The last NYX_GPS_SESSION_STATS_MAX
+ * sessions are kept across restarts.
+ */
+nyx_error_t get_session_stats(nyx_device_handle_t handle,
+                              nyx_gps_session_stats_t *stats,
+                              uint32_t max,
+                              uint32_t *count);
+
+#define GPS_GET_SESSION_STATS_SYMBOL "get_session_stats"
+typedef nyx_error_t (*gps_get_session_stats_function_t)(nyx_device_handle_t handle,
+        nyx_gps_session_stats_t *stats, uint32_t max, uint32_t *count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // _GPS_SESSION_H_
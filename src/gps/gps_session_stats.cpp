@@ -0,0 +1,212 @@
+/* @@@LICENSE
+ * *
+ * * Copyright (c) 2024 LG Electronics, Inc.
+ * *
+ * * Licensed under the Apache License, Version 2.0 (the "License");
+ * * you may not use this file except in compliance with the License.
+ * * You may obtain a copy of the License at
+ * *
+ * * http://www.apache.org/licenses/LICENSE-2.0
+ * *
+ * * Unless required by applicable law or agreed to in writing, software
+ * * distributed under the License is distributed on an "AS IS" BASIS,
+ * * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * * See the License for the specific language governing permissions and
+ * * limitations under the License.
+ * * SPDX-License-Identifier: Apache-2.0
+ * *
+ * * LICENSE@@@ */
+
+/*
+ * *******************************************************************/
+
+#include <cstring>
+
+#include <nyx/module/nyx_log.h>
+#include "gps_session_stats.h"
+#include "gps_device.h"
+#include "gps_storage.h"
+
+constexpr uint32_t SESSION_STATS_MAGIC = 0x53535347;
+constexpr uint32_t SESSION_STATS_VERSION = 1;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t count;
+    uint32_t next;
+    nyx_gps_session_stats_t ring[NYX_GPS_SESSION_STATS_MAX];
+} session_stats_file_t;
+
+GpsSessionStats::GpsSessionStats()
+    : mFileName(GPS_SESSION_STATS_DEFAULT_FILE)
+    , mActive(false)
+    , mBegin(0)
+    , mLastFix(0)
+    , mSatsSum(0)
+    , mCount(0)
+    , mNext(0)
+{
+    memset(&mCurrent, 0, sizeof(mCurrent));
+    memset(mRing, 0, sizeof(mRing));
+}
+
+GpsSessionStats *GpsSessionStats::getInstance()
+{
+    static GpsSessionStats gpsSessionStatsObj;
+    return &gpsSessionStatsObj;
+}
+
+void GpsSessionStats::init(const std::string &configFile)
+{
+    std::string fileName = GPS_SESSION_STATS_DEFAULT_FILE;
+    GKeyFile *keyfile = load_conf_file(configFile.c_str());
+
+    if (keyfile)
+    {
+        gchar *value = g_key_file_get_string(keyfile, GPS_DEVICE_INFO, "SESSION_STATS_FILE", NULL);
+        if (value)
+            fileName = value;
+        g_free(value);
+        g_key_file_free(keyfile);
+    }
+
+    load(fileName);
+}
+
+bool GpsSessionStats::load(const std::string &fileName)
+{
+    std::lock_guard<std::mutex> lock(mLock);
+    gchar *contents = NULL;
+    gsize length = 0;
+
+    mFileName = fileName;
+    mCount = mNext = 0;
+    memset(mRing, 0, sizeof(mRing));
+
+    if (!g_file_get_contents(mFileName.c_str(), &contents, &length, NULL))
+        return false;
+
+    const session_stats_file_t *file = (const session_stats_file_t *)contents;
+    bool valid = length == sizeof(session_stats_file_t) &&
+                 file->magic == SESSION_STATS_MAGIC && file->version == SESSION_STATS_VERSION &&
+                 file->count <= NYX_GPS_SESSION_STATS_MAX && file->next < NYX_GPS_SESSION_STATS_MAX;
+
+    if (valid)
+    {
+        memcpy(mRing, file->ring, sizeof(mRing));
+        mCount = file->count;
+        mNext = file->next;
+    }
+    else
+    {
+        nyx_error("GPS_SESSION_STATS", 0, "%s ignored, unknown format", mFileName.c_str());
+    }
+
+    g_free(contents);
+    return valid;
+}
+
+bool GpsSessionStats::save()
+{
+    session_stats_file_t file;
+
+    memset(&file, 0, sizeof(file));
+    file.magic = SESSION_STATS_MAGIC;
+    file.version = SESSION_STATS_VERSION;
+    file.count = mCount;
+    file.next = mNext;
+    memcpy(file.ring, mRing, sizeof(mRing));
+
+    // Written to a temporary file and renamed, a crash never leaves half a ring
+    if (!g_file_set_contents(mFileName.c_str(), (const gchar *)&file, sizeof(file), NULL))
+    {
+        nyx_error("GPS_SESSION_STATS", 0, "%s write failed", mFileName.c_str());
+        return false;
+    }
+    return true;
+}
+
+void GpsSessionStats::beginSession(gint64 now)
+{
+    std::lock_guard<std::mutex> lock(mLock);
+
+    memset(&mCurrent, 0, sizeof(mCurrent));
+    mCurrent.start_time = g_get_real_time() / 1000;
+    mCurrent.ttff_ms = -1;
+    mCurrent.ttf3d_ms = -1;
+    mBegin = now;
+    mLastFix = 0;
+    mSatsSum = 0;
+    mActive = true;
+}
+
+void GpsSessionStats::endSession(gint64 now)
+{
+    std::lock_guard<std::mutex> lock(mLock);
+
+    if (!mActive)
+        return;
+
+    mActive = false;
+    mCurrent.duration_ms = (now - mBegin) / 1000;
+    if (mCurrent.fix_epochs)
+        mCurrent.avg_sats_used = (float)mSatsSum / mCurrent.fix_epochs;
+    if (mCurrent.total_epochs)
+        mCurrent.availability = 100.0f * mCurrent.fix_epochs / mCurrent.total_epochs;
+
+    nyx_info("GPS_SESSION_STATS", 0, "session %u ms, ttff %d ms, ttf3d %d ms, sats %.1f, availability %.1f%%, longest gap %u ms",
+             mCurrent.duration_ms, mCurrent.ttff_ms, mCurrent.ttf3d_ms, mCurrent.avg_sats_used,
+             mCurrent.availability, mCurrent.longest_gap_ms);
+
+    mRing[mNext] = mCurrent;
+    mNext = (mNext + 1) % NYX_GPS_SESSION_STATS_MAX;
+    if (mCount < NYX_GPS_SESSION_STATS_MAX)
+        mCount++;
+
+    save();
+}
+
+void GpsSessionStats::onGgaEpoch(int fixQuality, int satsUsed, gint64 now)
+{
+    std::lock_guard<std::mutex> lock(mLock);
+
+    if (!mActive)
+        return;
+
+    mCurrent.total_epochs++;
+    if (fixQuality <= 0)
+        return;
+
+    if (mCurrent.ttff_ms < 0)
+        mCurrent.ttff_ms = (now - mBegin) / 1000;
+
+    if (mLastFix && (uint32_t)((now - mLastFix) / 1000) > mCurrent.longest_gap_ms)
+        mCurrent.longest_gap_ms = (now - mLastFix) / 1000;
+
+    mLastFix = now;
+    mCurrent.fix_epochs++;
+    mSatsSum += satsUsed > 0 ? satsUsed : 0;
+}
+
+void GpsSessionStats::onGsaMode(int mode, gint64 now)
+{
+    std::lock_guard<std::mutex> lock(mLock);
+
+    if (mActive && mode == 3 && mCurrent.ttf3d_ms < 0)
+        mCurrent.ttf3d_ms = (now - mBegin) / 1000;
+}
+
+/*
+ * Copies up to max finished sessions, newest first. Returns how many.
+ */
+unsigned int GpsSessionStats::query(nyx_gps_session_stats_t *stats, unsigned int max)
+{
+    std::lock_guard<std::mutex> lock(mLock);
+    unsigned int count = MIN(max, mCount);
+
+    for (unsigned int i = 0; i < count; i++)
+        stats[i] = mRing[(mNext + NYX_GPS_SESSION_STATS_MAX - 1 - i) % NYX_GPS_SESSION_STATS_MAX];
+
+    return count;
+}
@@ -0,0 +1,70 @@
+/* @@@LICENSE
+ * *
+ * * Copyright (c) 2024 LG Electronics, Inc.
+ * *
+ * * Licensed under the Apache License, Version 2.0 (the "License");
+ * * you may not use this file except in compliance with the License.
+ * * You may obtain a copy of the License at
+ * *
+ * * http://www.apache.org/licenses/LICENSE-2.0
+ * *
+ * * Unless required by applicable law or agreed to in writing, software
+ * * distributed under the License is distributed on an "AS IS" BASIS,
+ * * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * * See the License for the specific language governing permissions and
+ * * limitations under the License.
+ * * SPDX-License-Identifier: Apache-2.0
+ * *
+ * * LICENSE@@@ */
+
+/*
+ * *******************************************************************/
+
+#ifndef _GPS_SESSION_STATS_H_
+#define _GPS_SESSION_STATS_H_
+
+#include <mutex>
+#include <string>
+#include <glib.h>
+
+#include "gps_session.h"
+
+#define GPS_SESSION_STATS_DEFAULT_FILE  "/var/lib/location/gps_session_stats"
+
+/*
+ * Follows the session lifecycle signalled through SetGpsStatus() and the
+ * parsed GGA/GSA epochs, and keeps the last NYX_GPS_SESSION_STATS_MAX
+ * sessions in a ring that is written to disk at every session end.
+ *
+ *     [GPSDEVICE]
+ *     SESSION_STATS_FILE=/var/lib/location/gps_session_stats
+ */
+class GpsSessionStats
+{
+public:
+    static GpsSessionStats *getInstance();
+    void init(const std::string &configFile);
+    bool load(const std::string &fileName);
+    void beginSession(gint64 now = g_get_monotonic_time());
+    void endSession(gint64 now = g_get_monotonic_time());
+    void onGgaEpoch(int fixQuality, int satsUsed, gint64 now = g_get_monotonic_time());
+    void onGsaMode(int mode, gint64 now = g_get_monotonic_time());
+    unsigned int query(nyx_gps_session_stats_t *stats, unsigned int max);
+
+private:
+    GpsSessionStats();
+    bool save();
+
+    std::mutex mLock;
+    std::string mFileName;
+    bool mActive;
+    gint64 mBegin;
+    gint64 mLastFix;
+    uint64_t mSatsSum;
+    nyx_gps_session_stats_t mCurrent;
+    nyx_gps_session_stats_t mRing[NYX_GPS_SESSION_STATS_MAX];
+    unsigned int mCount;
+    unsigned int mNext;
+};
+
+#endif // _GPS_SESSION_STATS_H_
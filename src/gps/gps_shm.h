@@ -0,0 +1,117 @@
+/* @@@LICENSE
+ * *
+ * * Copyright (c) 2024 LG Electronics, Inc.
+ * *
+ * * Licensed under the Apache License, Version 2.0 (the "License");
+ * * you may not use this file except in compliance with the License.
+ * * You may obtain a copy of the License at
+ * *
+ * * http://www.apache.org/licenses/LICENSE-2.0
+ * *
+ * * Unless required by applicable law or agreed to in writing, software
+ * * distributed under the License is distributed on an "AS IS" BASIS,
+ * * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * * See the License for the specific language governing permissions and
+ * * limitations under the License.
+ * * SPDX-License-Identifier: Apache-2.0
+ * *
+ * * LICENSE@@@ */
+
+/*
+ * Layout of the shared-memory region the GPS module publishes fixes and
+ * satellite status into. The region is a memfd handed out over a UNIX
+ * socket; it is shared between the module (single writer) and any number
+ * of read-only local consumers.
+ *
+ * Every slot is protected by its own seqlock: the writer makes the
+ * sequence odd, copies the payload and makes it even again. A reader
+ * copies the slot and retries if the sequence changed or was odd. The
+ * `futex` word is bumped after every publish so that readers can sleep
+ * in FUTEX_WAIT instead of polling.
+ * *******************************************************************/
+
+#ifndef _GPS_SHM_H_
+#define _GPS_SHM_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define GPS_SHM_MAGIC               0x53535047u /* "GPSS" */
+#define GPS_SHM_VERSION             1
+#define GPS_SHM_RING_SLOTS          64
+#define GPS_SHM_MAX_SVS             64
+#define GPS_SHM_DEFAULT_SOCKET      "/run/location/nyx-gps-shm.sock"
+
+typedef enum {
+    GPS_SHM_RECORD_NONE = 0,
+    GPS_SHM_RECORD_LOCATION = 1,
+    GPS_SHM_RECORD_SV_STATUS = 2
+} gps_shm_record_type_t;
+
+typedef struct {
+    int64_t         timestamp;
+    double          latitude;
+    double          longitude;
+    double          altitude;
+    float           speed;
+    float           bearing;
+    float           accuracy;
+    uint16_t        flags;
+    uint16_t        reserved;
+} gps_shm_location_t;
+
+typedef struct {
+    int32_t         prn;
+    float           snr;
+    float           elevation;
+    float           azimuth;
+} gps_shm_sv_info_t;
+
+typedef struct {
+    uint32_t            num_svs;
+    uint32_t            ephemeris_mask;
+    uint32_t            almanac_mask;
+    uint32_t            used_in_fix_mask;
+    gps_shm_sv_info_t   sv_list[GPS_SHM_MAX_SVS];
+} gps_shm_sv_status_t;
+
+typedef struct {
+    /** Absolute publish index, 0 for the first record ever written. */
+    uint64_t        index;
+    /** gps_shm_record_type_t */
+    uint32_t        type;
+    uint32_t        reserved;
+    union {
+        gps_shm_location_t  location;
+        gps_shm_sv_status_t sv_status;
+    } u;
+} gps_shm_record_t;
+
+typedef struct {
+    /** Seqlock counter, odd while the writer is updating the slot. */
+    uint32_t            seq;
+    uint32_t            reserved;
+    gps_shm_record_t    record;
+} __attribute__((aligned(64))) gps_shm_slot_t;
+
+typedef struct {
+    uint32_t        magic;
+    uint32_t        version;
+    uint32_t        slot_count;
+    uint32_t        slot_size;
+    /** Number of records published so far. */
+    uint64_t        head;
+    /** Bumped after every publish; readers FUTEX_WAIT on it. */
+    uint32_t        futex;
+    uint32_t        reserved;
+    gps_shm_slot_t  slots[GPS_SHM_RING_SLOTS];
+} __attribute__((aligned(64))) gps_shm_region_t;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // _GPS_SHM_H_
@@ -0,0 +1,341 @@
+/* @@@LICENSE
+ * *
+ * * Copyright (c) 2024 LG Electronics, Inc.
+ * *
+ * * Licensed under the Apache License, Version 2.0 (the "License");
+ * * you may not use this file except in compliance with the License.
+ * * You may obtain a copy of the License at
+ * *
+ * * http://www.apache.org/licenses/LICENSE-2.0
+ * *
+ * * Unless required by applicable law or agreed to in writing, software
+ * * distributed under the License is distributed on an "AS IS" BASIS,
+ * * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * * See the License for the specific language governing permissions and
+ * * limitations under the License.
+ * * SPDX-License-Identifier: Apache-2.0
+ * *
+ * * LICENSE@@@ */
+
+/*
+ * *******************************************************************/
+
+#include <climits>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/un.h>
+
+#include <nyx/module/nyx_log.h>
+#include "gps_shm_publisher.h"
+#include "gps_device.h"
+#include "gps_storage.h"
+
+GpsShmPublisher::GpsShmPublisher()
+    : mMemFd(INVALID_FD)
+    , mListenFd(INVALID_FD)
+    , mRegion(nullptr)
+    , mListenChannel(nullptr)
+    , mListenWatchId(0)
+    , mServedClients(0)
+{
+}
+
+GpsShmPublisher::~GpsShmPublisher()
+{
+    stop();
+}
+
+GpsShmPublisher *GpsShmPublisher::getInstance()
+{
+    static GpsShmPublisher gpsShmPublisherObj;
+    return &gpsShmPublisherObj;
+}
+
+bool GpsShmPublisher::init(const std::string &configFile)
+{
+    GKeyFile *keyfile = load_conf_file(configFile.c_str());
+    if (!keyfile)
+        return false;
+
+    bool enabled = g_key_file_get_boolean(keyfile, GPS_DEVICE_INFO, "SHM_BROADCAST", NULL);
+    gchar *socketPath = g_key_file_get_string(keyfile, GPS_DEVICE_INFO, "SHM_SOCKET", NULL);
+    std::string path = socketPath ? socketPath : GPS_SHM_DEFAULT_SOCKET;
+
+    g_free(socketPath);
+    g_key_file_free(keyfile);
+
+    if (!enabled)
+        return false;
+
+    return start(path);
+}
+
+bool GpsShmPublisher::start(const std::string &socketPath)
+{
+    if (isActive())
+        return true;
+
+    mSocketPath = socketPath;
+
+    if (!createRegion() || !createListenSocket())
+    {
+        stop();
+        return false;
+    }
+
+    nyx_info("GPS_SHM", 0, "shared location broadcast on %s", mSocketPath.c_str());
+    return true;
+}
+
+void GpsShmPublisher::stop()
+{
+    if (mListenWatchId)
+    {
+        g_source_remove(mListenWatchId);
+        mListenWatchId = 0;
+    }
+    if (mListenChannel)
+    {
+        g_io_channel_unref(mListenChannel);
+        mListenChannel = nullptr;
+    }
+    if (mListenFd != INVALID_FD)
+    {
+        close(mListenFd);
+        mListenFd = INVALID_FD;
+        removeStaleSocket();
+    }
+
+    std::lock_guard<std::mutex> lock(mWriteLock);
+    if (mRegion)
+    {
+        munmap(mRegion, sizeof(gps_shm_region_t));
+        mRegion = nullptr;
+    }
+    if (mMemFd != INVALID_FD)
+    {
+        close(mMemFd);
+        mMemFd = INVALID_FD;
+    }
+    mServedClients = 0;
+}
+
+bool GpsShmPublisher::createRegion()
+{
+    mMemFd = memfd_create("nyx-gps-shm", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    if (mMemFd == INVALID_FD)
+    {
+        nyx_error("GPS_SHM", 0, "memfd_create failed: %s", strerror(errno));
+        return false;
+    }
+
+    if (ftruncate(mMemFd, sizeof(gps_shm_region_t)) < 0)
+    {
+        nyx_error("GPS_SHM", 0, "ftruncate failed: %s", strerror(errno));
+        return false;
+    }
+
+    void *map = mmap(nullptr, sizeof(gps_shm_region_t), PROT_READ | PROT_WRITE, MAP_SHARED, mMemFd, 0);
+    if (map == MAP_FAILED)
+    {
+        nyx_error("GPS_SHM", 0, "mmap failed: %s", strerror(errno));
+        return false;
+    }
+
+    // Readers may never resize the region under us
+    fcntl(mMemFd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL);
+
+    mRegion = static_cast<gps_shm_region_t *>(map);
+    memset(mRegion, 0, sizeof(gps_shm_region_t));
+    mRegion->version = GPS_SHM_VERSION;
+    mRegion->slot_count = GPS_SHM_RING_SLOTS;
+    mRegion->slot_size = sizeof(gps_shm_slot_t);
+    __atomic_store_n(&mRegion->magic, GPS_SHM_MAGIC, __ATOMIC_RELEASE);
+
+    return true;
+}
+
+bool GpsShmPublisher::createListenSocket()
+{
+    struct sockaddr_un addr;
+
+    if (mSocketPath.size() >= sizeof(addr.sun_path))
+    {
+        nyx_error("GPS_SHM", 0, "socket path too long: %s", mSocketPath.c_str());
+        return false;
+    }
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, mSocketPath.c_str());
+
+    mListenFd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (mListenFd == INVALID_FD)
+        return false;
+
+    gchar *dir = g_path_get_dirname(mSocketPath.c_str());
+    g_mkdir_with_parents(dir, 0755);
+    g_free(dir);
+
+    if (!removeStaleSocket())
+        return false;
+
+    if (bind(mListenFd, (struct sockaddr *)&addr, sizeof(addr)) < 0 || listen(mListenFd, 8) < 0)
+    {
+        nyx_error("GPS_SHM", 0, "%s bind/listen failed: %s", mSocketPath.c_str(), strerror(errno));
+        return false;
+    }
+
+    mListenChannel = g_io_channel_unix_new(mListenFd);
+    mListenWatchId = g_io_add_watch(mListenChannel, G_IO_IN, acceptCallback, this);
+
+    return mListenWatchId != 0;
+}
+
+bool GpsShmPublisher::removeStaleSocket()
+{
+    struct stat st;
+
+    if (lstat(mSocketPath.c_str(), &st) < 0)
+        return errno == ENOENT;
+
+    // Never remove something the config points at by mistake
+    if (!S_ISSOCK(st.st_mode))
+    {
+        nyx_error("GPS_SHM", 0, "%s exists and is not a socket", mSocketPath.c_str());
+        return false;
+    }
+
+    return unlink(mSocketPath.c_str()) == 0;
+}
+
+gboolean GpsShmPublisher::acceptCallback(GIOChannel *io, GIOCondition condition, gpointer user_data)
+{
+    GpsShmPublisher *ptr = (GpsShmPublisher *)user_data;
+    return ptr->acceptClient();
+}
+
+gboolean GpsShmPublisher::acceptClient()
+{
+    int client = accept4(mListenFd, nullptr, nullptr, SOCK_CLOEXEC);
+    if (client < 0)
+        return TRUE;
+
+    // Hand out a read-only reopen of the memfd so clients cannot map it writable
+    char procPath[64];
+    snprintf(procPath, sizeof(procPath), "/proc/self/fd/%d", mMemFd);
+    int roFd = open(procPath, O_RDONLY | O_CLOEXEC);
+    if (roFd < 0)
+    {
+        nyx_error("GPS_SHM", 0, "read-only reopen failed: %s", strerror(errno));
+        close(client);
+        return TRUE;
+    }
+
+    uint32_t size = sizeof(gps_shm_region_t);
+    char cbuf[CMSG_SPACE(sizeof(int))];
+    struct iovec iov = { &size, sizeof(size) };
+    struct msghdr msg;
+
+    memset(&msg, 0, sizeof(msg));
+    memset(cbuf, 0, sizeof(cbuf));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = cbuf;
+    msg.msg_controllen = sizeof(cbuf);
+
+    struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+    memcpy(CMSG_DATA(cmsg), &roFd, sizeof(int));
+
+    if (sendmsg(client, &msg, MSG_NOSIGNAL) == (ssize_t)sizeof(size))
+        mServedClients++;
+    else
+        nyx_error("GPS_SHM", 0, "sendmsg failed: %s", strerror(errno));
+
+    close(roFd);
+    close(client);
+    return TRUE;
+}
+
+gps_shm_slot_t *GpsShmPublisher::beginWrite(uint32_t type)
+{
+    uint64_t index = mRegion->head;
+    gps_shm_slot_t *slot = &mRegion->slots[index % GPS_SHM_RING_SLOTS];
+
+    __atomic_store_n(&slot->seq, slot->seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    memset(&slot->record, 0, sizeof(slot->record));
+    slot->record.index = index;
+    slot->record.type = type;
+
+    return slot;
+}
+
+void GpsShmPublisher::endWrite(gps_shm_slot_t *slot)
+{
+    __atomic_store_n(&slot->seq, slot->seq + 1, __ATOMIC_RELEASE);
+    __atomic_store_n(&mRegion->head, slot->record.index + 1, __ATOMIC_RELEASE);
+    __atomic_add_fetch(&mRegion->futex, 1, __ATOMIC_RELEASE);
+    syscall(SYS_futex, &mRegion->futex, FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+}
+
+void GpsShmPublisher::publishLocation(const GpsLocation *location)
+{
+    if (!location)
+        return;
+
+    std::lock_guard<std::mutex> lock(mWriteLock);
+    if (!mRegion)
+        return;
+
+    gps_shm_slot_t *slot = beginWrite(GPS_SHM_RECORD_LOCATION);
+    gps_shm_location_t *loc = &slot->record.u.location;
+
+    loc->timestamp = location->timestamp;
+    loc->latitude = location->latitude;
+    loc->longitude = location->longitude;
+    loc->altitude = location->altitude;
+    loc->speed = location->speed;
+    loc->bearing = location->bearing;
+    loc->accuracy = location->accuracy;
+    loc->flags = location->flags;
+
+    endWrite(slot);
+}
+
+void GpsShmPublisher::publishSvStatus(const GpsSvStatus *svStatus)
+{
+    if (!svStatus)
+        return;
+
+    std::lock_guard<std::mutex> lock(mWriteLock);
+    if (!mRegion)
+        return;
+
+    gps_shm_slot_t *slot = beginWrite(GPS_SHM_RECORD_SV_STATUS);
+    gps_shm_sv_status_t *sv = &slot->record.u.sv_status;
+
+    sv->num_svs = svStatus->num_svs < GPS_SHM_MAX_SVS ? svStatus->num_svs : GPS_SHM_MAX_SVS;
+    for (uint32_t i = 0; i < sv->num_svs; i++)
+    {
+        sv->sv_list[i].prn = svStatus->sv_list[i].prn;
+        sv->sv_list[i].snr = svStatus->sv_list[i].snr;
+        sv->sv_list[i].elevation = svStatus->sv_list[i].elevation;
+        sv->sv_list[i].azimuth = svStatus->sv_list[i].azimuth;
+    }
+    sv->ephemeris_mask = svStatus->ephemeris_mask;
+    sv->almanac_mask = svStatus->almanac_mask;
+    sv->used_in_fix_mask = svStatus->used_in_fix_mask;
+
+    endWrite(slot);
+}
@@ -0,0 +1,79 @@
+/* @@@LICENSE
+ * *
+ * * Copyright (c) 2024 LG Electronics, Inc.
+ * *
+ * * Licensed under the Apache License, Version 2.0 (the "License");
+ * * you may not use this file except in compliance with the License.
+ * * You may obtain a copy of the License at
+ * *
+ * * http://www.apache.org/licenses/LICENSE-2.0
+ * *
+ * * Unless required by applicable law or agreed to in writing, software
+ * * distributed under the License is distributed on an "AS IS" BASIS,
+ * * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * * See the License for the specific language governing permissions and
+ * * limitations under the License.
+ * * SPDX-License-Identifier: Apache-2.0
+ * *
+ * * LICENSE@@@ */
+
+/*
+ * *******************************************************************/
+
+#ifndef _GPS_SHM_PUBLISHER_H_
+#define _GPS_SHM_PUBLISHER_H_
+
+#include <string>
+#include <mutex>
+#include <glib.h>
+
+#include "gps_shm.h"
+#include "parser_interface.h"
+
+/*
+ * Writes every location and satellite status delivered by the parser into a
+ * memfd-backed ring (see gps_shm.h) so that local consumers can map it
+ * instead of each going through the nyx callback and IPC path.
+ *
+ * Enabled from gpsConfig.conf:
+ *     [GPSDEVICE]
+ *     SHM_BROADCAST=true
+ *     SHM_SOCKET=/run/location/nyx-gps-shm.sock
+ *
+ * The socket directory is created 0755 if missing, and an existing path is
+ * only replaced when it is a stale socket.
+ */
+class GpsShmPublisher
+{
+public:
+    static GpsShmPublisher *getInstance();
+    bool init(const std::string &configFile);
+    bool start(const std::string &socketPath);
+    void stop();
+    bool isActive() const { return mRegion != nullptr; }
+    unsigned int getServedClients() const { return mServedClients; }
+    void publishLocation(const GpsLocation *location);
+    void publishSvStatus(const GpsSvStatus *svStatus);
+
+private:
+    GpsShmPublisher();
+    ~GpsShmPublisher();
+    bool createRegion();
+    bool createListenSocket();
+    bool removeStaleSocket();
+    gps_shm_slot_t *beginWrite(uint32_t type);
+    void endWrite(gps_shm_slot_t *slot);
+    gboolean acceptClient();
+    static gboolean acceptCallback(GIOChannel *, GIOCondition, gpointer);
+
+    int mMemFd;
+    int mListenFd;
+    gps_shm_region_t *mRegion;
+    GIOChannel *mListenChannel;
+    guint mListenWatchId;
+    unsigned int mServedClients;
+    std::string mSocketPath;
+    std::mutex mWriteLock;
+};
+
+#endif // _GPS_SHM_PUBLISHER_H_
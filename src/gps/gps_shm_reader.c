@@ -0,0 +1,234 @@
+/* @@@LICENSE
+ * *
+ * * Copyright (c) 2024 LG Electronics, Inc.
+ * *
+ * * Licensed under the Apache License, Version 2.0 (the "License");
+ * * you may not use this file except in compliance with the License.
+ * * You may obtain a copy of the License at
+ * *
+ * * http://www.apache.org/licenses/LICENSE-2.0
+ * *
+ * * Unless required by applicable law or agreed to in writing, software
+ * * distributed under the License is distributed on an "AS IS" BASIS,
+ * * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * * See the License for the specific language governing permissions and
+ * * limitations under the License.
+ * * SPDX-License-Identifier: Apache-2.0
+ * *
+ * * LICENSE@@@ */
+
+/*
+ * *******************************************************************/
+
+#include <errno.h>
+#include <limits.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <sys/un.h>
+
+#include "gps_shm_reader.h"
+
+struct gps_shm_reader {
+    const gps_shm_region_t  *region;
+    size_t                  size;
+    uint64_t                next;
+    uint64_t                lost;
+};
+
+static int receive_region_fd(int sock, uint32_t *size)
+{
+    char cbuf[CMSG_SPACE(sizeof(int))];
+    struct iovec iov = { size, sizeof(*size) };
+    struct msghdr msg;
+    struct cmsghdr *cmsg;
+    int fd = -1;
+
+    memset(&msg, 0, sizeof(msg));
+    memset(cbuf, 0, sizeof(cbuf));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = cbuf;
+    msg.msg_controllen = sizeof(cbuf);
+
+    if (recvmsg(sock, &msg, MSG_CMSG_CLOEXEC) != (ssize_t)sizeof(*size))
+        return -1;
+
+    cmsg = CMSG_FIRSTHDR(&msg);
+    if (cmsg && cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS)
+        memcpy(&fd, CMSG_DATA(cmsg), sizeof(int));
+
+    return fd;
+}
+
+gps_shm_reader_t *gps_shm_reader_open(const char *socket_path)
+{
+    struct sockaddr_un addr;
+    gps_shm_reader_t *reader = NULL;
+    void *map = MAP_FAILED;
+    uint32_t size = 0;
+    int sock = -1;
+    int fd = -1;
+
+    if (socket_path == NULL)
+        socket_path = GPS_SHM_DEFAULT_SOCKET;
+
+    if (strlen(socket_path) >= sizeof(addr.sun_path))
+        return NULL;
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, socket_path);
+
+    if ((sock = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0)) < 0)
+        goto ERROR_HANDLER;
+
+    if (connect(sock, (struct sockaddr *)&addr, sizeof(addr)) < 0)
+        goto ERROR_HANDLER;
+
+    if ((fd = receive_region_fd(sock, &size)) < 0 || size < sizeof(gps_shm_region_t))
+        goto ERROR_HANDLER;
+
+    map = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+    if (map == MAP_FAILED)
+        goto ERROR_HANDLER;
+
+    if (((const gps_shm_region_t *)map)->magic != GPS_SHM_MAGIC ||
+        ((const gps_shm_region_t *)map)->version != GPS_SHM_VERSION ||
+        ((const gps_shm_region_t *)map)->slot_count != GPS_SHM_RING_SLOTS)
+        goto ERROR_HANDLER;
+
+    if (!(reader = (gps_shm_reader_t *)calloc(1, sizeof(gps_shm_reader_t))))
+        goto ERROR_HANDLER;
+
+    reader->region = (const gps_shm_region_t *)map;
+    reader->size = size;
+    reader->next = __atomic_load_n(&reader->region->head, __ATOMIC_ACQUIRE);
+    // Hand out the latest record first so a late joiner has a fix immediately
+    if (reader->next)
+        reader->next--;
+
+    close(fd);
+    close(sock);
+    return reader;
+
+ERROR_HANDLER:
+    if (map != MAP_FAILED)
+        munmap(map, size);
+    if (fd >= 0)
+        close(fd);
+    if (sock >= 0)
+        close(sock);
+    return NULL;
+}
+
+void gps_shm_reader_close(gps_shm_reader_t *reader)
+{
+    if (reader == NULL)
+        return;
+
+    munmap((void *)reader->region, reader->size);
+    free(reader);
+}
+
+int gps_shm_reader_wait(gps_shm_reader_t *reader, int timeout_ms)
+{
+    struct timespec deadline;
+    struct timespec now;
+    struct timespec ts;
+    uint32_t futex_val;
+    long ret;
+
+    if (reader == NULL)
+        return -1;
+
+    if (timeout_ms >= 0) {
+        clock_gettime(CLOCK_MONOTONIC, &deadline);
+        deadline.tv_sec += timeout_ms / 1000;
+        deadline.tv_nsec += (timeout_ms % 1000) * 1000000L;
+        if (deadline.tv_nsec >= 1000000000L) {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000L;
+        }
+    }
+
+    for (;;) {
+        // Sample the futex word before head so a publish in between makes FUTEX_WAIT return at once
+        futex_val = __atomic_load_n(&reader->region->futex, __ATOMIC_ACQUIRE);
+        if (reader->next < __atomic_load_n(&reader->region->head, __ATOMIC_ACQUIRE))
+            return 1;
+
+        // FUTEX_WAIT takes a relative timeout, so recompute what is left after every wake
+        if (timeout_ms >= 0) {
+            clock_gettime(CLOCK_MONOTONIC, &now);
+            ts.tv_sec = deadline.tv_sec - now.tv_sec;
+            ts.tv_nsec = deadline.tv_nsec - now.tv_nsec;
+            if (ts.tv_nsec < 0) {
+                ts.tv_sec--;
+                ts.tv_nsec += 1000000000L;
+            }
+            if (ts.tv_sec < 0)
+                return 0;
+        }
+
+        ret = syscall(SYS_futex, &reader->region->futex, FUTEX_WAIT, futex_val,
+                      timeout_ms < 0 ? NULL : &ts, NULL, 0);
+        if (ret < 0 && errno == ETIMEDOUT)
+            return 0;
+        if (ret < 0 && errno != EAGAIN && errno != EINTR)
+            return -1;
+    }
+}
+
+int gps_shm_reader_next(gps_shm_reader_t *reader, gps_shm_record_t *rec)
+{
+    const gps_shm_slot_t *slot;
+    uint64_t head;
+    uint32_t seq;
+
+    if (reader == NULL || rec == NULL)
+        return 0;
+
+    for (;;) {
+        head = __atomic_load_n(&reader->region->head, __ATOMIC_ACQUIRE);
+        if (reader->next >= head)
+            return 0;
+
+        // The writer lapped us, skip to the oldest record still in the ring
+        if (head - reader->next > GPS_SHM_RING_SLOTS) {
+            reader->lost += head - GPS_SHM_RING_SLOTS - reader->next;
+            reader->next = head - GPS_SHM_RING_SLOTS;
+        }
+
+        slot = &reader->region->slots[reader->next % GPS_SHM_RING_SLOTS];
+        seq = __atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE);
+        if (seq & 1) {
+            sched_yield();
+            continue;
+        }
+
+        memcpy(rec, &slot->record, sizeof(gps_shm_record_t));
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+
+        if (seq != __atomic_load_n(&slot->seq, __ATOMIC_RELAXED))
+            continue;
+
+        // Slot was reused for a newer lap while we looked at head; re-evaluate
+        if (rec->index != reader->next)
+            continue;
+
+        reader->next++;
+        return 1;
+    }
+}
+
+uint64_t gps_shm_reader_lost(const gps_shm_reader_t *reader)
+{
+    return reader ? reader->lost : 0;
+}
@@ -0,0 +1,72 @@
+/* @@@LICENSE
+ * *
+ * * Copyright (c) 2024 LG Electronics, Inc.
+ * *
+ * * Licensed under the Apache License, Version 2.0 (the "License");
+ * * you may not use this file except in compliance with the License.
+ * * You may obtain a copy of the License at
+ * *
+ * * http://www.apache.org/licenses/LICENSE-2.0
+ * *
+ * * Unless required by applicable law or agreed to in writing, software
+ * * distributed under the License is distributed on an "AS IS" BASIS,
+ * * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * * See the License for the specific language governing permissions and
+ * * limitations under the License.
+ * * SPDX-License-Identifier: Apache-2.0
+ * *
+ * * LICENSE@@@ */
+
+/*
+ * Consumer side of the GPS shared-memory broadcast.
+ *
+ * Typical use:
+ *
+ *     gps_shm_reader_t *r = gps_shm_reader_open(NULL);
+ *     gps_shm_record_t rec;
+ *     while (gps_shm_reader_wait(r, -1) >= 0)
+ *         while (gps_shm_reader_next(r, &rec) > 0)
+ *             handle(&rec);
+ *     gps_shm_reader_close(r);
+ * *******************************************************************/
+
+#ifndef _GPS_SHM_READER_H_
+#define _GPS_SHM_READER_H_
+
+#include "gps_shm.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct gps_shm_reader gps_shm_reader_t;
+
+/**
+ * Connect to the publisher socket (GPS_SHM_DEFAULT_SOCKET if NULL), receive
+ * the shared region and map it read-only. Reading starts at the newest
+ * record. Returns NULL on failure.
+ */
+gps_shm_reader_t *gps_shm_reader_open(const char *socket_path);
+void gps_shm_reader_close(gps_shm_reader_t *reader);
+
+/**
+ * Block until a record newer than the last one read is available.
+ * timeout_ms < 0 waits forever.
+ * Returns 1 if data is available, 0 on timeout, -1 on error.
+ */
+int gps_shm_reader_wait(gps_shm_reader_t *reader, int timeout_ms);
+
+/**
+ * Copy the next unread record into rec.
+ * Returns 1 if a record was copied, 0 if there is nothing new.
+ */
+int gps_shm_reader_next(gps_shm_reader_t *reader, gps_shm_record_t *rec);
+
+/** Number of records overwritten before this reader could copy them. */
+uint64_t gps_shm_reader_lost(const gps_shm_reader_t *reader);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // _GPS_SHM_READER_H_
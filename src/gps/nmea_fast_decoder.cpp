@@ -0,0 +1,232 @@
+/* @@@LICENSE
+ * *
+ * * Copyright (c) 2024 LG Electronics, Inc.
+ * *
+ * * Licensed under the Apache License, Version 2.0 (the "License");
+ * * you may not use this file except in compliance with the License.
+ * * You may obtain a copy of the License at
+ * *
+ * * http://www.apache.org/licenses/LICENSE-2.0
+ * *
+ * * Unless required by applicable law or agreed to in writing, software
+ * * distributed under the License is distributed on an "AS IS" BASIS,
+ * * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * * See the License for the specific language governing permissions and
+ * * limitations under the License.
+ * * SPDX-License-Identifier: Apache-2.0
+ * *
+ * * LICENSE@@@ */
+
+/*
+ * *******************************************************************/
+
+#include <charconv>
+#include <cstring>
+
+#include "nmea_fast_decoder.h"
+
+constexpr unsigned int NMEA_MAX_FIELDS = 20;
+constexpr int64_t NANO = 1000000000LL;
+
+struct NmeaField
+{
+    const char *begin;
+    const char *end;
+};
+
+static size_t trimLineEnd(const char *sentence, size_t len)
+{
+    while (len && (sentence[len - 1] == '\n' || sentence[len - 1] == '\r'))
+        len--;
+    return len;
+}
+
+/*
+ * Splits the data fields of a classified sentence, i.e. everything between
+ * the address field and '*'. Returns the number of fields.
+ */
+static unsigned int splitFields(const char *sentence, size_t len, NmeaField *fields)
+{
+    const char *pos = sentence + 7;
+    const char *end = sentence + trimLineEnd(sentence, len) - 3;
+    unsigned int count = 0;
+
+    while (count < NMEA_MAX_FIELDS)
+    {
+        const char *sep = (const char *)memchr(pos, ',', end - pos);
+
+        fields[count].begin = pos;
+        fields[count].end = sep ? sep : end;
+        count++;
+
+        if (!sep)
+            break;
+        pos = sep + 1;
+    }
+
+    return count;
+}
+
+template <typename T>
+static bool parseInteger(const char *begin, const char *end, T &value, int base = 10)
+{
+    value = 0;
+    if (begin == end)
+        return true;
+
+    auto result = std::from_chars(begin, end, value, base);
+    return result.ec == std::errc() && result.ptr == end;
+}
+
+/*
+ * Accepts the sentence only when it is a well formed "$GPGGA,...*hh" or
+ * "$GPRMC,...*hh" with a matching checksum; anything else is left to the
+ * library, which also reports the errors.
+ */
+NmeaFastSentence NmeaFastDecoder::classify(const char *sentence, size_t len)
+{
+    NmeaFastSentence type;
+    unsigned int expected;
+    unsigned char sum = 0;
+
+    len = trimLineEnd(sentence, len);
+    if (len < 10 || sentence[0] != '$' || memcmp(sentence + 1, "GP", 2) != 0)
+        return NMEA_FAST_NONE;
+
+    if (memcmp(sentence + 3, "GGA,", 4) == 0)
+        type = NMEA_FAST_GGA;
+    else if (memcmp(sentence + 3, "RMC,", 4) == 0)
+        type = NMEA_FAST_RMC;
+    else
+        return NMEA_FAST_NONE;
+
+    if (sentence[len - 3] != '*' || !parseInteger(sentence + len - 2, sentence + len, expected, 16))
+        return NMEA_FAST_NONE;
+
+    for (size_t i = 1; i < len - 3; i++)
+        sum ^= (unsigned char)sentence[i];
+
+    return sum == expected ? type : NMEA_FAST_NONE;
+}
+
+/*
+ * Reads a decimal number as an integer scaled by 10^decimals, truncating
+ * further digits: "12.3456" with 3 decimals gives 12345.
+ */
+bool NmeaFastDecoder::parseFixed(const char *begin, const char *end, unsigned int decimals, int64_t &value)
+{
+    const char *dot = (const char *)memchr(begin, '.', end - begin);
+    const char *fracEnd;
+    bool negative = begin != end && *begin == '-';
+    int64_t integer, fraction;
+    unsigned int digits;
+
+    if (negative)
+        begin++;
+    if (!dot)
+        dot = end;
+
+    // from_chars would accept a sign of its own
+    if ((begin != dot && *begin == '-') || (dot + 1 < end && dot[1] == '-'))
+        return false;
+
+    // The scaled value has to fit an int64_t: 18 digits in all
+    if (dot - begin > (ptrdiff_t)(18 - decimals))
+        return false;
+
+    digits = dot == end ? 0 : end - dot - 1;
+    fracEnd = dot == end ? end : dot + 1 + (digits < decimals ? digits : decimals);
+
+    if (!parseInteger(begin, dot, integer) || !parseInteger(dot == end ? end : dot + 1, fracEnd, fraction))
+        return false;
+
+    // Truncated digits must still be digits
+    for (const char *p = fracEnd; p < end; p++)
+        if (*p < '0' || *p > '9')
+            return false;
+
+    for (unsigned int i = fracEnd - (dot == end ? end : dot + 1); i < decimals; i++)
+        fraction *= 10;
+    for (unsigned int i = 0; i < decimals; i++)
+        integer *= 10;
+
+    value = negative ? -(integer + fraction) : integer + fraction;
+    return true;
+}
+
+/*
+ * NMEA "dddmm.mmmm" to 1e-9 degrees, without going through floating point.
+ */
+bool NmeaFastDecoder::parseCoordinate(const char *begin, const char *end, char hemisphere, int64_t &nanoDegrees)
+{
+    int64_t raw;
+
+    // Minutes with 9 decimals: dddmm.mmmmmmmmm * 1e9
+    if (!parseFixed(begin, end, 9, raw) || raw < 0)
+        return false;
+
+    int64_t degrees = raw / (100 * NANO);
+    int64_t minutes = raw % (100 * NANO);
+
+    if (minutes >= 60 * NANO)
+        return false;
+
+    nanoDegrees = degrees * NANO + (minutes + 30) / 60;
+    if (hemisphere == 'S' || hemisphere == 'W')
+        nanoDegrees = -nanoDegrees;
+    return true;
+}
+
+/*
+ * $GPGGA,time,lat,N,lon,E,quality,sats,hdop,alt,M,sep,M,age,station*hh
+ */
+bool NmeaFastDecoder::decodeGGA(const char *sentence, size_t len, gps_data &data, int &satsUsed)
+{
+    NmeaField f[NMEA_MAX_FIELDS];
+    int64_t latitude, longitude, hdop, altitude;
+    int quality, sats;
+
+    if (splitFields(sentence, len, f) < 9)
+        return false;
+
+    if (!parseCoordinate(f[1].begin, f[1].end, f[2].begin != f[2].end ? *f[2].begin : 0, latitude) ||
+        !parseCoordinate(f[3].begin, f[3].end, f[4].begin != f[4].end ? *f[4].begin : 0, longitude) ||
+        !parseInteger(f[5].begin, f[5].end, quality) ||
+        !parseInteger(f[6].begin, f[6].end, sats) ||
+        !parseFixed(f[7].begin, f[7].end, 3, hdop) ||
+        !parseFixed(f[8].begin, f[8].end, 3, altitude))
+        return false;
+
+    data.latitude = (double)latitude / NANO;
+    data.longitude = (double)longitude / NANO;
+    data.altitude = altitude / 1000.0;
+    data.horizAccuracy = hdop / 1000.0;
+    data.fixQuality = quality;
+    satsUsed = sats;
+    return true;
+}
+
+/*
+ * $GPRMC,time,status,lat,N,lon,E,knots,course,date,magvar,E,mode*hh
+ */
+bool NmeaFastDecoder::decodeRMC(const char *sentence, size_t len, gps_data &data)
+{
+    NmeaField f[NMEA_MAX_FIELDS];
+    int64_t latitude, longitude, knots, course;
+
+    if (splitFields(sentence, len, f) < 8)
+        return false;
+
+    if (!parseCoordinate(f[2].begin, f[2].end, f[3].begin != f[3].end ? *f[3].begin : 0, latitude) ||
+        !parseCoordinate(f[4].begin, f[4].end, f[5].begin != f[5].end ? *f[5].begin : 0, longitude) ||
+        !parseFixed(f[6].begin, f[6].end, 3, knots) ||
+        !parseFixed(f[7].begin, f[7].end, 3, course))
+        return false;
+
+    data.latitude = (double)latitude / NANO;
+    data.longitude = (double)longitude / NANO;
+    // Same knots to m/s factor as the library path
+    data.speed = knots / 1000.0 * 0.514;
+    data.direction = course / 1000.0;
+    return true;
+}
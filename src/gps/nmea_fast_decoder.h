@@ -0,0 +1,57 @@
+/* @@@LICENSE
+ * *
+ * * Copyright (c) 2024 LG Electronics, Inc.
+ * *
+ * * Licensed under the Apache License, Version 2.0 (the "License");
+ * * you may not use this file except in compliance with the License.
+ * * You may obtain a copy of the License at
+ * *
+ * * http://www.apache.org/licenses/LICENSE-2.0
+ * *
+ * * Unless required by applicable law or agreed to in writing, software
+ * * distributed under the License is distributed on an "AS IS" BASIS,
+ * * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * * See the License for the specific language governing permissions and
+ * * limitations under the License.
+ * * SPDX-License-Identifier: Apache-2.0
+ * *
+ * * LICENSE@@@ */
+
+/*
+ * *******************************************************************/
+
+#ifndef _NMEA_FAST_DECODER_H_
+#define _NMEA_FAST_DECODER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include "parser_nmea.h"
+
+enum NmeaFastSentence
+{
+    NMEA_FAST_NONE,
+    NMEA_FAST_GGA,
+    NMEA_FAST_RMC
+};
+
+/*
+ * Decoder for the two sentences location is built from, GPGGA and GPRMC,
+ * that bypasses CNMEAParser: fields are split in place, numbers are read
+ * with std::from_chars into fixed point (coordinates in 1e-9 degrees) and
+ * the result is written straight into gps_data. Nothing is allocated.
+ *
+ * decodeGGA()/decodeRMC() only touch the fields of gps_data the sentence
+ * carries, and nothing at all when a field is malformed. Empty fields read
+ * as 0 like they do through the library.
+ */
+class NmeaFastDecoder
+{
+public:
+    static NmeaFastSentence classify(const char *sentence, size_t len);
+    static bool decodeGGA(const char *sentence, size_t len, gps_data &data, int &satsUsed);
+    static bool decodeRMC(const char *sentence, size_t len, gps_data &data);
+    static bool parseCoordinate(const char *begin, const char *end, char hemisphere, int64_t &nanoDegrees);
+    static bool parseFixed(const char *begin, const char *end, unsigned int decimals, int64_t &value);
+};
+
+#endif // _NMEA_FAST_DECODER_H_
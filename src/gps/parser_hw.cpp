@@ -36,6 +36,13 @@
 ParserHW::ParserHW()
   : mParserThreadPoolObj(nullptr)
   , mParserRequested(false)
+  , mMinInterval(0)
+  , mPreferredAccuracy(0)
+  , mDutyState(DUTY_OFF)
+  , mWakeTimerId(0)
+  , mCycleStart(0)
+  , mSessionStart(0)
+  , mActiveTime(0)
 {
     mGPSDeviceObj = GPSDevice::getInstance();
 }
@@ -61,6 +68,7 @@ bool ParserHW::init()
       return false;
 
     mParserRequested = true;
+    startDutyCycle();
 
     return true;
 }
@@ -73,6 +81,7 @@ bool ParserHW::isSourcePresent()
 bool ParserHW::deinit()
 {
     mParserRequested = false;
+    stopDutyCycle();
 
     SetGpsStatus(NYX_GPS_STATUS_SESSION_END);
 
@@ -87,6 +96,8 @@ bool ParserHW::startParsing()
     {
         createThreadPool();
         SetGpsStatus(NYX_GPS_STATUS_SESSION_BEGIN);
+        // Warm restart: report what arrived during standby right away
+        mGPSDeviceObj->replayLastEpoch();
     }
     return false;
 }
@@ -113,4 +124,185 @@ bool ParserHW::createThreadPool()
         nyx_info("MSGID_NMEA_PARSER_HW", 0, "Created HW ThreadPool with interval: %d \n", interval);
     }
     return true;
-}
\ No newline at end of file
+}
+
+void ParserHW::setPositionMode(unsigned int minInterval, unsigned int preferredAccuracy)
+{
+    std::lock_guard<std::mutex> lock(mDutyLock);
+    mMinInterval = minInterval;
+    mPreferredAccuracy = preferredAccuracy;
+    nyx_info("MSGID_NMEA_PARSER_HW", 0, "position mode interval: %u ms, accuracy: %u m\n",
+             minInterval, preferredAccuracy);
+
+    if (!mParserRequested)
+        return;
+
+    bool duty = mMinInterval >= DUTY_CYCLE_MIN_INTERVAL_MS;
+    gint64 now = g_get_monotonic_time();
+
+    switch (mDutyState)
+    {
+    case DUTY_OFF:
+        if (duty)
+        {
+            mActiveTime += now - mCycleStart;
+            mCycleStart = now;
+            mDutyState = DUTY_ACQUIRING;
+            nyx_info("MSGID_NMEA_PARSER_HW", 0, "duty cycling receiver input every %u ms\n", mMinInterval);
+        }
+        break;
+    case DUTY_ACQUIRING:
+        if (!duty)
+            mDutyState = DUTY_OFF;
+        break;
+    case DUTY_IDLE:
+        // Move the pending wake-up to the new interval, wakeReceiver() decides
+        // whether to keep cycling. Without a timer the suspend is still queued
+        // and will pick up the new interval itself.
+        if (mWakeTimerId)
+        {
+            g_source_remove(mWakeTimerId);
+            scheduleWake();
+        }
+        break;
+    }
+}
+
+void ParserHW::startDutyCycle()
+{
+    std::lock_guard<std::mutex> lock(mDutyLock);
+
+    mSessionStart = mCycleStart = g_get_monotonic_time();
+    mActiveTime = 0;
+    mDutyState = mMinInterval >= DUTY_CYCLE_MIN_INTERVAL_MS ? DUTY_ACQUIRING : DUTY_OFF;
+
+    if (mDutyState != DUTY_OFF)
+        nyx_info("MSGID_NMEA_PARSER_HW", 0, "duty cycling receiver input every %u ms\n", mMinInterval);
+}
+
+void ParserHW::stopDutyCycle()
+{
+    std::lock_guard<std::mutex> lock(mDutyLock);
+
+    if (mWakeTimerId)
+    {
+        g_source_remove(mWakeTimerId);
+        mWakeTimerId = 0;
+    }
+
+    if (mDutyState == DUTY_OFF)
+        return;
+
+    if (mDutyState == DUTY_ACQUIRING)
+        mActiveTime += g_get_monotonic_time() - mCycleStart;
+    mDutyState = DUTY_OFF;
+
+    gint64 elapsed = g_get_monotonic_time() - mSessionStart;
+    nyx_info("MSGID_NMEA_PARSER_HW", 0, "duty cycle session active ratio: %.3f\n",
+             elapsed > 0 ? (double)mActiveTime / elapsed : 1.0);
+}
+
+double ParserHW::getActiveRatio()
+{
+    std::lock_guard<std::mutex> lock(mDutyLock);
+    gint64 now = g_get_monotonic_time();
+    gint64 active = mActiveTime;
+
+    if (mDutyState != DUTY_IDLE)
+        active += now - mCycleStart;
+
+    return now > mSessionStart ? (double)active / (now - mSessionStart) : 1.0;
+}
+
+/*
+ * Called from the parser thread for every location about to be reported.
+ * While duty cycling only the first GGA fix meeting the requested accuracy
+ * after each wake-up is let through; the receiver input is then suspended
+ * until the next interval is due. An RMC carries no fix quality or HDOP of
+ * its own, so it never ends a cycle.
+ */
+bool ParserHW::onLocation(const gps_data &data, bool gga)
+{
+    std::lock_guard<std::mutex> lock(mDutyLock);
+
+    if (mDutyState == DUTY_OFF)
+        return true;
+    if (mDutyState == DUTY_IDLE)
+        return false;
+    if (!gga || data.fixQuality <= 0)
+        return false;
+
+    gint64 acquiring = g_get_monotonic_time() - mCycleStart;
+    bool accurate = !mPreferredAccuracy || (data.horizAccuracy >= 0 &&
+                    data.horizAccuracy * GPS_UERE_METERS <= mPreferredAccuracy);
+
+    if (!accurate && acquiring < (gint64)DUTY_CYCLE_ACQUIRE_TIMEOUT_MS * 1000)
+        return false;
+
+    mDutyState = DUTY_IDLE;
+    g_idle_add(suspendCallback, this);
+    return true;
+}
+
+gboolean ParserHW::suspendCallback(gpointer user_data)
+{
+    ParserHW *ptr = (ParserHW *)user_data;
+    return ptr->suspendReceiver();
+}
+
+gboolean ParserHW::suspendReceiver()
+{
+    std::lock_guard<std::mutex> lock(mDutyLock);
+
+    // Session ended before the main loop got here
+    if (mDutyState != DUTY_IDLE || mWakeTimerId)
+        return FALSE;
+
+    mActiveTime += g_get_monotonic_time() - mCycleStart;
+    mGPSDeviceObj->pauseReading();
+    scheduleWake();
+
+    return FALSE;
+}
+
+// Called with mDutyLock held; the interval counts from the start of the last wake-up
+void ParserHW::scheduleWake()
+{
+    gint64 sleepUs = (gint64)mMinInterval * 1000 - (g_get_monotonic_time() - mCycleStart);
+
+    mWakeTimerId = g_timeout_add(sleepUs > 0 ? sleepUs / 1000 : 0, wakeCallback, this);
+}
+
+gboolean ParserHW::wakeCallback(gpointer user_data)
+{
+    ParserHW *ptr = (ParserHW *)user_data;
+    return ptr->wakeReceiver();
+}
+
+gboolean ParserHW::wakeReceiver()
+{
+    std::lock_guard<std::mutex> lock(mDutyLock);
+
+    // Replaced by setPositionMode() or removed by stopDutyCycle() while this waited for the lock
+    if (mWakeTimerId != g_source_get_id(g_main_current_source()))
+        return FALSE;
+
+    mWakeTimerId = 0;
+    if (mDutyState != DUTY_IDLE)
+        return FALSE;
+
+    // Interval may have been shortened below the threshold meanwhile
+    mDutyState = mMinInterval >= DUTY_CYCLE_MIN_INTERVAL_MS ? DUTY_ACQUIRING : DUTY_OFF;
+    mCycleStart = g_get_monotonic_time();
+
+    // Queued ahead of anything read from now on: the last cycle's fix says nothing about this one
+    if (mParserThreadPoolObj)
+        mParserThreadPoolObj->enqueue([]() { ParserNmea::getInstance()->resetFix(); });
+    mGPSDeviceObj->resumeReading();
+
+    gint64 elapsed = mCycleStart - mSessionStart;
+    nyx_debug("MSGID_NMEA_PARSER_HW : duty cycle active ratio %.3f",
+              elapsed > 0 ? (double)mActiveTime / elapsed : 1.0);
+
+    return FALSE;
+}
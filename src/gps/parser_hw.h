@@ -25,11 +25,21 @@
 #ifndef _PARSER_HW_H_
 #define _PARSER_HW_H_
 
+#include <mutex>
+#include <glib.h>
 #include <nmeaparser/NMEAParser.h>
+#include "parser_nmea.h"
 
 class GPSDevice;
 class ParserThreadPool;
 
+// Requested intervals at or above this switch the receiver input to duty cycling
+constexpr unsigned int DUTY_CYCLE_MIN_INTERVAL_MS = 10000;
+// After this long in a wake-up any valid fix is accepted, accurate or not
+constexpr unsigned int DUTY_CYCLE_ACQUIRE_TIMEOUT_MS = 15000;
+// Typical user equivalent range error, turns HDOP into metres
+constexpr double GPS_UERE_METERS = 5.0;
+
 class ParserHW
 {
 public:
@@ -43,11 +53,37 @@ public:
     bool isSourcePresent();
     bool isParserRequested() const { return mParserRequested; }
     ParserThreadPool* getThreadPoolObj() const { return mParserThreadPoolObj; }
+    void setPositionMode(unsigned int minInterval, unsigned int preferredAccuracy);
+    bool onLocation(const gps_data &data, bool gga);
+    double getActiveRatio();
 private:
+    enum DutyState
+    {
+        DUTY_OFF,
+        DUTY_ACQUIRING,
+        DUTY_IDLE
+    };
+
     GPSDevice *mGPSDeviceObj;
     bool createThreadPool();
+    void startDutyCycle();
+    void stopDutyCycle();
+    void scheduleWake();
+    gboolean suspendReceiver();
+    gboolean wakeReceiver();
+    static gboolean suspendCallback(gpointer);
+    static gboolean wakeCallback(gpointer);
     bool mParserRequested;
     ParserThreadPool *mParserThreadPoolObj;
+
+    std::mutex mDutyLock;
+    unsigned int mMinInterval;
+    unsigned int mPreferredAccuracy;
+    DutyState mDutyState;
+    guint mWakeTimerId;
+    gint64 mCycleStart;
+    gint64 mSessionStart;
+    gint64 mActiveTime;
 };
 
 #endif // end _PARSER_HW_H_
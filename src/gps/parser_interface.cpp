@@ -26,6 +26,11 @@
 
 #include "parser_nmea.h"
 #include "parser_thread_pool.h"
+#include "gps_shm_publisher.h"
+#include "parser_hw.h"
+#include "gps_batcher.h"
+#include "gps_device.h"
+#include "gps_session_stats.h"
 
 
 #ifdef __cplusplus
@@ -47,11 +52,22 @@ static gps_request_utc_time gps_req_utc_cb = nullptr;
 static gps_create_thread gps_cre_thr_cb = nullptr;
 
 void parser_loc_cb(GpsLocation* location, void* locExt) {
-    if (parsing_engine_on && gps_loc_cb)
+    if (parsing_engine_on)
+        GpsShmPublisher::getInstance()->publishLocation(location);
+
+    if (!parsing_engine_on)
+        return;
+
+    if (GpsBatcher::getInstance()->isActive())
+        GpsBatcher::getInstance()->add(location);
+    else if (gps_loc_cb)
         gps_loc_cb(location);
 }
 
 void parser_sv_cb(GpsSvStatus* sv_status, void* svExt) {
+    if (parsing_engine_on)
+        GpsShmPublisher::getInstance()->publishSvStatus(sv_status);
+
     if (parsing_engine_on && gps_sv_cb)
         gps_sv_cb(sv_status);
 }
@@ -72,6 +88,11 @@ static int  loc_init(GpsCallbacks* callbacks);
 static int  loc_start();
 static int  loc_stop();
 static void loc_cleanup();
+static int  loc_set_position_mode(uint32_t mode, uint32_t recurrence, uint32_t min_interval,
+                                  uint32_t preferred_accuracy, uint32_t preferred_time);
+static int  loc_set_batching(uint32_t batch_size, uint32_t period_ms, gps_batch_callback callback);
+static int  loc_flush_batch();
+static int  loc_get_session_stats(nyx_gps_session_stats_t *stats, uint32_t max);
 
 // Defines the GpsInterface
 static const GpsInterface sLocEngInterface =
@@ -80,7 +101,11 @@ static const GpsInterface sLocEngInterface =
    loc_init,
    loc_start,
    loc_stop,
-   loc_cleanup
+   loc_cleanup,
+   loc_set_position_mode,
+   loc_set_batching,
+   loc_flush_batch,
+   loc_get_session_stats
 };
 
 const GpsInterface* get_gps_interface() {
@@ -109,6 +134,12 @@ static int loc_init(GpsCallbacks* callbacks)
     parserNmeaObj = ParserNmea::getInstance();
     parserThreadPoolObj = getThreadInstance();
 
+    const std::string &configFile = GPSDevice::getInstance()->getConfigFile();
+
+    GpsShmPublisher::getInstance()->init(configFile);
+    GpsBatcher::getInstance()->init(configFile);
+    GpsSessionStats::getInstance()->init(configFile);
+
     //parserThreadPoolObj->enqueue(&SetGpsStatus, NYX_GPS_STATUS_ENGINE_ON);
     return 0;
 }
@@ -134,6 +165,9 @@ static int  loc_stop() {
 static void loc_cleanup() {
     SetGpsStatus(NYX_GPS_STATUS_ENGINE_OFF);
     parsing_engine_on = false;
+    GpsShmPublisher::getInstance()->stop();
+    GpsBatcher::getInstance()->disable();
+    GPSDevice::getInstance()->closeStandby();
     gps_loc_cb = nullptr;
     gps_sv_cb = nullptr;
     gps_status_cb = nullptr;
@@ -145,6 +179,33 @@ static void loc_cleanup() {
     gps_cre_thr_cb = nullptr;
 }
 
+static int loc_set_position_mode(uint32_t mode, uint32_t recurrence, uint32_t min_interval,
+                                 uint32_t preferred_accuracy, uint32_t preferred_time) {
+    ParserHW::getInstance()->setPositionMode(min_interval, preferred_accuracy);
+    return 0;
+}
+
+static int loc_set_batching(uint32_t batch_size, uint32_t period_ms, gps_batch_callback callback) {
+    if (!batch_size && !period_ms) {
+        GpsBatcher::getInstance()->disable();
+        return 0;
+    }
+
+    return GpsBatcher::getInstance()->configure(batch_size, period_ms, callback) ? 0 : -1;
+}
+
+static int loc_flush_batch() {
+    if (!GpsBatcher::getInstance()->isActive())
+        return -1;
+
+    GpsBatcher::getInstance()->flush();
+    return 0;
+}
+
+static int loc_get_session_stats(nyx_gps_session_stats_t *stats, uint32_t max) {
+    return GpsSessionStats::getInstance()->query(stats, max);
+}
+
 bool startParsing() {
     parsing_engine_on = true;
 
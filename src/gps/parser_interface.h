@@ -25,6 +25,8 @@
 #include <nyx/common/nyx_gps_common.h>
 #include <nyx/module/nyx_log.h>
 
+#include "gps_session.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -82,6 +84,7 @@ typedef void (* gps_acquire_wakelock)();
 typedef void (* gps_release_wakelock)();
 typedef void (* gps_request_utc_time)();
 typedef pthread_t (* gps_create_thread)(const char* name, void (*start)(void *), void* arg);
+typedef void (* gps_batch_callback)(GpsLocation* locations, uint32_t count);
 
 typedef struct {
     size_t      size;
@@ -104,6 +107,11 @@ typedef struct {
     int   (*start)( void );
     int   (*stop)( void );
     void  (*cleanup)( void );
+    int   (*set_position_mode)( uint32_t mode, uint32_t recurrence, uint32_t min_interval,
+                                uint32_t preferred_accuracy, uint32_t preferred_time );
+    int   (*set_batching)( uint32_t batch_size, uint32_t period_ms, gps_batch_callback callback );
+    int   (*flush_batch)( void );
+    int   (*get_session_stats)( nyx_gps_session_stats_t *stats, uint32_t max );
 } webos_gps_interface;
 
 #define GpsInterface                    webos_gps_interface
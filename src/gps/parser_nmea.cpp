@@ -34,6 +34,8 @@
 #include "parser_interface.h"
 #include "parser_mock.h"
 #include "parser_hw.h"
+#include "gps_session_stats.h"
+#include "nmea_fast_decoder.h"
 
 int64_t getCurrentTime() {
     struct timeval tval;
@@ -41,7 +43,7 @@ int64_t getCurrentTime() {
     return (tval.tv_sec * 1000LL + tval.tv_usec/1000);
 }
 
-void ParserNmea::sendLocationUpdates() {
+void ParserNmea::sendLocationUpdates(bool gga) {
     GpsLocation location;
     memset(&location, 0, sizeof(GpsLocation));
 
@@ -52,6 +54,10 @@ void ParserNmea::sendLocationUpdates() {
     location.accuracy = mGpsData.horizAccuracy;
     location.timestamp = getCurrentTime();
 
+    // Duty-cycled HW sessions only deliver the first good fix of each wake-up
+    if (!ParserHW::getInstance()->onLocation(mGpsData, gga))
+        return;
+
     parser_loc_cb(&location, nullptr);
 }
 
@@ -79,8 +85,12 @@ bool ParserNmea::SetGpsGGA_Data(CNMEAParserData::GGA_DATA_T* ggaData, char *nmea
     mGpsData.longitude = ggaData->m_dLongitude;
     mGpsData.altitude = ggaData->m_dAltitudeMSL;
     mGpsData.horizAccuracy = ggaData->m_dHDOP;
+    mGpsData.fixQuality = ggaData->m_nGPSQuality;
+
+    // GGA carries the number of satellites used in the solution
+    GpsSessionStats::getInstance()->onGgaEpoch(ggaData->m_nGPSQuality, ggaData->m_nSatsInView);
 
-    sendLocationUpdates();
+    sendLocationUpdates(true);
     sendNmeaUpdates(nmea_data);
 
     free(ggaData);
@@ -125,6 +135,8 @@ bool ParserNmea::SetGpsGSA_Data(CNMEAParserData::GSA_DATA_T* gsaData, char *nmea
     nyx_debug("    GPS dVDOP: %f\n", gsaData->dVDOP);
     nyx_debug("    GPS uGGACount: %u\n", gsaData->uGGACount);
 
+    GpsSessionStats::getInstance()->onGsaMode(gsaData->nMode);
+
     sendNmeaUpdates(nmea_data);
     free(gsaData);
     free(nmea_data);
@@ -157,7 +169,7 @@ bool ParserNmea::SetGpsRMC_Data(CNMEAParserData::RMC_DATA_T* rmcData, char *nmea
     mGpsData.speed = rmcData->m_dSpeedKnots*0.514;
     mGpsData.direction = rmcData->m_dTrackAngle;
 
-    sendLocationUpdates();
+    sendLocationUpdates(false);
     sendNmeaUpdates(nmea_data);
     free(rmcData);
     free(nmea_data);
@@ -170,10 +182,17 @@ void SetGpsStatus(int status)
     GpsStatus gps_status;
     memset(&gps_status, 0, sizeof(GpsStatus));
     gps_status.status = status;
+
+    if (status == NYX_GPS_STATUS_SESSION_BEGIN)
+        GpsSessionStats::getInstance()->beginSession();
+    else if (status == NYX_GPS_STATUS_SESSION_END)
+        GpsSessionStats::getInstance()->endSession();
+
     parser_status_cb(&gps_status, nullptr);
 }
 
 ParserNmea::ParserNmea()
+    : mFastDecode(false)
 {
     memset(&mGpsData, 0, sizeof(mGpsData));
 
@@ -189,11 +208,7 @@ CNMEAParserData::ERROR_E ParserNmea::ProcessRxCommand(char *pCmd, char *pData, c
     // Call base class to process the command
     CNMEAParser::ProcessRxCommand(pCmd, pData);
 
-    ParserThreadPool* parserThreadPoolObj = ParserHW::getInstance()->getThreadPoolObj();
-    if (ParserMock::getInstance()->isParserRequested())
-    {
-      parserThreadPoolObj = ParserMock::getInstance()->getThreadPoolObj();
-    }
+    ParserThreadPool* parserThreadPoolObj = getThreadPool();
 
     if(!parserThreadPoolObj)
         return CNMEAParserData::ERROR_OK;
@@ -275,6 +290,84 @@ CNMEAParserData::ERROR_E ParserNmea::ProcessRxCommand(char *pCmd, char *pData, c
     return CNMEAParserData::ERROR_OK;
 }
 
+ParserThreadPool *ParserNmea::getThreadPool() {
+    if (ParserMock::getInstance()->isParserRequested())
+        return ParserMock::getInstance()->getThreadPoolObj();
+    return ParserHW::getInstance()->getThreadPoolObj();
+}
+
+/*
+ * Entry point for received NMEA text. With the fast decoder enabled, each
+ * complete GPGGA/GPRMC line is decoded by NmeaFastDecoder and everything in
+ * between goes through CNMEAParser as before. Enabled with
+ * FAST_NMEA_DECODE=true in the GPSDEVICE group of gpsConfig.conf.
+ */
+CNMEAParserData::ERROR_E ParserNmea::processNmeaData(char *buffer, int len) {
+    CNMEAParserData::ERROR_E nErr = CNMEAParserData::ERROR_OK;
+    char *pending = buffer;
+    char *end = buffer + len;
+    char *line = buffer;
+
+    if (!mFastDecode)
+        return ProcessNMEABuffer(buffer, len);
+
+    while (line < end) {
+        char *lineEnd = (char *)memchr(line, '\n', end - line);
+        if (!lineEnd)
+            break;
+
+        NmeaFastSentence type = NmeaFastDecoder::classify(line, lineEnd + 1 - line);
+
+        if (type != NMEA_FAST_NONE) {
+            // The lines before it queue their callbacks first, keeping the order
+            if (line > pending && ProcessNMEABuffer(pending, line - pending) != CNMEAParserData::ERROR_OK)
+                nErr = CNMEAParserData::ERROR_FAIL;
+            queueFastSentence(type, line, lineEnd + 1 - line);
+            pending = lineEnd + 1;
+        }
+        line = lineEnd + 1;
+    }
+
+    if (pending < end && ProcessNMEABuffer(pending, end - pending) != CNMEAParserData::ERROR_OK)
+        nErr = CNMEAParserData::ERROR_FAIL;
+
+    return nErr;
+}
+
+void ParserNmea::queueFastSentence(int type, const char *sentence, size_t len) {
+    ParserThreadPool* parserThreadPoolObj = getThreadPool();
+    if (!parserThreadPoolObj)
+        return;
+
+    while (len && (sentence[len - 1] == '\n' || sentence[len - 1] == '\r'))
+        len--;
+
+    char *nmea_data = strndup(sentence, len);
+    if (!nmea_data)
+        return;
+
+    parserThreadPoolObj->enqueue([=](){
+        SetGpsFast_Data(type, nmea_data);
+    });
+}
+
+void ParserNmea::SetGpsFast_Data(int type, char *nmea_data) {
+    size_t len = strlen(nmea_data);
+    int satsUsed = 0;
+
+    if (type == NMEA_FAST_GGA && NmeaFastDecoder::decodeGGA(nmea_data, len, mGpsData, satsUsed)) {
+        GpsSessionStats::getInstance()->onGgaEpoch(mGpsData.fixQuality, satsUsed);
+        sendLocationUpdates(true);
+    } else if (type == NMEA_FAST_RMC && NmeaFastDecoder::decodeRMC(nmea_data, len, mGpsData)) {
+        sendLocationUpdates(false);
+    } else {
+        nyx_debug("MSGID_NMEA_PARSER: malformed %s", nmea_data);
+    }
+
+    sendNmeaUpdates(nmea_data);
+    free(nmea_data);
+}
+
 void ParserNmea::OnError(CNMEAParserData::ERROR_E nError, char *pCmd)
 {
 }
@@ -292,6 +385,12 @@ void ParserNmea::init() {
     mGpsData.horizAccuracy = -1;
 }
 
+// Called on the parser thread when a duty cycle wakes the receiver
+void ParserNmea::resetFix() {
+    mGpsData.fixQuality = 0;
+    mGpsData.horizAccuracy = -1;
+}
+
 void ParserNmea::deinit() {
     ResetData();
     memset(&mGpsData, 0, sizeof(mGpsData));
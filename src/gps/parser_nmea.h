@@ -27,6 +27,8 @@
 
 #include <nmeaparser/NMEAParser.h>
 
+class ParserThreadPool;
+
 typedef struct {
     //for getLocationUpdates
     int64_t timestamp; // in milli seconds
@@ -37,6 +39,7 @@ typedef struct {
     double speed; // in meters/seconds
     double horizAccuracy;
     double vertAccuracy;
+    int fixQuality; // GGA quality indicator, 0 = no fix
 } gps_data;
 
 class ParserNmea : public CNMEAParser {
@@ -48,21 +51,28 @@ public:
     bool stopParsing();
     ParserNmea();
     ~ParserNmea();
-
+    CNMEAParserData::ERROR_E processNmeaData(char *buffer, int len);
+    void setFastDecode(bool enable) { mFastDecode = enable; }
+    bool isFastDecode() const { return mFastDecode; }
+    void resetFix();
 
 private:
 
     gps_data mGpsData;
+    bool mFastDecode;
     virtual CNMEAParserData::ERROR_E ProcessRxCommand(char *pCmd, char *pData, char *checksum);
     virtual void OnError(CNMEAParserData::ERROR_E nError, char *pCmd);
+    ParserThreadPool *getThreadPool();
     void init();
     void deinit();
-    void sendLocationUpdates();
+    void sendLocationUpdates(bool gga);
     void sendNmeaUpdates(char *rawNmea);
     bool SetGpsRMC_Data(CNMEAParserData::RMC_DATA_T *rmcData, char *nmea_data);
     bool SetGpsGSA_Data(CNMEAParserData::GSA_DATA_T *gsaData, char *nmea_data);
     bool SetGpsGSV_Data(CNMEAParserData::GSV_DATA_T *gsvData, char *nmea_data);
     bool SetGpsGGA_Data(CNMEAParserData::GGA_DATA_T *ggaData, char *nmea_data);
+    void queueFastSentence(int type, const char *sentence, size_t len);
+    void SetGpsFast_Data(int type, char *nmea_data);
 };
 void SetGpsStatus(int status);
 
@@ -0,0 +1,269 @@
+/* @@@LICENSE
+ * *
+ * * Copyright (c) 2024 LG Electronics, Inc.
+ * *
+ * * Licensed under the Apache License, Version 2.0 (the "License");
+ * * you may not use this file except in compliance with the License.
+ * * You may obtain a copy of the License at
+ * *
+ * * http://www.apache.org/licenses/LICENSE-2.0
+ * *
+ * * Unless required by applicable law or agreed to in writing, software
+ * * distributed under the License is distributed on an "AS IS" BASIS,
+ * * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * * See the License for the specific language governing permissions and
+ * * limitations under the License.
+ * * SPDX-License-Identifier: Apache-2.0
+ * *
+ * * LICENSE@@@ */
+
+/*
+ * *******************************************************************/
+
+#include <cerrno>
+#include <cstring>
+#include <netdb.h>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/un.h>
+
+#include <nyx/module/nyx_log.h>
+#include "socket_input_source.h"
+
+constexpr char UNIX_PREFIX[] = "unix:";
+constexpr char TCP_PREFIX[] = "tcp:";
+
+SocketInputSource::SocketInputSource(const std::string &address)
+    : GpsInputSource(address)
+    , mAddrLen(0)
+    , mWanted(false)
+    , mConnectFd(INVALID_FD)
+    , mConnectChannel(nullptr)
+    , mConnectWatchId(0)
+    , mRetryTimerId(0)
+    , mBackoffMs(SOCKET_RECONNECT_MIN_MS)
+    , mReconnectCount(0)
+{
+    memset(&mAddr, 0, sizeof(mAddr));
+}
+
+SocketInputSource::~SocketInputSource()
+{
+    close();
+}
+
+bool SocketInputSource::isSocketAddress(const std::string &port)
+{
+    return port.compare(0, strlen(UNIX_PREFIX), UNIX_PREFIX) == 0 ||
+           port.compare(0, strlen(TCP_PREFIX), TCP_PREFIX) == 0;
+}
+
+bool SocketInputSource::resolveAddress()
+{
+    if (mName.compare(0, strlen(UNIX_PREFIX), UNIX_PREFIX) == 0)
+    {
+        std::string path = mName.substr(strlen(UNIX_PREFIX));
+        struct sockaddr_un *addr = (struct sockaddr_un *)&mAddr;
+
+        if (path.empty() || path.size() >= sizeof(addr->sun_path))
+            return false;
+
+        addr->sun_family = AF_UNIX;
+        strcpy(addr->sun_path, path.c_str());
+        mAddrLen = sizeof(struct sockaddr_un);
+        return true;
+    }
+
+    std::string hostPort = mName.substr(strlen(TCP_PREFIX));
+    size_t colon = hostPort.rfind(':');
+    if (colon == std::string::npos || colon == 0)
+        return false;
+
+    struct addrinfo hints, *result = nullptr;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags = AI_NUMERICSERV;
+
+    int ret = getaddrinfo(hostPort.substr(0, colon).c_str(), hostPort.substr(colon + 1).c_str(), &hints, &result);
+    if (ret != 0 || !result)
+    {
+        nyx_error("GPS_DEVICE", 0, "%s resolve failed: %s", mName.c_str(), gai_strerror(ret));
+        return false;
+    }
+
+    memcpy(&mAddr, result->ai_addr, result->ai_addrlen);
+    mAddrLen = result->ai_addrlen;
+    freeaddrinfo(result);
+    return true;
+}
+
+bool SocketInputSource::open()
+{
+    if (mWanted)
+        return true;
+
+    if (!resolveAddress())
+    {
+        nyx_error("GPS_DEVICE", 0, "%s invalid socket address", mName.c_str());
+        return false;
+    }
+
+    mWanted = true;
+    mBackoffMs = SOCKET_RECONNECT_MIN_MS;
+    connectSocket();
+    return true;
+}
+
+void SocketInputSource::close()
+{
+    mWanted = false;
+
+    if (mRetryTimerId)
+    {
+        g_source_remove(mRetryTimerId);
+        mRetryTimerId = 0;
+    }
+    cancelConnect();
+    GpsInputSource::close();
+}
+
+void SocketInputSource::connectSocket()
+{
+    int fd = socket(mAddr.ss_family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd == INVALID_FD)
+    {
+        nyx_error("GPS_DEVICE", 0, "%s socket failed: %s", mName.c_str(), strerror(errno));
+        scheduleReconnect();
+        return;
+    }
+
+    if (connect(fd, (struct sockaddr *)&mAddr, mAddrLen) == 0)
+    {
+        mConnectFd = fd;
+        connectDone(G_IO_OUT);
+        return;
+    }
+
+    if (errno != EINPROGRESS)
+    {
+        nyx_debug("GPS_DEVICE : %s connect failed: %s", mName.c_str(), strerror(errno));
+        ::close(fd);
+        scheduleReconnect();
+        return;
+    }
+
+    // Completion is signalled by writability
+    mConnectFd = fd;
+    mConnectChannel = g_io_channel_unix_new(fd);
+    GIOCondition watchCond = static_cast<GIOCondition>(G_IO_OUT | G_IO_HUP | G_IO_ERR);
+    mConnectWatchId = g_io_add_watch(mConnectChannel, watchCond, connectCallback, this);
+}
+
+void SocketInputSource::cancelConnect()
+{
+    if (mConnectWatchId)
+    {
+        g_source_remove(mConnectWatchId);
+        mConnectWatchId = 0;
+    }
+    if (mConnectChannel)
+    {
+        g_io_channel_unref(mConnectChannel);
+        mConnectChannel = nullptr;
+    }
+    if (mConnectFd != INVALID_FD)
+    {
+        ::close(mConnectFd);
+        mConnectFd = INVALID_FD;
+    }
+}
+
+gboolean SocketInputSource::connectCallback(GIOChannel *io, GIOCondition condition, gpointer user_data)
+{
+    SocketInputSource *ptr = (SocketInputSource *)user_data;
+    return ptr->connectDone(condition);
+}
+
+gboolean SocketInputSource::connectDone(GIOCondition condition)
+{
+    int err = 0;
+    socklen_t errLen = sizeof(err);
+    int fd = mConnectFd;
+
+    // Take the fd over before tearing down the connect watch
+    mConnectFd = INVALID_FD;
+    mConnectWatchId = 0;
+    if (mConnectChannel)
+    {
+        g_io_channel_unref(mConnectChannel);
+        mConnectChannel = nullptr;
+    }
+
+    if (getsockopt(fd, SOL_SOCKET, SO_ERROR, &err, &errLen) < 0 || err != 0)
+    {
+        nyx_debug("GPS_DEVICE : %s connect failed: %s", mName.c_str(), strerror(err ? err : errno));
+        ::close(fd);
+        scheduleReconnect();
+        return FALSE;
+    }
+
+    if (mAddr.ss_family != AF_UNIX)
+    {
+        int on = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+    }
+
+    nyx_info("GPS_DEVICE", 0, "%s connected", mName.c_str());
+    attach(fd);
+    return FALSE;
+}
+
+void SocketInputSource::scheduleReconnect()
+{
+    if (!mWanted || mRetryTimerId)
+        return;
+
+    mRetryTimerId = g_timeout_add(mBackoffMs, reconnectCallback, this);
+    mBackoffMs = MIN(mBackoffMs * 2, SOCKET_RECONNECT_MAX_MS);
+}
+
+gboolean SocketInputSource::reconnectCallback(gpointer user_data)
+{
+    SocketInputSource *ptr = (SocketInputSource *)user_data;
+    return ptr->reconnect();
+}
+
+gboolean SocketInputSource::reconnect()
+{
+    mRetryTimerId = 0;
+    mReconnectCount++;
+
+    if (mWanted && !isOpen())
+        connectSocket();
+
+    return FALSE;
+}
+
+void SocketInputSource::onDataReceived()
+{
+    // Only a peer that actually sends counts as healthy; accept-and-drop
+    // peers keep backing off
+    mBackoffMs = SOCKET_RECONNECT_MIN_MS;
+}
+
+void SocketInputSource::onDisconnected()
+{
+    nyx_info("GPS_DEVICE", 0, "%s disconnected, retrying in %u ms", mName.c_str(), mBackoffMs);
+    detach();
+    scheduleReconnect();
+}
+
+void SocketInputSource::discardPending()
+{
+    char buf[MAX_BUFFER_SIZE];
+
+    while (recv(mFd, buf, sizeof(buf), MSG_DONTWAIT) > 0)
+        ;
+}
@@ -0,0 +1,77 @@
+/* @@@LICENSE
+ * *
+ * * Copyright (c) 2024 LG Electronics, Inc.
+ * *
+ * * Licensed under the Apache License, Version 2.0 (the "License");
+ * * you may not use this file except in compliance with the License.
+ * * You may obtain a copy of the License at
+ * *
+ * * http://www.apache.org/licenses/LICENSE-2.0
+ * *
+ * * Unless required by applicable law or agreed to in writing, software
+ * * distributed under the License is distributed on an "AS IS" BASIS,
+ * * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * * See the License for the specific language governing permissions and
+ * * limitations under the License.
+ * * SPDX-License-Identifier: Apache-2.0
+ * *
+ * * LICENSE@@@ */
+
+/*
+ * *******************************************************************/
+
+#ifndef _SOCKET_INPUT_SOURCE_H_
+#define _SOCKET_INPUT_SOURCE_H_
+
+#include <sys/socket.h>
+#include "gps_input_source.h"
+
+constexpr unsigned int SOCKET_RECONNECT_MIN_MS = 250;
+constexpr unsigned int SOCKET_RECONNECT_MAX_MS = 30000;
+
+/*
+ * NMEA from a "unix:<path>" or "tcp:<host>:<port>" stream, e.g. a
+ * gpsd-style relay or a simulator. Connects without blocking and keeps
+ * reconnecting with exponential backoff for as long as it is open, so the
+ * peer may start late or restart under a running session.
+ */
+class SocketInputSource : public GpsInputSource
+{
+public:
+    explicit SocketInputSource(const std::string &address);
+    ~SocketInputSource();
+
+    static bool isSocketAddress(const std::string &port);
+
+    bool open() override;
+    void close() override;
+    bool isConnected() const { return isOpen(); }
+    unsigned int getReconnectCount() const { return mReconnectCount; }
+
+protected:
+    void discardPending() override;
+    void onDataReceived() override;
+    void onDisconnected() override;
+
+private:
+    bool resolveAddress();
+    void connectSocket();
+    void cancelConnect();
+    void scheduleReconnect();
+    gboolean connectDone(GIOCondition condition);
+    gboolean reconnect();
+    static gboolean connectCallback(GIOChannel *, GIOCondition, gpointer);
+    static gboolean reconnectCallback(gpointer);
+
+    struct sockaddr_storage mAddr;
+    socklen_t mAddrLen;
+    bool mWanted;
+    int mConnectFd;
+    GIOChannel *mConnectChannel;
+    guint mConnectWatchId;
+    guint mRetryTimerId;
+    unsigned int mBackoffMs;
+    unsigned int mReconnectCount;
+};
+
+#endif // _SOCKET_INPUT_SOURCE_H_
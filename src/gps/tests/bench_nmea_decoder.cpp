@@ -0,0 +1,240 @@
+// Copyright (c) 2024 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+//
+// Compares NmeaFastDecoder with the CNMEAParser path it replaces
+// (ProcessNMEABuffer, then GetGPGGA/GetGPRMC) on the same corpus.
+//
+//     bench_nmea_decoder [-n repeat] [log.nmea ...]
+//
+// Without a log a synthetic one hour GGA+RMC drive at 1 Hz is used. Both
+// paths decode every GGA/RMC sentence into gps_data; the report gives the
+// cost per sentence and the largest position difference between them.
+//
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "../nmea_fast_decoder.h"
+
+class LibraryPath : public CNMEAParser
+{
+public:
+	std::vector<gps_data> fixes;
+
+private:
+	CNMEAParserData::ERROR_E ProcessRxCommand(char *pCmd, char *pData, char *checksum) override
+	{
+		CNMEAParser::ProcessRxCommand(pCmd, pData);
+
+		gps_data data;
+		memset(&data, 0, sizeof(data));
+
+		if (strstr(pCmd, "GPGGA") != NULL)
+		{
+			CNMEAParserData::GGA_DATA_T gga;
+
+			if (GetGPGGA(gga) != CNMEAParserData::ERROR_OK)
+				return CNMEAParserData::ERROR_OK;
+
+			data.latitude = gga.m_dLatitude;
+			data.longitude = gga.m_dLongitude;
+			data.altitude = gga.m_dAltitudeMSL;
+			data.horizAccuracy = gga.m_dHDOP;
+			data.fixQuality = gga.m_nGPSQuality;
+			fixes.push_back(data);
+		}
+		else if (strstr(pCmd, "GPRMC") != NULL)
+		{
+			CNMEAParserData::RMC_DATA_T rmc;
+
+			if (GetGPRMC(rmc) != CNMEAParserData::ERROR_OK)
+				return CNMEAParserData::ERROR_OK;
+
+			data.latitude = rmc.m_dLatitude;
+			data.longitude = rmc.m_dLongitude;
+			data.speed = rmc.m_dSpeedKnots * 0.514;
+			data.direction = rmc.m_dTrackAngle;
+			fixes.push_back(data);
+		}
+
+		return CNMEAParserData::ERROR_OK;
+	}
+};
+
+static std::string checksummed(const char *body)
+{
+	unsigned char sum = 0;
+	char line[128];
+
+	for (const char *p = body; *p; p++)
+		sum ^= (unsigned char)*p;
+
+	snprintf(line, sizeof(line), "$%s*%02X\r\n", body, sum);
+	return line;
+}
+
+static void format_coordinate(char *out, size_t size, double degrees, bool latitude)
+{
+	double value = fabs(degrees);
+	int whole = (int)value;
+
+	snprintf(out, size, latitude ? "%02d%07.4f,%c" : "%03d%07.4f,%c", whole, (value - whole) * 60,
+	         latitude ? (degrees < 0 ? 'S' : 'N') : (degrees < 0 ? 'W' : 'E'));
+}
+
+static std::string make_drive(unsigned int seconds)
+{
+	std::string corpus;
+	double latitude = 37.5665, longitude = 126.978, heading = 45;
+
+	srand(1);
+
+	for (unsigned int t = 0; t < seconds; t++)
+	{
+		char lat[32], lon[32], body[128];
+		unsigned int hh = t / 3600 % 24, mm = t / 60 % 60, ss = t % 60;
+		double speed = 10 + (rand() % 1000) / 100.0;
+
+		heading = fmod(heading + (rand() % 200 - 100) / 50.0 + 360, 360);
+		latitude += speed * cos(heading * M_PI / 180) / 111320;
+		longitude += speed * sin(heading * M_PI / 180) / (111320 * cos(latitude * M_PI / 180));
+
+		format_coordinate(lat, sizeof(lat), latitude, true);
+		format_coordinate(lon, sizeof(lon), longitude, false);
+
+		snprintf(body, sizeof(body), "GPGGA,%02u%02u%02u.00,%s,%s,1,%02d,%.1f,%.1f,M,18.0,M,,",
+		         hh, mm, ss, lat, lon, 6 + rand() % 8, 0.6 + (rand() % 20) / 10.0, 30 + (rand() % 500) / 10.0);
+		corpus += checksummed(body);
+
+		snprintf(body, sizeof(body), "GPRMC,%02u%02u%02u.00,A,%s,%s,%.3f,%.2f,191024,,,A",
+		         hh, mm, ss, lat, lon, speed / 0.514, heading);
+		corpus += checksummed(body);
+	}
+
+	return corpus;
+}
+
+static std::vector<gps_data> run_fast(const std::string &corpus)
+{
+	std::vector<gps_data> fixes;
+	const char *line = corpus.data();
+	const char *end = line + corpus.size();
+
+	while (line < end)
+	{
+		const char *lineEnd = (const char *)memchr(line, '\n', end - line);
+		size_t len = (lineEnd ? lineEnd + 1 : end) - line;
+		gps_data data;
+		int sats;
+
+		memset(&data, 0, sizeof(data));
+
+		switch (NmeaFastDecoder::classify(line, len))
+		{
+		case NMEA_FAST_GGA:
+			if (NmeaFastDecoder::decodeGGA(line, len, data, sats))
+				fixes.push_back(data);
+			break;
+		case NMEA_FAST_RMC:
+			if (NmeaFastDecoder::decodeRMC(line, len, data))
+				fixes.push_back(data);
+			break;
+		default:
+			break;
+		}
+
+		line += len;
+	}
+
+	return fixes;
+}
+
+static std::vector<gps_data> run_library(std::string corpus)
+{
+	LibraryPath parser;
+
+	parser.ProcessNMEABuffer(&corpus[0], corpus.size());
+	return parser.fixes;
+}
+
+template <typename F>
+static double time_ns(F run, unsigned int repeat, size_t &count)
+{
+	auto begin = std::chrono::steady_clock::now();
+
+	for (unsigned int i = 0; i < repeat; i++)
+		count = run().size();
+
+	auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - begin).count();
+	return count ? (double)ns / repeat / count : 0;
+}
+
+static void report(const char *name, const std::string &corpus, unsigned int repeat)
+{
+	size_t libraryCount = 0, fastCount = 0;
+	double libraryNs = time_ns([&]() { return run_library(corpus); }, repeat, libraryCount);
+	double fastNs = time_ns([&]() { return run_fast(corpus); }, repeat, fastCount);
+	std::vector<gps_data> library = run_library(corpus), fast = run_fast(corpus);
+	double maxDiff = 0;
+
+	for (size_t i = 0; i < library.size() && i < fast.size(); i++)
+	{
+		maxDiff = std::max(maxDiff, fabs(library[i].latitude - fast[i].latitude));
+		maxDiff = std::max(maxDiff, fabs(library[i].longitude - fast[i].longitude));
+	}
+
+	printf("%s: %zu/%zu sentences, library %.0f ns/sentence, fast %.0f ns/sentence (%.1fx), "
+	       "max position difference %.2e deg\n",
+	       name, fastCount, libraryCount, libraryNs, fastNs, fastNs ? libraryNs / fastNs : 0, maxDiff);
+}
+
+int main(int argc, char **argv)
+{
+	unsigned int repeat = 20;
+	int i = 1;
+
+	if (argc > 2 && strcmp(argv[1], "-n") == 0)
+	{
+		repeat = std::max(atoi(argv[2]), 1);
+		i = 3;
+	}
+
+	if (i == argc)
+	{
+		report("synthetic", make_drive(3600), repeat);
+		return 0;
+	}
+
+	for (; i < argc; i++)
+	{
+		std::ifstream in(argv[i]);
+		std::stringstream corpus;
+
+		corpus << in.rdbuf();
+		report(argv[i], corpus.str(), repeat);
+	}
+
+	return 0;
+}
@@ -0,0 +1,137 @@
+// Copyright (c) 2024 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+//
+// Measures TrackSimplifier throughput and compression.
+//
+//     bench_track_simplifier [-t tolerance_m] [drive.nmea ...]
+//
+// Each NMEA log is read as one recorded drive, using the position of its
+// GGA sentences. Without a log a synthetic three hour drive is used.
+//
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+
+#include "track_test_util.h"
+
+static double nmea_to_degrees(const std::string &value, const std::string &hemisphere)
+{
+	double raw = atof(value.c_str());
+	double degrees = floor(raw / 100);
+	double result = degrees + (raw - degrees * 100) / 60;
+
+	return (hemisphere == "S" || hemisphere == "W") ? -result : result;
+}
+
+static std::vector<GpsLocation> load_nmea(const char *path)
+{
+	std::vector<GpsLocation> track;
+	std::ifstream in(path);
+	std::string line;
+
+	while (std::getline(in, line))
+	{
+		if (line.size() < 7 || line[0] != '$' || line.compare(3, 3, "GGA") != 0)
+			continue;
+
+		std::vector<std::string> fields;
+		size_t start = 0, end;
+
+		while ((end = line.find_first_of(",*", start)) != std::string::npos)
+		{
+			fields.push_back(line.substr(start, end - start));
+			start = end + 1;
+		}
+
+		// No fix
+		if (fields.size() < 7 || fields[6].empty() || fields[6] == "0" || fields[2].empty())
+			continue;
+
+		GpsLocation loc;
+		memset(&loc, 0, sizeof(loc));
+		loc.latitude = nmea_to_degrees(fields[2], fields[3]);
+		loc.longitude = nmea_to_degrees(fields[4], fields[5]);
+		loc.timestamp = 1700000000000LL + (int64_t)track.size() * 1000;
+		track.push_back(loc);
+	}
+
+	return track;
+}
+
+static void run(const char *name, const std::vector<GpsLocation> &track, double tolerance)
+{
+	std::vector<GpsLocation> out = simplify(track, tolerance);
+	size_t processed = 0;
+	auto begin = std::chrono::steady_clock::now();
+	double elapsed = 0;
+
+	if (track.empty())
+	{
+		printf("%-24s no fixes\n", name);
+		return;
+	}
+
+	// Repeat until timing is meaningful
+	while (elapsed < 1.0)
+	{
+		TrackSimplifier simplifier(tolerance);
+		GpsLocation kept;
+		size_t count = 0;
+
+		for (const GpsLocation &loc : track)
+			count += simplifier.add(loc, kept);
+		count += simplifier.flush(kept);
+
+		processed += track.size();
+		elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+		if (count != out.size())
+			abort();
+	}
+
+	printf("%-24s tol %5.1f m  %8zu -> %6zu fixes  ratio %6.1f:1  max dev %5.2f m  %10.0f fixes/s\n",
+	       name, tolerance, track.size(), out.size(), (double)track.size() / out.size(),
+	       max_deviation(track, out), processed / elapsed);
+}
+
+int main(int argc, char **argv)
+{
+	double tolerance = 5.0;
+	int first = 1;
+
+	if (argc > 2 && strcmp(argv[1], "-t") == 0)
+	{
+		tolerance = atof(argv[2]);
+		first = 3;
+	}
+
+	if (first >= argc)
+	{
+		run("synthetic 3h, 0 m noise", make_drive(3 * 3600, 0.0, 1), tolerance);
+		run("synthetic 3h, 1 m noise", make_drive(3 * 3600, 1.0, 1), tolerance);
+		run("synthetic 3h, 2 m noise", make_drive(3 * 3600, 2.0, 1), tolerance);
+		return 0;
+	}
+
+	for (int i = first; i < argc; i++)
+		run(argv[i], load_nmea(argv[i]), tolerance);
+
+	return 0;
+}
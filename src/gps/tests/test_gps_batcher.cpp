@@ -0,0 +1,235 @@
+// Copyright (c) 2024 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include <glib.h>
+#include <string.h>
+
+#include "../gps_batcher.h"
+
+static unsigned int batch_calls;
+static unsigned int batch_total;
+static double last_latitude;
+
+static void batch_cb(GpsLocation *locations, uint32_t count)
+{
+	uint32_t i;
+
+	for (i = 1; i < count; i++)
+	{
+		g_assert_cmpint(locations[i].timestamp, >, locations[i - 1].timestamp);
+	}
+
+	batch_calls++;
+	batch_total += count;
+	last_latitude = locations[count - 1].latitude;
+}
+
+static void make_location(GpsLocation *location, int i)
+{
+	memset(location, 0, sizeof(GpsLocation));
+	location->latitude = 37.5 + i * 1e-5;
+	location->longitude = 127.0 - i * 1e-5;
+	location->altitude = 35.25;
+	location->speed = 13.9f;
+	location->bearing = 271.5f;
+	location->accuracy = 4.2f;
+	location->timestamp = 1700000000000LL + i * 1000;
+}
+
+static void reset_counters(void)
+{
+	batch_calls = 0;
+	batch_total = 0;
+	last_latitude = 0;
+}
+
+static void test_gps_batcher_pack_roundtrip(void)
+{
+	GpsLocation in, out;
+	gps_batch_record_t record;
+
+	g_assert_cmpuint(sizeof(gps_batch_record_t), <=, 32);
+
+	make_location(&in, 123);
+	GpsBatcher::pack(&in, &record);
+	GpsBatcher::unpack(&record, &out);
+
+	g_assert_cmpfloat_with_epsilon(out.latitude, in.latitude, 1e-7);
+	g_assert_cmpfloat_with_epsilon(out.longitude, in.longitude, 1e-7);
+	g_assert_cmpfloat_with_epsilon(out.altitude, in.altitude, 0.01);
+	g_assert_cmpfloat_with_epsilon(out.speed, in.speed, 0.01);
+	g_assert_cmpfloat_with_epsilon(out.bearing, in.bearing, 0.01);
+	g_assert_cmpfloat_with_epsilon(out.accuracy, in.accuracy, 0.1);
+	g_assert_cmpint(out.timestamp, ==, in.timestamp);
+}
+
+static void test_gps_batcher_size_trigger(void)
+{
+	GpsBatcher *batcher = GpsBatcher::getInstance();
+	GpsLocation location;
+	int i;
+
+	reset_counters();
+	g_assert_true(batcher->configure(10, 0, batch_cb));
+
+	for (i = 0; i < 35; i++)
+	{
+		make_location(&location, i);
+		batcher->add(&location);
+	}
+
+	g_assert_cmpuint(batch_calls, ==, 3);
+	g_assert_cmpuint(batch_total, ==, 30);
+	g_assert_cmpuint(batcher->getPending(), ==, 5);
+
+	batcher->flush();
+	g_assert_cmpuint(batch_calls, ==, 4);
+	g_assert_cmpuint(batch_total, ==, 35);
+	g_assert_cmpfloat_with_epsilon(last_latitude, 37.5 + 34 * 1e-5, 1e-7);
+
+	batcher->disable();
+	g_assert_false(batcher->isActive());
+}
+
+static void test_gps_batcher_period_trigger(void)
+{
+	GpsBatcher *batcher = GpsBatcher::getInstance();
+	GpsLocation location;
+	int i;
+
+	reset_counters();
+	g_assert_true(batcher->configure(0, 50, batch_cb));
+
+	for (i = 0; i < 3 * (int)GPS_BATCH_MAX_SIZE; i++)
+	{
+		make_location(&location, i);
+		batcher->add(&location);
+	}
+
+	// Ring keeps only the newest fixes when nothing drains it
+	g_assert_cmpuint(batcher->getPending(), ==, GPS_BATCH_MAX_SIZE);
+	g_assert_cmpuint(batcher->getDropped(), ==, 2 * GPS_BATCH_MAX_SIZE);
+
+	gint64 deadline = g_get_monotonic_time() + 2 * G_USEC_PER_SEC;
+
+	while (batch_calls == 0 && g_get_monotonic_time() < deadline)
+	{
+		g_main_context_iteration(NULL, TRUE);
+	}
+
+	g_assert_cmpuint(batch_calls, ==, 1);
+	g_assert_cmpuint(batch_total, ==, GPS_BATCH_MAX_SIZE);
+	g_assert_cmpfloat_with_epsilon(last_latitude, 37.5 + (3 * GPS_BATCH_MAX_SIZE - 1) * 1e-5, 1e-7);
+
+	// Nothing queued, so the period timer must not keep firing
+	g_usleep(100 * 1000);
+	g_assert_false(g_main_context_iteration(NULL, FALSE));
+
+	batcher->disable();
+}
+
+static void test_gps_batcher_track_tolerance(void)
+{
+	GpsBatcher *batcher = GpsBatcher::getInstance();
+	GpsLocation location;
+	int i;
+
+	reset_counters();
+	batcher->setTrackTolerance(5.0);
+	g_assert_true(batcher->configure(GPS_BATCH_MAX_SIZE, 0, batch_cb));
+
+	// Straight line: only both ends survive
+	for (i = 0; i < 50; i++)
+	{
+		make_location(&location, i);
+		batcher->add(&location);
+	}
+
+	batcher->flush();
+	g_assert_cmpuint(batch_calls, ==, 1);
+	g_assert_cmpuint(batch_total, ==, 2);
+	g_assert_cmpfloat_with_epsilon(last_latitude, 37.5 + 49 * 1e-5, 1e-7);
+
+	batcher->disable();
+	batcher->setTrackTolerance(0);
+}
+
+static void reentrant_cb(GpsLocation *locations, uint32_t count)
+{
+	GpsBatcher *batcher = GpsBatcher::getInstance();
+	GpsLocation location;
+
+	batch_cb(locations, count);
+
+	if (batch_calls == 1)
+	{
+		// Queue more and reconfigure from inside the callback
+		make_location(&location, 10);
+		batcher->add(&location);
+		make_location(&location, 11);
+		batcher->add(&location);
+		g_assert_true(batcher->configure(4, 0, reentrant_cb));
+	}
+	else
+	{
+		batcher->disable();
+	}
+}
+
+static void test_gps_batcher_reentrant_callback(void)
+{
+	GpsBatcher *batcher = GpsBatcher::getInstance();
+	GpsLocation location;
+	int i;
+
+	reset_counters();
+	g_assert_true(batcher->configure(3, 0, reentrant_cb));
+
+	for (i = 0; i < 3; i++)
+	{
+		make_location(&location, i);
+		batcher->add(&location);
+	}
+
+	g_assert_cmpuint(batch_calls, ==, 2);
+	g_assert_cmpuint(batch_total, ==, 5);
+	g_assert_cmpfloat_with_epsilon(last_latitude, 37.5 + 11 * 1e-5, 1e-7);
+	g_assert_false(batcher->isActive());
+}
+
+static void test_gps_batcher_invalid_config(void)
+{
+	GpsBatcher *batcher = GpsBatcher::getInstance();
+
+	g_assert_false(batcher->configure(0, 0, batch_cb));
+	g_assert_false(batcher->configure(GPS_BATCH_MAX_SIZE + 1, 0, batch_cb));
+	g_assert_false(batcher->configure(10, 0, NULL));
+	g_assert_false(batcher->isActive());
+}
+
+int main(int argc, char **argv)
+{
+	g_test_init(&argc, &argv, NULL);
+
+	g_test_add_func("/gps/batcher/pack_roundtrip", test_gps_batcher_pack_roundtrip);
+	g_test_add_func("/gps/batcher/size_trigger", test_gps_batcher_size_trigger);
+	g_test_add_func("/gps/batcher/period_trigger", test_gps_batcher_period_trigger);
+	g_test_add_func("/gps/batcher/track_tolerance", test_gps_batcher_track_tolerance);
+	g_test_add_func("/gps/batcher/reentrant_callback", test_gps_batcher_reentrant_callback);
+	g_test_add_func("/gps/batcher/invalid_config", test_gps_batcher_invalid_config);
+
+	return g_test_run();
+}
@@ -0,0 +1,666 @@
+// Copyright (c) 2024 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+//
+// Virtual GNSS receiver: a generator drives the master side of a pty while
+// the GPS module reads the slave through gpsConfig.conf PORT, i.e. the real
+// tty, GLib watch, framing, NMEA parser and callback path.
+//
+// As a test it checks that every intact sentence arrives, in order, under
+// steady, bursty, chunked and noisy input. As a benchmark:
+//
+//     test_gps_device_pty bench <rate/s> <burst> <chunk> <noise> <seconds> [fast]
+//
+// prints throughput and end-to-end latency for one profile, "fast" with
+// FAST_NMEA_DECODE enabled. The sentence
+// number travels in the GGA time field, so latency is measured per sentence.
+//
+
+#include <glib.h>
+#include <pty.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../gps_device.h"
+#include "../parser_hw.h"
+#include "../parser_interface.h"
+
+typedef struct
+{
+	unsigned int rate;      // sentences per second
+	unsigned int burst;     // sentences per write burst
+	unsigned int chunk;     // max bytes per write(), 0 = whole burst at once
+	double noise;           // share of sentences corrupted, plus garbage between them
+	unsigned int count;     // sentences in total
+} generator_profile_t;
+
+typedef struct
+{
+	unsigned int delivered;
+	unsigned int corrupted;
+	bool in_order;
+	bool intact_lost;
+	double seconds;
+	double p50_ms;
+	double p99_ms;
+	double max_ms;
+} harness_result_t;
+
+static std::vector<std::atomic<gint64>> sent_at(1);
+static std::vector<gint64> latency_us;
+static std::vector<unsigned int> received_seq;
+static std::vector<std::string> received_types;
+static std::mutex received_lock;
+static std::atomic<bool> session_begun;
+static std::atomic<unsigned int> locations;
+static bool fast_decode;
+
+static unsigned int decode_seq(const char *nmea)
+{
+	unsigned int hh, mm, ss, cc;
+
+	if (sscanf(nmea, "$GPGGA,%2u%2u%2u.%2u,", &hh, &mm, &ss, &cc) != 4)
+		return UINT_MAX;
+
+	return ((hh * 3600 + mm * 60 + ss) * 100) + cc;
+}
+
+static std::string make_line(const char *body)
+{
+	char line[112];
+	unsigned char sum = 0;
+
+	for (const char *p = body; *p; p++)
+		sum ^= (unsigned char)*p;
+
+	snprintf(line, sizeof(line), "$%s*%02X\r\n", body, sum);
+	return line;
+}
+
+static std::string make_sentence(unsigned int seq)
+{
+	unsigned int cs = seq % 100, s = seq / 100;
+	char body[96];
+
+	snprintf(body, sizeof(body), "GPGGA,%02u%02u%02u.%02u,3733.9900,N,12658.6800,E,1,08,0.9,35.2,M,0.0,M,,",
+	         (s / 3600) % 24, (s / 60) % 60, s % 60, cs);
+
+	return make_line(body);
+}
+
+static void nmea_cb(GpsUtcTime timestamp, const char *nmea, int length)
+{
+	unsigned int seq = decode_seq(nmea);
+	gint64 now = g_get_monotonic_time();
+
+	received_lock.lock();
+	received_types.push_back(std::string(nmea, strcspn(nmea, ",")));
+	received_lock.unlock();
+
+	if (seq >= sent_at.size())
+		return;
+
+	received_lock.lock();
+	received_seq.push_back(seq);
+	latency_us.push_back(now - sent_at[seq].load());
+	received_lock.unlock();
+}
+
+static void status_cb(GpsStatus *status)
+{
+	if (status->status == NYX_GPS_STATUS_SESSION_BEGIN)
+		session_begun = true;
+}
+
+static void location_cb(GpsLocation *location)
+{
+	locations++;
+}
+
+static void write_all(int fd, const char *data, size_t len)
+{
+	while (len > 0)
+	{
+		ssize_t n = write(fd, data, len);
+
+		if (n < 0)
+			return;
+
+		data += n;
+		len -= n;
+	}
+}
+
+//
+// Writes the profile to the pty master; returns the sequence numbers that
+// were corrupted on purpose.
+//
+static std::vector<bool> run_generator(int master, const generator_profile_t *profile)
+{
+	std::mt19937 rng(42);
+	std::uniform_real_distribution<double> coin(0.0, 1.0);
+	std::vector<bool> corrupted(profile->count, false);
+	gint64 start = g_get_monotonic_time();
+	unsigned int seq = 0;
+
+	while (seq < profile->count)
+	{
+		std::string burst;
+		std::vector<std::pair<unsigned int, size_t>> ends;
+
+		for (unsigned int i = 0; i < profile->burst && seq < profile->count; i++, seq++)
+		{
+			std::string line = make_sentence(seq);
+
+			if (profile->noise > 0 && coin(rng) < profile->noise)
+			{
+				// Garbage between sentences, never a start or line end
+				burst.append(1 + rng() % 8, (char)('A' + rng() % 26));
+
+				// Flip one payload byte so the checksum fails
+				if (coin(rng) < 0.5)
+				{
+					size_t pos = 8 + rng() % (line.find('*') - 8);
+					line[pos] = line[pos] == 'Z' ? 'Y' : 'Z';
+					corrupted[seq] = true;
+				}
+			}
+
+			burst += line;
+			ends.push_back(std::make_pair(seq, burst.size()));
+		}
+
+		// Pace bursts so the average matches the requested sentence rate
+		gint64 due = start + (gint64)(seq - ends.size()) * G_USEC_PER_SEC / profile->rate;
+		gint64 now = g_get_monotonic_time();
+
+		if (due > now)
+			g_usleep(due - now);
+
+		size_t offset = 0, next_end = 0;
+
+		while (offset < burst.size())
+		{
+			size_t len = burst.size() - offset;
+
+			if (profile->chunk)
+				len = std::min<size_t>(len, 1 + rng() % profile->chunk);
+
+			// Time a sentence from the write that completes it, stamped
+			// before the write since the reader may beat us back here
+			now = g_get_monotonic_time();
+			while (next_end < ends.size() && ends[next_end].second <= offset + len)
+				sent_at[ends[next_end++].first] = now;
+
+			write_all(master, burst.data() + offset, len);
+			offset += len;
+
+			if (profile->chunk && offset < burst.size())
+				g_usleep(200);
+		}
+	}
+
+	return corrupted;
+}
+
+static bool run_harness(const generator_profile_t *profile, harness_result_t *result)
+{
+	static GpsCallbacks callbacks;
+	const GpsInterface *iface = get_gps_interface();
+	gchar *dir = g_dir_make_tmp("gps-pty-XXXXXX", NULL);
+	gchar *conf = g_build_filename(dir, "gpsConfig.conf", NULL);
+	int master, slave;
+	char slave_name[64];
+
+	if (openpty(&master, &slave, slave_name, NULL, NULL) < 0)
+		return false;
+
+	gchar *contents = g_strdup_printf("[GPSDEVICE]\nPORT=%s\nFAST_NMEA_DECODE=%s\n",
+	                                  slave_name, fast_decode ? "true" : "false");
+	g_file_set_contents(conf, contents, -1, NULL);
+	g_free(contents);
+
+	std::vector<std::atomic<gint64>>(profile->count).swap(sent_at);
+	received_seq.clear();
+	latency_us.clear();
+	session_begun = false;
+
+	memset(&callbacks, 0, sizeof(callbacks));
+	callbacks.size = sizeof(callbacks);
+	callbacks.location_cb = location_cb;
+	callbacks.status_cb = status_cb;
+	callbacks.nmea_cb = nmea_cb;
+
+	GPSDevice::getInstance()->setConfigFile(conf);
+	iface->init(&callbacks);
+	if (iface->start() != 0)
+		return false;
+
+	gint64 deadline = g_get_monotonic_time() + 5 * G_USEC_PER_SEC;
+
+	while (!session_begun && g_get_monotonic_time() < deadline)
+		g_main_context_iteration(NULL, FALSE);
+
+	if (!session_begun)
+		return false;
+
+	std::vector<bool> corrupted;
+	gint64 begin = g_get_monotonic_time();
+	std::thread generator([&]() { corrupted = run_generator(master, profile); });
+	unsigned int expected = profile->count;
+	bool done = false;
+
+	deadline = begin + ((gint64)profile->count * G_USEC_PER_SEC / profile->rate) + 10 * G_USEC_PER_SEC;
+
+	while (!done && g_get_monotonic_time() < deadline)
+	{
+		g_main_context_iteration(NULL, TRUE);
+
+		received_lock.lock();
+		done = received_seq.size() >= expected;
+		received_lock.unlock();
+
+		// Corrupted sentences never arrive; stop once the tail is in
+		if (!done && generator.joinable() && sent_at[profile->count - 1] != 0)
+		{
+			generator.join();
+			expected = profile->count - std::count(corrupted.begin(), corrupted.end(), true);
+		}
+	}
+
+	if (generator.joinable())
+		generator.join();
+
+	// Let the last sentences through the parser thread
+	g_usleep(100000);
+	received_lock.lock();
+
+	result->seconds = (g_get_monotonic_time() - begin) / 1e6;
+	result->delivered = received_seq.size();
+	result->corrupted = std::count(corrupted.begin(), corrupted.end(), true);
+	result->in_order = std::is_sorted(received_seq.begin(), received_seq.end());
+	result->intact_lost = false;
+
+	std::vector<bool> seen(profile->count, false);
+	for (unsigned int seq : received_seq)
+		seen[seq] = true;
+	for (unsigned int i = 0; i < profile->count; i++)
+		if (!seen[i] && !corrupted[i])
+			result->intact_lost = true;
+
+	std::sort(latency_us.begin(), latency_us.end());
+	if (!latency_us.empty())
+	{
+		result->p50_ms = latency_us[latency_us.size() / 2] / 1000.0;
+		result->p99_ms = latency_us[latency_us.size() * 99 / 100] / 1000.0;
+		result->max_ms = latency_us.back() / 1000.0;
+	}
+
+	received_lock.unlock();
+
+	iface->stop();
+	iface->cleanup();
+	close(master);
+	close(slave);
+	unlink(conf);
+	g_rmdir(dir);
+	g_free(conf);
+	g_free(dir);
+
+	return true;
+}
+
+static void print_result(const char *name, const generator_profile_t *profile, const harness_result_t *result)
+{
+	printf("%-10s rate %5u/s burst %3u chunk %3u noise %.2f: %u/%u delivered (%u corrupted), "
+	       "%.0f sentences/s, latency p50 %.2f ms p99 %.2f ms max %.2f ms\n",
+	       name, profile->rate, profile->burst, profile->chunk, profile->noise,
+	       result->delivered, profile->count, result->corrupted,
+	       result->delivered / result->seconds, result->p50_ms, result->p99_ms, result->max_ms);
+}
+
+static void check_profile(const char *name, generator_profile_t profile)
+{
+	harness_result_t result;
+
+	memset(&result, 0, sizeof(result));
+	g_assert_true(run_harness(&profile, &result));
+
+	if (g_test_verbose())
+		print_result(name, &profile, &result);
+
+	g_assert_true(result.in_order);
+	g_assert_false(result.intact_lost);
+	g_assert_cmpuint(result.delivered, ==, profile.count - result.corrupted);
+}
+
+static void test_gps_device_pty_steady(void)
+{
+	check_profile("steady", (generator_profile_t){ 50, 1, 0, 0.0, 200 });
+}
+
+static void test_gps_device_pty_burst(void)
+{
+	// Many sentences per read: every one of them has to come out
+	check_profile("burst", (generator_profile_t){ 500, 25, 0, 0.0, 1000 });
+}
+
+static void test_gps_device_pty_partial(void)
+{
+	// Sentences split across reads
+	check_profile("partial", (generator_profile_t){ 100, 4, 7, 0.0, 300 });
+}
+
+static void test_gps_device_pty_noise(void)
+{
+	check_profile("noise", (generator_profile_t){ 200, 5, 16, 0.2, 600 });
+}
+
+static void test_gps_device_pty_fast_decode(void)
+{
+	// Same input through NmeaFastDecoder instead of CNMEAParser
+	fast_decode = true;
+	check_profile("fast", (generator_profile_t){ 200, 5, 16, 0.2, 600 });
+	fast_decode = false;
+}
+
+static bool wait_for(std::function<bool()> cond, int timeout_ms)
+{
+	gint64 deadline = g_get_monotonic_time() + timeout_ms * 1000;
+
+	while (!cond() && g_get_monotonic_time() < deadline)
+		g_main_context_iteration(NULL, FALSE);
+
+	return cond();
+}
+
+static size_t received_count(void)
+{
+	std::lock_guard<std::mutex> lock(received_lock);
+	return received_seq.size();
+}
+
+static size_t received_type_count(void)
+{
+	std::lock_guard<std::mutex> lock(received_lock);
+	return received_types.size();
+}
+
+static void test_gps_device_pty_fast_order(void)
+{
+	static GpsCallbacks callbacks;
+	const GpsInterface *iface = get_gps_interface();
+	gchar *dir = g_dir_make_tmp("gps-pty-XXXXXX", NULL);
+	gchar *conf = g_build_filename(dir, "gpsConfig.conf", NULL);
+	const char *bodies[] =
+	{
+		"GPGSV,2,1,08,01,40,083,46,02,17,308,41,12,07,344,39,14,22,228,45",
+		"GPGSV,2,2,08,15,59,270,44,18,45,157,42,21,30,065,40,24,11,190,38",
+		"GPGSA,A,3,01,02,12,14,15,18,21,24,,,,,1.8,0.9,1.5",
+		"GPGGA,120000.00,3733.9900,N,12658.6800,E,1,08,0.9,35.2,M,0.0,M,,",
+		"GPGSA,A,3,01,02,12,14,15,18,21,24,,,,,1.8,0.9,1.5",
+		"GPRMC,120000.00,A,3733.9900,N,12658.6800,E,0.5,54.7,191024,,,A",
+		"GPGSV,1,1,01,01,40,083,46",
+		"GPGGA,120001.00,3733.9901,N,12658.6801,E,1,08,0.9,35.2,M,0.0,M,,",
+		"GPRMC,120001.00,A,3733.9901,N,12658.6801,E,0.5,54.7,191024,,,A",
+		"GPGSA,A,3,01,02,12,14,15,18,21,24,,,,,1.8,0.9,1.5",
+	};
+	std::vector<std::string> expected;
+	std::string burst;
+	int master, slave;
+	char slave_name[64];
+
+	g_assert_true(openpty(&master, &slave, slave_name, NULL, NULL) == 0);
+
+	gchar *contents = g_strdup_printf("[GPSDEVICE]\nPORT=%s\nFAST_NMEA_DECODE=true\n", slave_name);
+	g_file_set_contents(conf, contents, -1, NULL);
+	g_free(contents);
+
+	std::vector<std::atomic<gint64>>(1).swap(sent_at);
+	received_seq.clear();
+	received_types.clear();
+	latency_us.clear();
+	session_begun = false;
+
+	memset(&callbacks, 0, sizeof(callbacks));
+	callbacks.size = sizeof(callbacks);
+	callbacks.location_cb = location_cb;
+	callbacks.status_cb = status_cb;
+	callbacks.nmea_cb = nmea_cb;
+
+	GPSDevice::getInstance()->setConfigFile(conf);
+	iface->init(&callbacks);
+	g_assert_cmpint(iface->start(), ==, 0);
+	g_assert_true(wait_for([]() { return session_begun.load(); }, 5000));
+
+	// One read mixing fast decoded and library sentences: the callbacks
+	// have to come in the order the receiver sent them
+	for (const char *body : bodies)
+	{
+		burst += make_line(body);
+		expected.push_back(std::string("$") + std::string(body, strcspn(body, ",")));
+	}
+
+	write_all(master, burst.data(), burst.size());
+	g_assert_true(wait_for([&]() { return received_type_count() == expected.size(); }, 2000));
+
+	received_lock.lock();
+	g_assert_true(received_types == expected);
+	received_lock.unlock();
+
+	iface->stop();
+	iface->cleanup();
+
+	close(master);
+	close(slave);
+	unlink(conf);
+	g_rmdir(dir);
+	g_free(conf);
+	g_free(dir);
+}
+
+static void test_gps_device_pty_duty_cycle(void)
+{
+	static GpsCallbacks callbacks;
+	const GpsInterface *iface = get_gps_interface();
+	gchar *dir = g_dir_make_tmp("gps-pty-XXXXXX", NULL);
+	gchar *conf = g_build_filename(dir, "gpsConfig.conf", NULL);
+	int master, slave;
+	char slave_name[64];
+	std::string line;
+
+	g_assert_true(openpty(&master, &slave, slave_name, NULL, NULL) == 0);
+
+	gchar *contents = g_strdup_printf("[GPSDEVICE]\nPORT=%s\n", slave_name);
+	g_file_set_contents(conf, contents, -1, NULL);
+	g_free(contents);
+
+	std::vector<std::atomic<gint64>>(1).swap(sent_at);
+	received_seq.clear();
+	received_types.clear();
+	latency_us.clear();
+	session_begun = false;
+	locations = 0;
+
+	memset(&callbacks, 0, sizeof(callbacks));
+	callbacks.size = sizeof(callbacks);
+	callbacks.location_cb = location_cb;
+	callbacks.status_cb = status_cb;
+	callbacks.nmea_cb = nmea_cb;
+
+	GPSDevice::getInstance()->setConfigFile(conf);
+	iface->init(&callbacks);
+	g_assert_cmpint(iface->start(), ==, 0);
+	g_assert_true(wait_for([]() { return session_begun.load(); }, 5000));
+	g_assert_cmpint(iface->set_position_mode(0, 0, DUTY_CYCLE_MIN_INTERVAL_MS, 0, 0), ==, 0);
+
+	// A good fix ends the first cycle and suspends the input
+	line = make_sentence(0);
+	write_all(master, line.data(), line.size());
+	g_assert_true(wait_for([]() { return locations.load() == 1; }, 2000));
+	wait_for([]() { return false; }, 100);
+
+	// What the receiver sends while suspended is dropped, so keep sending
+	// until the wake-up reads it. Neither the RMC nor the GGA without a fix
+	// may pass for this cycle's fix on the strength of the last one.
+	line = make_line("GPRMC,120000.00,A,3733.9900,N,12658.6800,E,0.5,54.7,191024,,,A");
+	line += make_line("GPGGA,120010.00,,,,,0,00,99.9,,M,,M,,");
+	gint64 deadline = g_get_monotonic_time() + (DUTY_CYCLE_MIN_INTERVAL_MS + 5000) * 1000LL;
+
+	while (received_type_count() == 1 && g_get_monotonic_time() < deadline)
+	{
+		write_all(master, line.data(), line.size());
+		wait_for([]() { return received_type_count() > 1; }, 200);
+	}
+
+	g_assert_true(wait_for([]() { return received_type_count() >= 3; }, 2000));
+	wait_for([]() { return false; }, 100);
+	g_assert_cmpuint(locations.load(), ==, 1);
+
+	line = make_sentence(1);
+	write_all(master, line.data(), line.size());
+	g_assert_true(wait_for([]() { return locations.load() == 2; }, 2000));
+
+	iface->stop();
+	iface->cleanup();
+
+	close(master);
+	close(slave);
+	unlink(conf);
+	g_rmdir(dir);
+	g_free(conf);
+	g_free(dir);
+}
+
+static void test_gps_device_pty_warm_restart(void)
+{
+	static GpsCallbacks callbacks;
+	const GpsInterface *iface = get_gps_interface();
+	gchar *dir = g_dir_make_tmp("gps-pty-XXXXXX", NULL);
+	gchar *conf = g_build_filename(dir, "gpsConfig.conf", NULL);
+	int master, slave;
+	char slave_name[64];
+	std::string line;
+
+	g_assert_true(openpty(&master, &slave, slave_name, NULL, NULL) == 0);
+
+	gchar *contents = g_strdup_printf("[GPSDEVICE]\nPORT=%s\nSTANDBY_TIMEOUT=30\n", slave_name);
+	g_file_set_contents(conf, contents, -1, NULL);
+	g_free(contents);
+
+	std::vector<std::atomic<gint64>>(4).swap(sent_at);
+	received_seq.clear();
+	latency_us.clear();
+	session_begun = false;
+
+	memset(&callbacks, 0, sizeof(callbacks));
+	callbacks.size = sizeof(callbacks);
+	callbacks.location_cb = location_cb;
+	callbacks.status_cb = status_cb;
+	callbacks.nmea_cb = nmea_cb;
+
+	GPSDevice::getInstance()->setConfigFile(conf);
+	iface->init(&callbacks);
+	g_assert_cmpint(iface->start(), ==, 0);
+	g_assert_true(wait_for([]() { return session_begun.load(); }, 5000));
+
+	line = make_sentence(0);
+	write_all(master, line.data(), line.size());
+	g_assert_true(wait_for([]() { return received_count() == 1; }, 2000));
+
+	// Stopped but warm: the port stays open and the epoch is kept, not reported
+	iface->stop();
+	g_assert_true(GPSDevice::getInstance()->isInStandby());
+
+	line = make_sentence(1);
+	write_all(master, line.data(), line.size());
+	wait_for([]() { return false; }, 100);
+
+	// Short and garbled lines ending a read must not trip the GGA check
+	line = "$\r\n$GP\r\n$GPGG\n$";
+	write_all(master, line.data(), line.size());
+	line = "\n";
+	write_all(master, line.data(), line.size());
+	wait_for([]() { return false; }, 100);
+	g_assert_cmpuint(received_count(), ==, 1);
+	g_assert_true(GPSDevice::getInstance()->isInStandby());
+
+	// The kept epoch is reported on restart without anything new arriving
+	session_begun = false;
+	g_assert_cmpint(iface->start(), ==, 0);
+	g_assert_false(GPSDevice::getInstance()->isInStandby());
+	g_assert_true(wait_for([]() { return received_count() == 2; }, 2000));
+	g_assert_cmpuint(received_seq[1], ==, 1);
+
+	iface->stop();
+	iface->cleanup();
+	g_assert_false(GPSDevice::getInstance()->isInStandby());
+	g_assert_false(GPSDevice::getInstance()->isGpsDevAvail());
+
+	close(master);
+	close(slave);
+	unlink(conf);
+	g_rmdir(dir);
+	g_free(conf);
+	g_free(dir);
+}
+
+int main(int argc, char **argv)
+{
+	if ((argc == 7 || argc == 8) && strcmp(argv[1], "bench") == 0)
+	{
+		generator_profile_t profile;
+		harness_result_t result;
+
+		profile.rate = atoi(argv[2]);
+		profile.burst = MAX(atoi(argv[3]), 1);
+		profile.chunk = atoi(argv[4]);
+		profile.noise = atof(argv[5]);
+		profile.count = MAX(1, (unsigned int)(profile.rate * atof(argv[6])));
+		fast_decode = argc == 8 && strcmp(argv[7], "fast") == 0;
+
+		memset(&result, 0, sizeof(result));
+		if (!run_harness(&profile, &result))
+			return 1;
+
+		print_result("bench", &profile, &result);
+		return result.intact_lost ? 1 : 0;
+	}
+
+	g_test_init(&argc, &argv, NULL);
+
+	g_test_add_func("/gps/device_pty/steady", test_gps_device_pty_steady);
+	g_test_add_func("/gps/device_pty/burst", test_gps_device_pty_burst);
+	g_test_add_func("/gps/device_pty/partial", test_gps_device_pty_partial);
+	g_test_add_func("/gps/device_pty/noise", test_gps_device_pty_noise);
+	g_test_add_func("/gps/device_pty/fast_decode", test_gps_device_pty_fast_decode);
+	g_test_add_func("/gps/device_pty/fast_order", test_gps_device_pty_fast_order);
+	g_test_add_func("/gps/device_pty/duty_cycle", test_gps_device_pty_duty_cycle);
+	g_test_add_func("/gps/device_pty/warm_restart", test_gps_device_pty_warm_restart);
+
+	return g_test_run();
+}
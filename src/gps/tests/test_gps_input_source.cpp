@@ -0,0 +1,222 @@
+// Copyright (c) 2024 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include <glib.h>
+#include <poll.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include <string>
+
+#include "../socket_input_source.h"
+
+#define SENTENCE "$GPGGA,120000.00,3733.9900,N,12658.6800,E,1,08,0.9,35.2,M,0.0,M,,*6A\r\n"
+
+static std::string received;
+
+static void data_cb(const char *data, gsize len, gpointer user_data)
+{
+	received.append(data, len);
+}
+
+//
+// Runs the main loop until cond holds or the deadline passes.
+//
+template <typename Cond>
+static bool iterate_until(Cond cond, int timeout_ms)
+{
+	gint64 deadline = g_get_monotonic_time() + timeout_ms * 1000;
+
+	while (!cond() && g_get_monotonic_time() < deadline)
+	{
+		g_main_context_iteration(NULL, FALSE);
+		g_usleep(1000);
+	}
+
+	return cond();
+}
+
+static int accept_client(int listen_fd, int timeout_ms)
+{
+	int client = -1;
+
+	iterate_until([&]()
+	{
+		struct pollfd pfd = { listen_fd, POLLIN, 0 };
+
+		if (poll(&pfd, 1, 0) == 1)
+			client = accept(listen_fd, NULL, NULL);
+
+		return client >= 0;
+	}, timeout_ms);
+
+	return client;
+}
+
+static int listen_unix(const char *path)
+{
+	struct sockaddr_un addr;
+	int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	strcpy(addr.sun_path, path);
+	unlink(path);
+
+	g_assert_true(bind(fd, (struct sockaddr *)&addr, sizeof(addr)) == 0);
+	g_assert_true(listen(fd, 4) == 0);
+	return fd;
+}
+
+static int listen_tcp(int *port)
+{
+	struct sockaddr_in addr;
+	socklen_t len = sizeof(addr);
+	int fd = socket(AF_INET, SOCK_STREAM, 0);
+	int on = 1;
+
+	setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+	g_assert_true(bind(fd, (struct sockaddr *)&addr, sizeof(addr)) == 0);
+	g_assert_true(listen(fd, 4) == 0);
+	g_assert_true(getsockname(fd, (struct sockaddr *)&addr, &len) == 0);
+	*port = ntohs(addr.sin_port);
+	return fd;
+}
+
+//
+// Streams sentences, drops the connection from the server side and checks
+// that the source comes back on its own and keeps delivering.
+//
+static void check_stream_and_reconnect(const std::string &address, int listen_fd)
+{
+	SocketInputSource source(address);
+	const std::string sentence = SENTENCE;
+	int client;
+
+	received.clear();
+	source.setDataCallback(data_cb, NULL);
+	g_assert_true(source.open());
+
+	client = accept_client(listen_fd, 2000);
+	g_assert_cmpint(client, >=, 0);
+	g_assert_true(iterate_until([&]() { return source.isConnected(); }, 2000));
+
+	// Partial writes must come out as the same byte stream
+	g_assert_cmpint(write(client, sentence.data(), 10), ==, 10);
+	g_assert_cmpint(write(client, sentence.data() + 10, sentence.size() - 10), ==, (int)sentence.size() - 10);
+	g_assert_true(iterate_until([&]() { return received.size() >= sentence.size(); }, 2000));
+	g_assert_true(received == sentence);
+
+	close(client);
+	g_assert_true(iterate_until([&]() { return !source.isConnected(); }, 2000));
+
+	client = accept_client(listen_fd, 5000);
+	g_assert_cmpint(client, >=, 0);
+	g_assert_true(iterate_until([&]() { return source.isConnected(); }, 2000));
+	g_assert_cmpuint(source.getReconnectCount(), >=, 1);
+
+	received.clear();
+	g_assert_cmpint(write(client, sentence.data(), sentence.size()), ==, (int)sentence.size());
+	g_assert_true(iterate_until([&]() { return received.size() >= sentence.size(); }, 2000));
+	g_assert_true(received == sentence);
+
+	source.close();
+	close(client);
+}
+
+static void test_gps_input_source_unix(void)
+{
+	gchar *dir = g_dir_make_tmp("gps-input-XXXXXX", NULL);
+	gchar *path = g_build_filename(dir, "nmea.sock", NULL);
+	int listen_fd = listen_unix(path);
+
+	check_stream_and_reconnect(std::string("unix:") + path, listen_fd);
+
+	close(listen_fd);
+	unlink(path);
+	g_rmdir(dir);
+	g_free(path);
+	g_free(dir);
+}
+
+static void test_gps_input_source_tcp(void)
+{
+	int port = 0;
+	int listen_fd = listen_tcp(&port);
+
+	check_stream_and_reconnect("tcp:127.0.0.1:" + std::to_string(port), listen_fd);
+
+	close(listen_fd);
+}
+
+static void test_gps_input_source_late_peer(void)
+{
+	gchar *dir = g_dir_make_tmp("gps-input-XXXXXX", NULL);
+	gchar *path = g_build_filename(dir, "nmea.sock", NULL);
+	SocketInputSource source(std::string("unix:") + path);
+	int listen_fd, client;
+
+	// Nobody listens yet, the source has to keep retrying
+	g_assert_true(source.open());
+	g_assert_false(source.isConnected());
+	iterate_until([]() { return false; }, 300);
+
+	listen_fd = listen_unix(path);
+	client = accept_client(listen_fd, 5000);
+	g_assert_cmpint(client, >=, 0);
+	g_assert_true(iterate_until([&]() { return source.isConnected(); }, 2000));
+
+	source.close();
+	close(client);
+	close(listen_fd);
+	unlink(path);
+	g_rmdir(dir);
+	g_free(path);
+	g_free(dir);
+}
+
+static void test_gps_input_source_address(void)
+{
+	g_assert_true(SocketInputSource::isSocketAddress("unix:/run/nmea.sock"));
+	g_assert_true(SocketInputSource::isSocketAddress("tcp:localhost:2947"));
+	g_assert_false(SocketInputSource::isSocketAddress("/dev/ttyUSB0"));
+
+	SocketInputSource no_port("tcp:localhost");
+	g_assert_false(no_port.open());
+
+	SocketInputSource no_path("unix:");
+	g_assert_false(no_path.open());
+}
+
+int main(int argc, char **argv)
+{
+	g_test_init(&argc, &argv, NULL);
+
+	g_test_add_func("/gps/input_source/unix", test_gps_input_source_unix);
+	g_test_add_func("/gps/input_source/tcp", test_gps_input_source_tcp);
+	g_test_add_func("/gps/input_source/late_peer", test_gps_input_source_late_peer);
+	g_test_add_func("/gps/input_source/address", test_gps_input_source_address);
+
+	return g_test_run();
+}
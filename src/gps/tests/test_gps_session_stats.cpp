@@ -0,0 +1,164 @@
+// Copyright (c) 2024 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <string.h>
+
+#include "../gps_session_stats.h"
+
+#define MS(x)   ((gint64)(x) * 1000)
+
+static gchar *make_stats_file(gchar **dir)
+{
+	*dir = g_dir_make_tmp("gps-session-XXXXXX", NULL);
+	g_assert_nonnull(*dir);
+	return g_build_filename(*dir, "stats", NULL);
+}
+
+//
+// One session with a 1 Hz GGA stream: no fix for 4 s, 2D fix at 4 s,
+// 3D at 6 s, fix lost for 3 epochs, ended at 20 s.
+//
+static void run_session(GpsSessionStats *stats, gint64 base)
+{
+	int i;
+
+	stats->beginSession(base);
+
+	for (i = 1; i <= 19; i++)
+	{
+		bool fix = i >= 4 && (i < 10 || i > 12);
+
+		if (i == 6)
+		{
+			stats->onGsaMode(3, base + MS(i * 1000));
+		}
+
+		stats->onGgaEpoch(fix ? 1 : 0, fix ? 8 : 0, base + MS(i * 1000));
+	}
+
+	stats->endSession(base + MS(20000));
+}
+
+static void test_gps_session_stats_metrics(void)
+{
+	GpsSessionStats *stats = GpsSessionStats::getInstance();
+	nyx_gps_session_stats_t out[NYX_GPS_SESSION_STATS_MAX];
+	gchar *dir = NULL;
+	gchar *path = make_stats_file(&dir);
+
+	stats->load(path);
+	run_session(stats, MS(1000000));
+
+	g_assert_cmpuint(stats->query(out, NYX_GPS_SESSION_STATS_MAX), ==, 1);
+	g_assert_cmpuint(out[0].duration_ms, ==, 20000);
+	g_assert_cmpint(out[0].ttff_ms, ==, 4000);
+	g_assert_cmpint(out[0].ttf3d_ms, ==, 6000);
+	g_assert_cmpuint(out[0].total_epochs, ==, 19);
+	g_assert_cmpuint(out[0].fix_epochs, ==, 13);
+	g_assert_cmpfloat(out[0].avg_sats_used, ==, 8.0f);
+	g_assert_cmpfloat(out[0].availability, >, 68.4f);
+	g_assert_cmpfloat(out[0].availability, <, 68.5f);
+	g_assert_cmpuint(out[0].longest_gap_ms, ==, 4000);
+
+	// Epochs outside a session are not counted
+	stats->onGgaEpoch(1, 8, MS(2000000));
+	stats->endSession(MS(2000000));
+	g_assert_cmpuint(stats->query(out, NYX_GPS_SESSION_STATS_MAX), ==, 1);
+
+	g_unlink(path);
+	g_rmdir(dir);
+	g_free(path);
+	g_free(dir);
+}
+
+static void test_gps_session_stats_no_fix(void)
+{
+	GpsSessionStats *stats = GpsSessionStats::getInstance();
+	nyx_gps_session_stats_t out;
+	gchar *dir = NULL;
+	gchar *path = make_stats_file(&dir);
+
+	stats->load(path);
+	stats->beginSession(0);
+	stats->onGsaMode(1, MS(500));
+	stats->onGgaEpoch(0, 0, MS(1000));
+	stats->endSession(MS(2000));
+
+	g_assert_cmpuint(stats->query(&out, 1), ==, 1);
+	g_assert_cmpint(out.ttff_ms, ==, -1);
+	g_assert_cmpint(out.ttf3d_ms, ==, -1);
+	g_assert_cmpuint(out.fix_epochs, ==, 0);
+	g_assert_cmpfloat(out.availability, ==, 0.0f);
+	g_assert_cmpfloat(out.avg_sats_used, ==, 0.0f);
+
+	g_unlink(path);
+	g_rmdir(dir);
+	g_free(path);
+	g_free(dir);
+}
+
+static void test_gps_session_stats_persistent_ring(void)
+{
+	GpsSessionStats *stats = GpsSessionStats::getInstance();
+	nyx_gps_session_stats_t out[NYX_GPS_SESSION_STATS_MAX];
+	gchar *dir = NULL;
+	gchar *path = make_stats_file(&dir);
+	unsigned int i;
+
+	g_assert_false(stats->load(path));
+
+	// Session i lasts i seconds, so the ring order can be checked
+	for (i = 1; i <= NYX_GPS_SESSION_STATS_MAX + 3; i++)
+	{
+		stats->beginSession(0);
+		stats->endSession(MS(i * 1000));
+	}
+
+	// Reload from disk, as after a restart
+	g_assert_true(stats->load(path));
+	g_assert_cmpuint(stats->query(out, NYX_GPS_SESSION_STATS_MAX), ==, NYX_GPS_SESSION_STATS_MAX);
+
+	for (i = 0; i < NYX_GPS_SESSION_STATS_MAX; i++)
+	{
+		g_assert_cmpuint(out[i].duration_ms, ==, (NYX_GPS_SESSION_STATS_MAX + 3 - i) * 1000);
+	}
+
+	g_assert_cmpuint(stats->query(out, 2), ==, 2);
+	g_assert_cmpuint(out[1].duration_ms, ==, (NYX_GPS_SESSION_STATS_MAX + 2) * 1000);
+
+	// A file of some other format is ignored, not trusted
+	g_assert_true(g_file_set_contents(path, "garbage", -1, NULL));
+	g_assert_false(stats->load(path));
+	g_assert_cmpuint(stats->query(out, NYX_GPS_SESSION_STATS_MAX), ==, 0);
+
+	g_unlink(path);
+	g_rmdir(dir);
+	g_free(path);
+	g_free(dir);
+}
+
+int main(int argc, char **argv)
+{
+	g_test_init(&argc, &argv, NULL);
+
+	g_test_add_func("/gps/session_stats/metrics", test_gps_session_stats_metrics);
+	g_test_add_func("/gps/session_stats/no_fix", test_gps_session_stats_no_fix);
+	g_test_add_func("/gps/session_stats/persistent_ring", test_gps_session_stats_persistent_ring);
+
+	return g_test_run();
+}
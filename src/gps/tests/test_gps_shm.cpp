@@ -0,0 +1,280 @@
+// Copyright (c) 2024 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <stdio.h>
+#include <string.h>
+#include <signal.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include "../gps_shm_publisher.h"
+#include "../gps_shm_reader.h"
+
+#define READER_COUNT    4
+#define RECORD_COUNT    2000
+
+//
+// Body of each reader process. Returns the process exit code: 0 when the
+// last location was seen with every record in order and intact.
+//
+static int run_reader(const char *socket_path)
+{
+	gps_shm_reader_t *reader = gps_shm_reader_open(socket_path);
+	gps_shm_record_t rec;
+	uint64_t prev_index = 0;
+	double prev_latitude = -1;
+	bool first = true;
+
+	if (!reader)
+	{
+		return 1;
+	}
+
+	for (;;)
+	{
+		if (gps_shm_reader_wait(reader, 5000) <= 0)
+		{
+			return 2;
+		}
+
+		while (gps_shm_reader_next(reader, &rec) > 0)
+		{
+			if (!first && rec.index <= prev_index)
+			{
+				return 3;
+			}
+
+			first = false;
+			prev_index = rec.index;
+
+			if (rec.type == GPS_SHM_RECORD_LOCATION)
+			{
+				if (rec.u.location.longitude != -rec.u.location.latitude ||
+				        rec.u.location.latitude < prev_latitude)
+				{
+					return 4;
+				}
+
+				prev_latitude = rec.u.location.latitude;
+
+				if (rec.u.location.latitude == RECORD_COUNT - 1)
+				{
+					gps_shm_reader_close(reader);
+					return 0;
+				}
+			}
+			else if (rec.type == GPS_SHM_RECORD_SV_STATUS)
+			{
+				if (rec.u.sv_status.num_svs > 12 ||
+				        rec.u.sv_status.sv_list[0].prn != 1)
+				{
+					return 5;
+				}
+			}
+			else
+			{
+				return 6;
+			}
+		}
+	}
+}
+
+static void test_gps_shm_multiple_readers(void)
+{
+	GpsShmPublisher *publisher = GpsShmPublisher::getInstance();
+	gchar *dir = g_dir_make_tmp("gps-shm-XXXXXX", NULL);
+	gchar *socket_path = g_build_filename(dir, "shm.sock", NULL);
+	pid_t readers[READER_COUNT];
+	GpsLocation location;
+	GpsSvStatus sv_status;
+	int i;
+
+	g_assert_nonnull(dir);
+	g_assert_true(publisher->start(socket_path));
+
+	for (i = 0; i < READER_COUNT; i++)
+	{
+		readers[i] = fork();
+		g_assert_true(readers[i] >= 0);
+
+		if (readers[i] == 0)
+		{
+			// _exit: the child must not run the publisher destructor
+			_exit(run_reader(socket_path));
+		}
+	}
+
+	// Serve the fd handoff to every reader before publishing
+	gint64 deadline = g_get_monotonic_time() + 5 * G_USEC_PER_SEC;
+
+	while (publisher->getServedClients() < READER_COUNT &&
+	        g_get_monotonic_time() < deadline)
+	{
+		g_main_context_iteration(NULL, FALSE);
+		g_usleep(1000);
+	}
+
+	g_assert_cmpuint(publisher->getServedClients(), ==, READER_COUNT);
+
+	memset(&sv_status, 0, sizeof(sv_status));
+
+	for (i = 0; i < RECORD_COUNT; i++)
+	{
+		memset(&location, 0, sizeof(location));
+		location.latitude = i;
+		location.longitude = -i;
+		location.timestamp = g_get_real_time() / 1000;
+		publisher->publishLocation(&location);
+
+		if (i % 10 == 0)
+		{
+			sv_status.num_svs = i % 12 + 1;
+			sv_status.sv_list[0].prn = 1;
+			publisher->publishSvStatus(&sv_status);
+		}
+
+		g_usleep(100);
+	}
+
+	for (i = 0; i < READER_COUNT; i++)
+	{
+		int status = 0;
+
+		g_assert_true(waitpid(readers[i], &status, 0) == readers[i]);
+		g_assert_true(WIFEXITED(status));
+		g_assert_cmpint(WEXITSTATUS(status), ==, 0);
+	}
+
+	publisher->stop();
+	g_assert_false(publisher->isActive());
+	g_assert_false(g_file_test(socket_path, G_FILE_TEST_EXISTS));
+
+	g_rmdir(dir);
+	g_free(socket_path);
+	g_free(dir);
+}
+
+static void on_tick(int sig)
+{
+}
+
+static void test_gps_shm_reader_overrun(void)
+{
+	GpsShmPublisher *publisher = GpsShmPublisher::getInstance();
+	gchar *dir = g_dir_make_tmp("gps-shm-XXXXXX", NULL);
+	gchar *socket_path = g_build_filename(dir, "shm.sock", NULL);
+	gps_shm_reader_t *reader = NULL;
+	gps_shm_record_t rec;
+	GpsLocation location;
+	int i, count = 0;
+
+	g_assert_true(publisher->start(socket_path));
+
+	// The reader connects from this process, so the handoff has to be driven
+	// from a child that only runs the main loop
+	pid_t server = fork();
+
+	if (server == 0)
+	{
+		gint64 deadline = g_get_monotonic_time() + 2 * G_USEC_PER_SEC;
+
+		while (publisher->getServedClients() < 1 && g_get_monotonic_time() < deadline)
+		{
+			g_main_context_iteration(NULL, FALSE);
+			g_usleep(1000);
+		}
+
+		_exit(0);
+	}
+
+	reader = gps_shm_reader_open(socket_path);
+	g_assert_nonnull(reader);
+	waitpid(server, NULL, 0);
+
+	memset(&location, 0, sizeof(location));
+
+	for (i = 0; i < 3 * GPS_SHM_RING_SLOTS; i++)
+	{
+		location.latitude = i;
+		publisher->publishLocation(&location);
+	}
+
+	g_assert_cmpint(gps_shm_reader_wait(reader, 0), ==, 1);
+
+	while (gps_shm_reader_next(reader, &rec) > 0)
+	{
+		g_assert_cmpfloat(rec.u.location.latitude, ==, 2 * GPS_SHM_RING_SLOTS + count);
+		count++;
+	}
+
+	g_assert_cmpint(count, ==, GPS_SHM_RING_SLOTS);
+	g_assert_cmpuint(gps_shm_reader_lost(reader), ==, 2 * GPS_SHM_RING_SLOTS);
+	g_assert_cmpint(gps_shm_reader_wait(reader, 10), ==, 0);
+
+	// Signals landing during the wait must not cut the timeout short
+	struct sigaction sa;
+	struct itimerval tick = { { 0, 20000 }, { 0, 20000 } };
+	struct itimerval off = { { 0, 0 }, { 0, 0 } };
+
+	memset(&sa, 0, sizeof(sa));
+	sa.sa_handler = on_tick;
+	sigaction(SIGALRM, &sa, NULL);
+	setitimer(ITIMER_REAL, &tick, NULL);
+
+	gint64 start = g_get_monotonic_time();
+	g_assert_cmpint(gps_shm_reader_wait(reader, 200), ==, 0);
+	g_assert_cmpint(g_get_monotonic_time() - start, >=, 200 * 1000);
+
+	setitimer(ITIMER_REAL, &off, NULL);
+	signal(SIGALRM, SIG_DFL);
+
+	gps_shm_reader_close(reader);
+	publisher->stop();
+
+	g_rmdir(dir);
+	g_free(socket_path);
+	g_free(dir);
+}
+
+static void test_gps_shm_keeps_foreign_path(void)
+{
+	GpsShmPublisher *publisher = GpsShmPublisher::getInstance();
+	gchar *dir = g_dir_make_tmp("gps-shm-XXXXXX", NULL);
+	gchar *socket_path = g_build_filename(dir, "shm.sock", NULL);
+
+	g_assert_true(g_file_set_contents(socket_path, "keep", -1, NULL));
+	g_assert_false(publisher->start(socket_path));
+	g_assert_true(g_file_test(socket_path, G_FILE_TEST_IS_REGULAR));
+
+	g_remove(socket_path);
+	g_rmdir(dir);
+	g_free(socket_path);
+	g_free(dir);
+}
+
+int main(int argc, char **argv)
+{
+	g_test_init(&argc, &argv, NULL);
+
+	g_test_add_func("/gps/shm/multiple_readers", test_gps_shm_multiple_readers);
+	g_test_add_func("/gps/shm/reader_overrun", test_gps_shm_reader_overrun);
+	g_test_add_func("/gps/shm/keeps_foreign_path", test_gps_shm_keeps_foreign_path);
+
+	return g_test_run();
+}
@@ -0,0 +1,173 @@
+// Copyright (c) 2024 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include <glib.h>
+#include <string.h>
+
+#include "../nmea_fast_decoder.h"
+
+#define GGA_FIX     "$GPGGA,123519,4807.038,N,01131.000,E,1,08,0.9,545.4,M,46.9,M,,*47\r\n"
+#define GGA_SOUTH   "$GPGGA,002153.000,3342.6618,S,11751.3858,W,1,10,1.2,27.0,M,-34.2,M,,0000*43"
+#define GGA_NO_FIX  "$GPGGA,235947.000,,,,,0,00,,,M,,M,,*76\r\n"
+#define RMC_FIX     "$GPRMC,123519,A,4807.038,N,01131.000,E,022.4,084.4,230394,003.1,W*6A\r\n"
+
+static void test_nmea_fast_decoder_classify(void)
+{
+	g_assert_cmpint(NmeaFastDecoder::classify(GGA_FIX, strlen(GGA_FIX)), ==, NMEA_FAST_GGA);
+	g_assert_cmpint(NmeaFastDecoder::classify(GGA_SOUTH, strlen(GGA_SOUTH)), ==, NMEA_FAST_GGA);
+	g_assert_cmpint(NmeaFastDecoder::classify(RMC_FIX, strlen(RMC_FIX)), ==, NMEA_FAST_RMC);
+
+	// Left to the library: bad checksum, other talkers and sentences, noise
+	const char *others[] =
+	{
+		"$GPGGA,123519,4807.038,N,01131.000,E,1,08,0.9,545.4,M,46.9,M,,*48\r\n",
+		"$GNGGA,123519,4807.038,N,01131.000,E,1,08,0.9,545.4,M,46.9,M,,*59\r\n",
+		"$GPGSA,A,3,04,05,,09,12,,,24,,,,,2.5,1.3,2.1*39\r\n",
+		"xx$GPGGA,123519,4807.038,N,01131.000,E,1,08,0.9,545.4,M,46.9,M,,*47\r\n",
+		"$GPGGA,123519,4807.038,N,01131.000,E,1,08,0.9,545.4,M,46.9,M,,\r\n",
+		"$GPRMC*hh",
+	};
+
+	for (const char *s : others)
+	{
+		g_assert_cmpint(NmeaFastDecoder::classify(s, strlen(s)), ==, NMEA_FAST_NONE);
+	}
+}
+
+static void test_nmea_fast_decoder_gga(void)
+{
+	gps_data data;
+	int sats = 0;
+
+	memset(&data, 0, sizeof(data));
+	g_assert_true(NmeaFastDecoder::decodeGGA(GGA_FIX, strlen(GGA_FIX), data, sats));
+	g_assert_cmpfloat_with_epsilon(data.latitude, 48 + 7.038 / 60, 1e-9);
+	g_assert_cmpfloat_with_epsilon(data.longitude, 11 + 31.0 / 60, 1e-9);
+	g_assert_cmpfloat_with_epsilon(data.altitude, 545.4, 1e-9);
+	g_assert_cmpfloat_with_epsilon(data.horizAccuracy, 0.9, 1e-9);
+	g_assert_cmpint(data.fixQuality, ==, 1);
+	g_assert_cmpint(sats, ==, 8);
+
+	g_assert_true(NmeaFastDecoder::decodeGGA(GGA_SOUTH, strlen(GGA_SOUTH), data, sats));
+	g_assert_cmpfloat_with_epsilon(data.latitude, -(33 + 42.6618 / 60), 1e-9);
+	g_assert_cmpfloat_with_epsilon(data.longitude, -(117 + 51.3858 / 60), 1e-9);
+	g_assert_cmpint(sats, ==, 10);
+
+	// Empty fields read as 0, as through the library
+	g_assert_true(NmeaFastDecoder::decodeGGA(GGA_NO_FIX, strlen(GGA_NO_FIX), data, sats));
+	g_assert_cmpfloat(data.latitude, ==, 0.0);
+	g_assert_cmpfloat(data.altitude, ==, 0.0);
+	g_assert_cmpint(data.fixQuality, ==, 0);
+	g_assert_cmpint(sats, ==, 0);
+}
+
+static void test_nmea_fast_decoder_rmc(void)
+{
+	gps_data data;
+
+	memset(&data, 0, sizeof(data));
+	data.altitude = 12.5;
+	g_assert_true(NmeaFastDecoder::decodeRMC(RMC_FIX, strlen(RMC_FIX), data));
+	g_assert_cmpfloat_with_epsilon(data.latitude, 48 + 7.038 / 60, 1e-9);
+	g_assert_cmpfloat_with_epsilon(data.longitude, 11 + 31.0 / 60, 1e-9);
+	g_assert_cmpfloat_with_epsilon(data.speed, 22.4 * 0.514, 1e-9);
+	g_assert_cmpfloat_with_epsilon(data.direction, 84.4, 1e-9);
+
+	// RMC carries no altitude
+	g_assert_cmpfloat(data.altitude, ==, 12.5);
+}
+
+static void test_nmea_fast_decoder_malformed(void)
+{
+	const char *bad[] =
+	{
+		"$GPGGA,123519,4807.038,N,01131.000,E,1,08,0.9,5x5.4,M,46.9,M,,*00",
+		"$GPGGA,123519,4867.038,N,01131.000,E,1,08,0.9,545.4,M,46.9,M,,*00",
+		"$GPGGA,123519,4807.038,N,01131.000,E,one,08,0.9,545.4,M,46.9,M,,*00",
+		"$GPGGA,123519,-4807.038,N,01131.000,E,1,08,0.9,545.4,M,46.9,M,,*00",
+		"$GPGGA,123519,4807.038,N,01131.000,E,1*00",
+		"$GPGGA,123519,48070380000000000.038,N,01131.000,E,1,08,0.9,545.4,M,46.9,M,,*00",
+	};
+	gps_data data;
+	int sats = 0;
+
+	memset(&data, 0, sizeof(data));
+	data.latitude = 1.5;
+
+	for (const char *s : bad)
+	{
+		g_assert_false(NmeaFastDecoder::decodeGGA(s, strlen(s), data, sats));
+	}
+
+	// Nothing written on failure
+	g_assert_cmpfloat(data.latitude, ==, 1.5);
+	g_assert_cmpfloat(data.altitude, ==, 0.0);
+}
+
+static void test_nmea_fast_decoder_fixed(void)
+{
+	const char *s;
+	int64_t value = 0;
+
+	s = "12.3456";
+	g_assert_true(NmeaFastDecoder::parseFixed(s, s + strlen(s), 3, value));
+	g_assert_cmpint(value, ==, 12345);
+
+	s = "-34.2";
+	g_assert_true(NmeaFastDecoder::parseFixed(s, s + strlen(s), 3, value));
+	g_assert_cmpint(value, ==, -34200);
+
+	s = ".5";
+	g_assert_true(NmeaFastDecoder::parseFixed(s, s + strlen(s), 1, value));
+	g_assert_cmpint(value, ==, 5);
+
+	s = "7";
+	g_assert_true(NmeaFastDecoder::parseFixed(s, s + strlen(s), 2, value));
+	g_assert_cmpint(value, ==, 700);
+
+	s = "1.2.3";
+	g_assert_false(NmeaFastDecoder::parseFixed(s, s + strlen(s), 3, value));
+
+	s = "--1";
+	g_assert_false(NmeaFastDecoder::parseFixed(s, s + strlen(s), 3, value));
+
+	s = "1.-1";
+	g_assert_false(NmeaFastDecoder::parseFixed(s, s + strlen(s), 3, value));
+
+	// Largest integer part that still fits once scaled by 1e9
+	s = "999999999.5";
+	g_assert_true(NmeaFastDecoder::parseFixed(s, s + strlen(s), 9, value));
+	g_assert_cmpint(value, ==, 999999999500000000LL);
+
+	s = "9999999999.5";
+	g_assert_false(NmeaFastDecoder::parseFixed(s, s + strlen(s), 9, value));
+
+	s = "-12345678901234567890";
+	g_assert_false(NmeaFastDecoder::parseFixed(s, s + strlen(s), 0, value));
+}
+
+int main(int argc, char **argv)
+{
+	g_test_init(&argc, &argv, NULL);
+
+	g_test_add_func("/gps/nmea_fast_decoder/classify", test_nmea_fast_decoder_classify);
+	g_test_add_func("/gps/nmea_fast_decoder/gga", test_nmea_fast_decoder_gga);
+	g_test_add_func("/gps/nmea_fast_decoder/rmc", test_nmea_fast_decoder_rmc);
+	g_test_add_func("/gps/nmea_fast_decoder/malformed", test_nmea_fast_decoder_malformed);
+	g_test_add_func("/gps/nmea_fast_decoder/fixed", test_nmea_fast_decoder_fixed);
+
+	return g_test_run();
+}
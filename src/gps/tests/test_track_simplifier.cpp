@@ -0,0 +1,78 @@
+// Copyright (c) 2024 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include <glib.h>
+
+#include "track_test_util.h"
+
+static void test_track_simplifier_straight_line(void)
+{
+	std::vector<GpsLocation> in = make_drive(40, 0, 1);
+	std::vector<GpsLocation> out = simplify(in, 1.0);
+
+	// First drive segment is at least 30 s of straight road
+	g_assert_cmpuint(out.size(), ==, 2);
+	g_assert_cmpint(out.front().timestamp, ==, in.front().timestamp);
+	g_assert_cmpint(out.back().timestamp, ==, in.back().timestamp);
+}
+
+static void test_track_simplifier_within_tolerance(void)
+{
+	const double tolerances[] = { 2.0, 5.0, 10.0 };
+	std::vector<GpsLocation> in = make_drive(3600, 1.0, 7);
+
+	for (double tolerance : tolerances)
+	{
+		std::vector<GpsLocation> out = simplify(in, tolerance);
+
+		// Tolerances well above the position noise give an order of magnitude
+		if (tolerance >= 5.0)
+			g_assert_cmpuint(out.size(), <, in.size() / 10);
+		g_assert_cmpfloat(max_deviation(in, out), <=, tolerance + 1e-6);
+		g_assert_cmpint(out.back().timestamp, ==, in.back().timestamp);
+	}
+}
+
+static void test_track_simplifier_window_bound(void)
+{
+	std::vector<GpsLocation> in = make_drive(200, 0, 1);
+	std::vector<GpsLocation> out;
+	TrackSimplifier simplifier(1000.0, 16);
+	GpsLocation kept;
+
+	for (const GpsLocation &loc : in)
+	{
+		if (simplifier.add(loc, kept))
+			out.push_back(kept);
+	}
+
+	// A fix is released at least every window length, however loose the tolerance
+	for (size_t i = 1; i < out.size(); i++)
+	{
+		g_assert_cmpint(out[i].timestamp - out[i - 1].timestamp, <=, 16 * 1000);
+	}
+}
+
+int main(int argc, char **argv)
+{
+	g_test_init(&argc, &argv, NULL);
+
+	g_test_add_func("/gps/track_simplifier/straight_line", test_track_simplifier_straight_line);
+	g_test_add_func("/gps/track_simplifier/within_tolerance", test_track_simplifier_within_tolerance);
+	g_test_add_func("/gps/track_simplifier/window_bound", test_track_simplifier_window_bound);
+
+	return g_test_run();
+}
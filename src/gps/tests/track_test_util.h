@@ -0,0 +1,136 @@
+// Copyright (c) 2024 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#ifndef _TRACK_TEST_UTIL_H_
+#define _TRACK_TEST_UTIL_H_
+
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "../track_simplifier.h"
+
+//
+// Synthetic 1 Hz drive: straight roads, 90 degree junctions, roundabout
+// style curves and stops, with gaussian position noise on top of the true
+// path.
+//
+static std::vector<GpsLocation> make_drive(unsigned int seconds, double noise_m, unsigned int seed)
+{
+	std::vector<GpsLocation> track;
+	std::mt19937 rng(seed);
+	std::normal_distribution<double> noise(0.0, noise_m);
+	std::uniform_int_distribution<int> pick(0, 9);
+	double lat = 37.5665, lon = 126.9780;
+	double heading = 0, speed = 14, turn_rate = 0;
+	int segment_left = 0;
+
+	for (unsigned int t = 0; t < seconds; t++)
+	{
+		if (segment_left-- <= 0)
+		{
+			int kind = pick(rng);
+
+			segment_left = 30 + pick(rng) * 20;
+			turn_rate = 0;
+			speed = 8 + pick(rng) * 2;
+
+			if (kind < 2)
+				heading += kind ? 90 : -90;
+			else if (kind == 2)
+				turn_rate = 360.0 / segment_left;
+			else if (kind == 3)
+				speed = 0;
+		}
+
+		heading += turn_rate;
+
+		double rad = heading * M_PI / 180;
+		double dn = speed * cos(rad);
+		double de = speed * sin(rad);
+
+		lat += dn / 111195.0;
+		lon += de / (111195.0 * cos(lat * M_PI / 180));
+
+		GpsLocation loc;
+		memset(&loc, 0, sizeof(loc));
+		loc.latitude = lat + noise(rng) / 111195.0;
+		loc.longitude = lon + noise(rng) / (111195.0 * cos(lat * M_PI / 180));
+		loc.speed = speed;
+		loc.bearing = fmod(heading + 360, 360);
+		loc.timestamp = 1700000000000LL + t * 1000LL;
+		track.push_back(loc);
+	}
+
+	return track;
+}
+
+static std::vector<GpsLocation> simplify(const std::vector<GpsLocation> &in, double tolerance_m)
+{
+	std::vector<GpsLocation> out;
+	TrackSimplifier simplifier(tolerance_m);
+	GpsLocation kept;
+
+	for (const GpsLocation &loc : in)
+	{
+		if (simplifier.add(loc, kept))
+			out.push_back(kept);
+	}
+
+	if (simplifier.flush(kept))
+		out.push_back(kept);
+
+	return out;
+}
+
+//
+// Largest distance of any input fix from the simplified segment spanning it,
+// matched through the timestamps.
+//
+static double max_deviation(const std::vector<GpsLocation> &in, const std::vector<GpsLocation> &out)
+{
+	double worst = 0;
+	size_t seg = 0;
+
+	for (const GpsLocation &p : in)
+	{
+		while (seg + 1 < out.size() && out[seg + 1].timestamp < p.timestamp)
+			seg++;
+
+		if (seg + 1 >= out.size())
+			break;
+
+		const GpsLocation &a = out[seg];
+		const GpsLocation &b = out[seg + 1];
+		double kx = 6371008.8 * M_PI / 180 * cos(a.latitude * M_PI / 180);
+		double ky = 6371008.8 * M_PI / 180;
+		double ex = (b.longitude - a.longitude) * kx, ey = (b.latitude - a.latitude) * ky;
+		double px = (p.longitude - a.longitude) * kx, py = (p.latitude - a.latitude) * ky;
+		double len2 = ex * ex + ey * ey;
+		double t = len2 > 0 ? (px * ex + py * ey) / len2 : 0;
+
+		t = t < 0 ? 0 : (t > 1 ? 1 : t);
+
+		double d = hypot(px - t * ex, py - t * ey);
+		if (d > worst)
+			worst = d;
+	}
+
+	return worst;
+}
+
+#endif // _TRACK_TEST_UTIL_H_
@@ -0,0 +1,127 @@
+/* @@@LICENSE
+ * *
+ * * Copyright (c) 2024 LG Electronics, Inc.
+ * *
+ * * Licensed under the Apache License, Version 2.0 (the "License");
+ * * you may not use this file except in compliance with the License.
+ * * You may obtain a copy of the License at
+ * *
+ * * http://www.apache.org/licenses/LICENSE-2.0
+ * *
+ * * Unless required by applicable law or agreed to in writing, software
+ * * distributed under the License is distributed on an "AS IS" BASIS,
+ * * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * * See the License for the specific language governing permissions and
+ * * limitations under the License.
+ * * SPDX-License-Identifier: Apache-2.0
+ * *
+ * * LICENSE@@@ */
+
+/*
+ * *******************************************************************/
+
+#include <cmath>
+#include "track_simplifier.h"
+
+static constexpr double EARTH_RADIUS_METERS = 6371008.8;
+static constexpr double DEG_TO_RAD = M_PI / 180.0;
+
+TrackSimplifier::TrackSimplifier(double toleranceMeters, unsigned int maxWindow)
+    : mTolerance(toleranceMeters)
+    , mMaxWindow(maxWindow ? maxWindow : 1)
+    , mHaveAnchor(false)
+    , mHavePending(false)
+    , mAnchor{0, 0}
+{
+    mWindow.reserve(mMaxWindow);
+}
+
+void TrackSimplifier::reset()
+{
+    mHaveAnchor = false;
+    mHavePending = false;
+    mWindow.clear();
+}
+
+/*
+ * Checks the held-back fixes against the segment anchor -> end. Distances
+ * use an equirectangular projection around the anchor, which is well below
+ * a metre off over the few kilometres a window spans.
+ */
+bool TrackSimplifier::withinTolerance(const Point &end) const
+{
+    const double kx = EARTH_RADIUS_METERS * DEG_TO_RAD * cos(mAnchor.latitude * DEG_TO_RAD);
+    const double ky = EARTH_RADIUS_METERS * DEG_TO_RAD;
+    const double ex = (end.longitude - mAnchor.longitude) * kx;
+    const double ey = (end.latitude - mAnchor.latitude) * ky;
+    const double len2 = ex * ex + ey * ey;
+    const double tol2 = mTolerance * mTolerance;
+
+    for (const Point &p : mWindow)
+    {
+        double px = (p.longitude - mAnchor.longitude) * kx;
+        double py = (p.latitude - mAnchor.latitude) * ky;
+        double t = len2 > 0 ? (px * ex + py * ey) / len2 : 0;
+
+        // Distance to the segment, not the line, so back-tracks are kept
+        if (t < 0)
+            t = 0;
+        else if (t > 1)
+            t = 1;
+
+        double dx = px - t * ex;
+        double dy = py - t * ey;
+
+        if (dx * dx + dy * dy > tol2)
+            return false;
+    }
+
+    return true;
+}
+
+bool TrackSimplifier::add(const GpsLocation &location, GpsLocation &out)
+{
+    Point point = { location.latitude, location.longitude };
+
+    if (!mHaveAnchor)
+    {
+        mAnchor = point;
+        mHaveAnchor = true;
+        out = location;
+        return true;
+    }
+
+    if (!mHavePending)
+    {
+        mPending = location;
+        mHavePending = true;
+        return false;
+    }
+
+    // mPending joins the window; keep it only if the stretch can't be a line
+    mWindow.push_back({ mPending.latitude, mPending.longitude });
+
+    if (mWindow.size() < mMaxWindow && withinTolerance(point))
+    {
+        mPending = location;
+        return false;
+    }
+
+    out = mPending;
+    mAnchor = mWindow.back();
+    mWindow.clear();
+    mPending = location;
+    return true;
+}
+
+bool TrackSimplifier::flush(GpsLocation &out)
+{
+    if (!mHavePending)
+        return false;
+
+    out = mPending;
+    mAnchor = { mPending.latitude, mPending.longitude };
+    mWindow.clear();
+    mHavePending = false;
+    return true;
+}
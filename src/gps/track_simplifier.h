@@ -0,0 +1,70 @@
+/* @@@LICENSE
+ * *
+ * * Copyright (c) 2024 LG Electronics, Inc.
+ * *
+ * * Licensed under the Apache License, Version 2.0 (the "License");
+ * * you may not use this file except in compliance with the License.
+ * * You may obtain a copy of the License at
+ * *
+ * * http://www.apache.org/licenses/LICENSE-2.0
+ * *
+ * * Unless required by applicable law or agreed to in writing, software
+ * * distributed under the License is distributed on an "AS IS" BASIS,
+ * * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * * See the License for the specific language governing permissions and
+ * * limitations under the License.
+ * * SPDX-License-Identifier: Apache-2.0
+ * *
+ * * LICENSE@@@ */
+
+/*
+ * *******************************************************************/
+
+#ifndef _TRACK_SIMPLIFIER_H_
+#define _TRACK_SIMPLIFIER_H_
+
+#include <vector>
+#include "parser_interface.h"
+
+constexpr unsigned int TRACK_SIMPLIFIER_MAX_WINDOW = 64;
+
+/*
+ * Streaming track simplification, bounded-window Douglas-Peucker
+ * ("opening window"): fixes are held back while every one of them stays
+ * within toleranceMeters of the straight segment from the last kept fix to
+ * the newest one. Once that no longer holds, or the window is full, the
+ * previous fix is kept and becomes the new anchor. Every dropped fix is
+ * therefore within the tolerance of the simplified track.
+ *
+ * At most one fix is released per add(); flush() releases the last fix so
+ * the track ends where the input did.
+ */
+class TrackSimplifier
+{
+public:
+    explicit TrackSimplifier(double toleranceMeters = 0, unsigned int maxWindow = TRACK_SIMPLIFIER_MAX_WINDOW);
+    void setTolerance(double toleranceMeters) { mTolerance = toleranceMeters; }
+    double getTolerance() const { return mTolerance; }
+    bool add(const GpsLocation &location, GpsLocation &out);
+    bool flush(GpsLocation &out);
+    void reset();
+
+private:
+    struct Point
+    {
+        double latitude;
+        double longitude;
+    };
+
+    bool withinTolerance(const Point &end) const;
+
+    double mTolerance;
+    unsigned int mMaxWindow;
+    bool mHaveAnchor;
+    bool mHavePending;
+    Point mAnchor;
+    std::vector<Point> mWindow;
+    GpsLocation mPending;
+};
+
+#endif // _TRACK_SIMPLIFIER_H_
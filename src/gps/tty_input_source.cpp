@@ -0,0 +1,67 @@
+/* @@@LICENSE
+ * *
+ * * Copyright (c) 2024 LG Electronics, Inc.
+ * *
+ * * Licensed under the Apache License, Version 2.0 (the "License");
+ * * you may not use this file except in compliance with the License.
+ * * You may obtain a copy of the License at
+ * *
+ * * http://www.apache.org/licenses/LICENSE-2.0
+ * *
+ * * Unless required by applicable law or agreed to in writing, software
+ * * distributed under the License is distributed on an "AS IS" BASIS,
+ * * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * * See the License for the specific language governing permissions and
+ * * limitations under the License.
+ * * SPDX-License-Identifier: Apache-2.0
+ * *
+ * * LICENSE@@@ */
+
+/*
+ * *******************************************************************/
+
+#include <cstring>
+#include <fcntl.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include <nyx/module/nyx_log.h>
+#include "tty_input_source.h"
+
+TtyInputSource::TtyInputSource(const std::string &port)
+    : GpsInputSource(port)
+{
+}
+
+bool TtyInputSource::open()
+{
+    struct termios tty;
+    memset(&tty, 0, sizeof(termios));
+    int fd;
+
+    if ((fd = ::open(mName.c_str(), O_RDONLY | O_NOCTTY | O_NONBLOCK)) == -1)
+    {
+        nyx_error("GPS_DEVICE", 0, "%s Port Open failed", mName.c_str());
+        return false;
+    }
+
+    tty.c_iflag = 0;
+    tty.c_cflag |= CLOCAL | CREAD;
+    tcflush(fd, TCIOFLUSH);
+    tcsetattr(fd, TCSANOW, &tty);
+    tcflush(fd, TCIOFLUSH);
+    tcflush(fd, TCIOFLUSH);
+    cfsetospeed(&tty, B4800);
+    cfsetispeed(&tty, B4800);
+    cfmakeraw(&tty);
+    tcsetattr(fd, TCSANOW, &tty);
+    nyx_info("GPS_DEVICE", 0, "%s Port Open Success", mName.c_str());
+
+    attach(fd);
+    return true;
+}
+
+void TtyInputSource::discardPending()
+{
+    tcflush(mFd, TCIFLUSH);
+}
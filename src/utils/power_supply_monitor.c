@@ -0,0 +1,229 @@
+// Copyright (c) 2024 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+/**
+* @file power_supply_monitor.c
+*
+* @brief Shared udev monitor of the power_supply subsystem. The battery and
+* charger modules both listen here, so the kernel uevent reaches the process
+* through one socket and one GLib watch.
+*
+*/
+
+#include <string.h>
+#include <glib.h>
+#include <libudev.h>
+#include <nyx/module/nyx_log.h>
+#include "msgid.h"
+#include "power_supply_monitor.h"
+
+typedef struct
+{
+	power_supply_listener_t func;
+	void *data;
+} power_supply_listener_entry_t;
+
+static struct udev *udev = NULL;
+static struct udev_monitor *mon = NULL;
+static guint watch = 0;
+static GSList *listeners = NULL;
+
+static void power_supply_monitor_dispatch(const power_supply_event_t *event)
+{
+	GSList *copy = g_slist_copy(listeners);
+	GSList *item;
+
+	// A listener may remove itself, or another one, while being called
+	for (item = copy; item; item = item->next)
+	{
+		if (g_slist_find(listeners, item->data))
+		{
+			power_supply_listener_entry_t *entry = item->data;
+			entry->func(event, entry->data);
+		}
+	}
+
+	g_slist_free(copy);
+}
+
+static gboolean power_supply_monitor_handle_event(GIOChannel *channel,
+        GIOCondition condition, gpointer data)
+{
+	power_supply_event_t event;
+
+	if ((condition & G_IO_IN) != G_IO_IN)
+	{
+		return TRUE;
+	}
+
+	memset(&event, 0, sizeof(event));
+	event.dev = udev_monitor_receive_device(mon);
+
+	if (event.dev)
+	{
+		event.action = udev_device_get_action(event.dev);
+		event.sysname = udev_device_get_sysname(event.dev);
+		event.index_changed = power_supply_index_update(event.dev);
+		event.has_values = power_supply_read_device(event.dev, &event.values) == 0;
+	}
+
+	power_supply_monitor_dispatch(&event);
+
+	if (event.dev)
+	{
+		udev_device_unref(event.dev);
+	}
+
+	return TRUE;
+}
+
+static void power_supply_monitor_close(void)
+{
+	// The watch holds the last ref of the channel; the fd belongs to mon
+	if (0 != watch)
+	{
+		g_source_remove(watch);
+		watch = 0;
+	}
+
+	if (NULL != mon)
+	{
+		udev_monitor_unref(mon);
+		mon = NULL;
+	}
+
+	if (NULL != udev)
+	{
+		udev_unref(udev);
+		udev = NULL;
+	}
+
+	power_supply_index_clear();
+}
+
+static int power_supply_monitor_open(void)
+{
+	GIOChannel *channel;
+	int fd;
+
+	udev = udev_new();
+
+	if (!udev)
+	{
+		nyx_error(MSGID_NYX_MOD_UDEV_ERR, 0,
+		          "Could not initialize udev component; power supply updates will not be available");
+		return -1;
+	}
+
+	mon = udev_monitor_new_from_netlink(udev, "kernel");
+
+	if (mon == NULL)
+	{
+		nyx_error(MSGID_NYX_MOD_UDEV_MONITOR_ERR, 0,
+		          "Failed to create udev monitor for kernel events");
+		power_supply_monitor_close();
+		return -1;
+	}
+
+	if (udev_monitor_filter_add_match_subsystem_devtype(mon, "power_supply", NULL) < 0)
+	{
+		nyx_error(MSGID_NYX_MOD_UDEV_SUBSYSTEM_ERR, 0,
+		          "Failed to setup udev filter for power_supply subsytem events");
+		power_supply_monitor_close();
+		return -1;
+	}
+
+	if (udev_monitor_enable_receiving(mon) < 0)
+	{
+		nyx_error(MSGID_NYX_MOD_UDEV_RECV_ERR, 0,
+		          "Failed to enable receiving kernel events for power_supply subsytem");
+		power_supply_monitor_close();
+		return -1;
+	}
+
+	fd = udev_monitor_get_fd(mon);
+	channel = (fd < 0) ? NULL : g_io_channel_unix_new(fd);
+
+	if (!channel)
+	{
+		power_supply_monitor_close();
+		return -1;
+	}
+
+	watch = g_io_add_watch(channel, G_IO_IN | G_IO_HUP | G_IO_NVAL,
+	                       power_supply_monitor_handle_event, NULL);
+	g_io_channel_unref(channel);
+
+	if (0 == watch)
+	{
+		power_supply_monitor_close();
+		return -1;
+	}
+
+	// Index the supplies before the first event can change them
+	power_supply_path_by_name(NULL);
+	return 0;
+}
+
+/**
+ * Register a listener; the first one opens the monitor. Returns -1 if the
+ * monitor could not be opened.
+ */
+int power_supply_monitor_add_listener(power_supply_listener_t listener, void *data)
+{
+	power_supply_listener_entry_t *entry;
+
+	if (!listener)
+	{
+		return -1;
+	}
+
+	if (!listeners && power_supply_monitor_open() < 0)
+	{
+		return -1;
+	}
+
+	entry = g_new0(power_supply_listener_entry_t, 1);
+	entry->func = listener;
+	entry->data = data;
+	listeners = g_slist_append(listeners, entry);
+	return 0;
+}
+
+/**
+ * Unregister a listener; the last one closes the monitor.
+ */
+void power_supply_monitor_remove_listener(power_supply_listener_t listener, void *data)
+{
+	GSList *item;
+
+	for (item = listeners; item; item = item->next)
+	{
+		power_supply_listener_entry_t *entry = item->data;
+
+		if (entry->func == listener && entry->data == data)
+		{
+			listeners = g_slist_delete_link(listeners, item);
+			g_free(entry);
+			break;
+		}
+	}
+
+	if (!listeners)
+	{
+		power_supply_monitor_close();
+	}
+}
@@ -0,0 +1,51 @@
+// Copyright (c) 2024 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+/**
+* @file power_supply_monitor.h
+*
+* @brief One udev monitor of the power_supply subsystem per process. Each
+* uevent is received and decoded once and handed to every listener.
+*
+*/
+
+#ifndef POWER_SUPPLY_MONITOR_H_
+#define POWER_SUPPLY_MONITOR_H_
+
+#include "utils.h"
+
+/**
+ * A decoded power_supply uevent. dev is only valid during the callback, and
+ * is NULL when receiving failed.
+ */
+typedef struct
+{
+	struct udev_device *dev;
+	const char *action;
+	const char *sysname;
+	/* the event added or removed a supply in the power_supply index */
+	bool index_changed;
+	/* values holds what the event carried */
+	bool has_values;
+	power_supply_uevent_t values;
+} power_supply_event_t;
+
+typedef void (*power_supply_listener_t)(const power_supply_event_t *event, void *data);
+
+int power_supply_monitor_add_listener(power_supply_listener_t listener, void *data);
+void power_supply_monitor_remove_listener(power_supply_listener_t listener, void *data);
+
+#endif // POWER_SUPPLY_MONITOR_H_
@@ -0,0 +1,290 @@
+// Copyright (c) 2024 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+
+/**
+ * @file bench_power_supply.c
+ *
+ * The syscalls are counted by wrapping the libc entry points of the
+ * benchmark binary (link it with -rdynamic -ldl so that libraries see the
+ * wrappers too), and cross-checked with the syscr counter of /proc/self/io,
+ * which also sees reads that do not go through these entry points.
+ */
+
+#include <dlfcn.h>
+#include <fcntl.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <glib/gstdio.h>
+
+#include "bench_power_supply.h"
+
+static uint64_t count_open, count_read, count_close;
+
+#define REAL(name) \
+	static __typeof__(name) *real_##name; \
+	if (!real_##name) real_##name = (__typeof__(name) *) dlsym(RTLD_NEXT, #name)
+
+int open(const char *path, int flags, ...)
+{
+	mode_t mode = 0;
+	va_list ap;
+	REAL(open);
+
+	if (flags & O_CREAT)
+	{
+		va_start(ap, flags);
+		mode = va_arg(ap, mode_t);
+		va_end(ap);
+	}
+
+	count_open++;
+	return real_open(path, flags, mode);
+}
+
+int openat(int dirfd, const char *path, int flags, ...)
+{
+	mode_t mode = 0;
+	va_list ap;
+	REAL(openat);
+
+	if (flags & O_CREAT)
+	{
+		va_start(ap, flags);
+		mode = va_arg(ap, mode_t);
+		va_end(ap);
+	}
+
+	count_open++;
+	return real_openat(dirfd, path, flags, mode);
+}
+
+ssize_t read(int fd, void *buf, size_t count)
+{
+	REAL(read);
+
+	count_read++;
+	return real_read(fd, buf, count);
+}
+
+ssize_t pread(int fd, void *buf, size_t count, off_t offset)
+{
+	REAL(pread);
+
+	count_read++;
+	return real_pread(fd, buf, count, offset);
+}
+
+int close(int fd)
+{
+	REAL(close);
+
+	count_close++;
+	return real_close(fd);
+}
+
+static uint64_t proc_self_syscr(void)
+{
+	unsigned long long syscr = 0;
+	char line[128];
+	FILE *file = fopen("/proc/self/io", "r");
+
+	if (!file)
+	{
+		return 0;
+	}
+
+	while (fgets(line, sizeof(line), file))
+	{
+		if (sscanf(line, "syscr: %llu", &syscr) == 1)
+		{
+			break;
+		}
+	}
+
+	fclose(file);
+	return syscr;
+}
+
+void bench_counters_get(bench_counters_t *counters)
+{
+	counters->syscr = proc_self_syscr();
+	counters->open = count_open;
+	counters->read = count_read;
+	counters->close = count_close;
+	counters->time = g_get_monotonic_time();
+}
+
+void bench_counters_report(const char *name, int iterations,
+                           const bench_counters_t *start, const bench_counters_t *end)
+{
+	double n = iterations > 0 ? iterations : 1;
+
+	printf("  %-32s %8.2f us  %6.2f open  %6.2f read  %6.2f close  %6.2f syscr\n",
+	       name, (end->time - start->time) / n,
+	       (end->open - start->open) / n, (end->read - start->read) / n,
+	       (end->close - start->close) / n, (end->syscr - start->syscr) / n);
+}
+
+static void write_file(const char *dir, const char *name, const char *contents)
+{
+	gchar *path = g_build_filename(dir, name, NULL);
+
+	g_file_set_contents(path, contents, -1, NULL);
+	g_free(path);
+}
+
+static const char *battery_attributes[][2] =
+{
+	{ "type", "Battery" }, { "present", "1" }, { "status", "Discharging" },
+	{ "capacity", "64" }, { "voltage_now", "3950000" }, { "current_now", "-250000" },
+	{ "temp", "312" }, { "charge_now", "1500000" }, { "charge_full", "2800000" },
+	{ "charge_full_design", "3000000" },
+};
+
+static const char *usb_attributes[][2] =
+{
+	{ "type", "USB" }, { "online", "0" }, { "current_max", "500000" },
+	{ "voltage_max", "5000000" }, { "usb_type", "Unknown [SDP] DCP CDP" },
+};
+
+static const char *ac_attributes[][2] = { { "type", "Mains" }, { "online", "0" } };
+
+static void write_uevent(const char *class_dir, const char *supply)
+{
+	gchar *dir = g_build_filename(class_dir, supply, NULL);
+	GString *uevent = g_string_new(NULL);
+	GDir *entries = g_dir_open(dir, 0, NULL);
+	const char *name;
+
+	g_string_append_printf(uevent, "POWER_SUPPLY_NAME=%s\n", supply);
+
+	while (entries && (name = g_dir_read_name(entries)))
+	{
+		gchar *path, *contents = NULL, *key;
+
+		if (strcmp(name, "uevent") == 0 || strcmp(name, "type") == 0)
+		{
+			continue;
+		}
+
+		path = g_build_filename(dir, name, NULL);
+		key = g_ascii_strup(name, -1);
+
+		if (g_file_get_contents(path, &contents, NULL, NULL))
+		{
+			g_string_append_printf(uevent, "POWER_SUPPLY_%s=%s\n", key, g_strstrip(contents));
+		}
+
+		g_free(contents);
+		g_free(key);
+		g_free(path);
+	}
+
+	if (entries)
+	{
+		g_dir_close(entries);
+	}
+
+	write_file(dir, "uevent", uevent->str);
+	g_string_free(uevent, TRUE);
+	g_free(dir);
+}
+
+static void create_supply(const char *class_dir, const char *supply,
+                          const char *attributes[][2], int count)
+{
+	gchar *dir = g_build_filename(class_dir, supply, NULL);
+	int i;
+
+	g_mkdir_with_parents(dir, 0755);
+
+	for (i = 0; i < count; i++)
+	{
+		gchar *value = g_strconcat(attributes[i][1], "\n", NULL);
+
+		write_file(dir, attributes[i][0], value);
+		g_free(value);
+	}
+
+	write_uevent(class_dir, supply);
+	g_free(dir);
+}
+
+gchar *bench_power_supply_create(const char *parent)
+{
+	gchar *template = g_build_filename(parent ? parent : g_get_tmp_dir(),
+	                                   "power_supply-XXXXXX", NULL);
+	gchar *class_dir = g_mkdtemp(template);
+
+	if (!class_dir)
+	{
+		g_free(template);
+		return NULL;
+	}
+
+	create_supply(class_dir, "battery", battery_attributes, G_N_ELEMENTS(battery_attributes));
+	create_supply(class_dir, "usb", usb_attributes, G_N_ELEMENTS(usb_attributes));
+	create_supply(class_dir, "ac", ac_attributes, G_N_ELEMENTS(ac_attributes));
+	return class_dir;
+}
+
+void bench_power_supply_set(const char *class_dir, const char *supply,
+                            const char *attribute, const char *value)
+{
+	gchar *dir = g_build_filename(class_dir, supply, NULL);
+	gchar *contents = g_strconcat(value, "\n", NULL);
+
+	write_file(dir, attribute, contents);
+	write_uevent(class_dir, supply);
+	g_free(contents);
+	g_free(dir);
+}
+
+void bench_power_supply_remove(gchar *class_dir)
+{
+	const char *supplies[] = { "battery", "usb", "ac" };
+	unsigned int i;
+
+	for (i = 0; i < G_N_ELEMENTS(supplies); i++)
+	{
+		gchar *dir = g_build_filename(class_dir, supplies[i], NULL);
+		GDir *entries = g_dir_open(dir, 0, NULL);
+		const char *name;
+
+		while (entries && (name = g_dir_read_name(entries)))
+		{
+			gchar *path = g_build_filename(dir, name, NULL);
+
+			g_unlink(path);
+			g_free(path);
+		}
+
+		if (entries)
+		{
+			g_dir_close(entries);
+		}
+
+		g_rmdir(dir);
+		g_free(dir);
+	}
+
+	g_rmdir(class_dir);
+	g_free(class_dir);
+}
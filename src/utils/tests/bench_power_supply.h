@@ -0,0 +1,53 @@
+// Copyright (c) 2024 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+
+/**
+ * @file bench_power_supply.h
+ *
+ * @brief Shared parts of the battery and charger query benchmarks: a fake
+ * power_supply class directory and a count of the file syscalls made.
+ */
+
+#ifndef BENCH_POWER_SUPPLY_H_
+#define BENCH_POWER_SUPPLY_H_
+
+#include <glib.h>
+#include <stdint.h>
+
+typedef struct
+{
+	uint64_t open;
+	uint64_t read;
+	uint64_t close;
+	uint64_t syscr;         /* read syscalls as counted by /proc/self/io */
+	gint64 time;            /* monotonic us */
+} bench_counters_t;
+
+/* A power_supply class directory under parent with a battery, usb and ac
+ * supply, each with its attributes and uevent; NULL on failure */
+gchar *bench_power_supply_create(const char *parent);
+void bench_power_supply_remove(gchar *class_dir);
+
+/* Rewrite one attribute of a supply, and its line in the uevent */
+void bench_power_supply_set(const char *class_dir, const char *supply,
+                            const char *attribute, const char *value);
+
+void bench_counters_get(bench_counters_t *counters);
+void bench_counters_report(const char *name, int iterations,
+                           const bench_counters_t *start, const bench_counters_t *end);
+
+#endif /* BENCH_POWER_SUPPLY_H_ */
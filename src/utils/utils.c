@@ -28,8 +28,11 @@
 #include <errno.h>
 #include <stdlib.h>
 #include <fcntl.h>
+#include <limits.h>
+#include <libudev.h>
 #include <nyx/module/nyx_log.h>
 #include "msgid.h"
+#include "utils.h"
 
 /**
  * Returns string in pre-allocated buffer.
@@ -96,69 +99,711 @@ end:
 	return 0;
 }
 
-char *find_power_supply_sysfs_path(const char *device_type)
+#define POWER_SUPPLY_CLASS_DIR "/sys/class/power_supply"
+
+typedef struct
+{
+	gchar *name;
+	gchar *path;
+	gchar *type;
+} power_supply_entry_t;
+
+/* every power supply by name, and the first of each type */
+static GHashTable *power_supplies_by_name = NULL;
+static GHashTable *power_supplies_by_type = NULL;
+static gchar *power_supply_class_dir = NULL;
+
+static void power_supply_entry_free(gpointer data)
+{
+	power_supply_entry_t *entry = (power_supply_entry_t *)data;
+
+	g_free(entry->name);
+	g_free(entry->path);
+	g_free(entry->type);
+	g_free(entry);
+}
+
+static void power_supply_index_remove(const char *name)
+{
+	power_supply_entry_t *entry = g_hash_table_lookup(power_supplies_by_name, name);
+	GHashTableIter iter;
+	gpointer value;
+
+	if (!entry)
+	{
+		return;
+	}
+
+	// Another supply of the same type takes its place
+	if (g_hash_table_lookup(power_supplies_by_type, entry->type) == entry)
+	{
+		g_hash_table_remove(power_supplies_by_type, entry->type);
+		g_hash_table_iter_init(&iter, power_supplies_by_name);
+
+		while (g_hash_table_iter_next(&iter, NULL, &value))
+		{
+			power_supply_entry_t *other = (power_supply_entry_t *)value;
+
+			if (other != entry && strcmp(other->type, entry->type) == 0)
+			{
+				g_hash_table_insert(power_supplies_by_type, other->type, other);
+				break;
+			}
+		}
+	}
+
+	g_hash_table_remove(power_supplies_by_name, name);
+}
+
+static void power_supply_index_add(const char *name, const char *type)
+{
+	power_supply_entry_t *entry;
+
+	if (!name || !type)
+	{
+		return;
+	}
+
+	entry = g_new0(power_supply_entry_t, 1);
+	entry->name = g_strdup(name);
+	entry->path = g_build_filename(power_supply_class_dir, name, NULL);
+	entry->type = g_strdup(type);
+
+	power_supply_index_remove(name);
+	g_hash_table_insert(power_supplies_by_name, entry->name, entry);
+
+	if (!g_hash_table_lookup(power_supplies_by_type, entry->type))
+	{
+		g_hash_table_insert(power_supplies_by_type, entry->type, entry);
+	}
+}
+
+/**
+ * Index every power supply by name and by type, with one pass over
+ * /sys/class/power_supply that reads each type attribute once. Lookups scan
+ * on first use; power_supply_index_update() keeps the index current.
+ */
+void power_supply_index_scan(const char *class_dir)
 {
 	GError *gerror = NULL;
+	const char *name;
+	char type[64];
 	GDir *dir;
-	GDir *subdir;
-	gchar *dir_path = NULL;
-	gchar *full_path = NULL;
-	const char *sub_dir_name;
-	const char *file_name;
-	char file_contents[64];
-	char base_dir[64] = "/sys/class/power_supply/";
 
-	dir = g_dir_open(base_dir, 0, &gerror);
+	power_supply_index_clear();
+	power_supplies_by_name = g_hash_table_new_full(g_str_hash, g_str_equal, NULL,
+	                                               power_supply_entry_free);
+	power_supplies_by_type = g_hash_table_new(g_str_hash, g_str_equal);
+
+	power_supply_class_dir = g_strdup(class_dir ? class_dir : POWER_SUPPLY_CLASS_DIR);
+	dir = g_dir_open(power_supply_class_dir, 0, &gerror);
 
 	if (gerror)
 	{
 		nyx_error(MSGID_NYX_MOD_SYSFS_ERR, 0, "error: %s", gerror->message);
 		g_error_free(gerror);
-		return NULL;
+		return;
 	}
 
-	while ((sub_dir_name = g_dir_read_name(dir)) != 0)
+	while ((name = g_dir_read_name(dir)) != NULL)
 	{
+		gchar *type_path;
+
 		// ignore hidden files
-		if ('.' == sub_dir_name[0])
+		if ('.' == name[0])
 		{
 			continue;
 		}
 
-		dir_path = g_build_filename(base_dir, sub_dir_name, NULL);
+		type_path = g_build_filename(power_supply_class_dir, name, "type", NULL);
 
-		if (g_file_test(dir_path, G_FILE_TEST_IS_DIR))
+		if (FileGetString(type_path, type, sizeof(type)) == 0)
 		{
-			subdir = g_dir_open(dir_path, 0, &gerror);
+			power_supply_index_add(name, type);
+		}
 
-			if (gerror)
-			{
-				nyx_error(MSGID_NYX_MOD_GET_DIR_ERR, 0, "error: %s", gerror->message);
-				g_error_free(gerror);
-				return NULL;
-			}
+		g_free(type_path);
+	}
 
-			while ((file_name = g_dir_read_name(subdir)) != 0)
-			{
-				if (strcmp(file_name, "type") == 0)
-				{
-					full_path = g_build_filename(dir_path, file_name, NULL);
-					FileGetString(full_path, file_contents, 64);
-
-					if (strcmp(file_contents, device_type) == 0)
-					{
-						return dir_path;
-					}
-
-					g_free(full_path);
-					full_path = NULL;
-				}
-			}
+	g_dir_close(dir);
+}
+
+void power_supply_index_clear(void)
+{
+	if (power_supplies_by_type)
+	{
+		g_hash_table_destroy(power_supplies_by_type);
+		power_supplies_by_type = NULL;
+	}
+
+	if (power_supplies_by_name)
+	{
+		g_hash_table_destroy(power_supplies_by_name);
+		power_supplies_by_name = NULL;
+	}
+
+	g_free(power_supply_class_dir);
+	power_supply_class_dir = NULL;
+}
+
+/**
+ * Follow an add or remove uevent of a power supply. Returns true if the
+ * index changed.
+ */
+bool power_supply_index_update(struct udev_device *dev)
+{
+	const char *action, *name, *type;
+
+	if (!dev || !power_supplies_by_name)
+	{
+		return false;
+	}
+
+	action = udev_device_get_action(dev);
+	name = udev_device_get_sysname(dev);
+
+	if (!action || !name)
+	{
+		return false;
+	}
+
+	if (strcmp(action, "add") == 0)
+	{
+		type = udev_device_get_property_value(dev, "POWER_SUPPLY_TYPE");
+
+		if (!type)
+		{
+			type = udev_device_get_sysattr_value(dev, "type");
+		}
+
+		power_supply_index_add(name, type);
+		return type != NULL;
+	}
+
+	if (strcmp(action, "remove") == 0)
+	{
+		bool known = g_hash_table_lookup(power_supplies_by_name, name) != NULL;
+
+		power_supply_index_remove(name);
+		return known;
+	}
+
+	return false;
+}
+
+/**
+ * Sysfs directory of the first power supply of the given type ("Battery",
+ * "USB", "Mains", ...), or NULL. It stays valid until the index changes.
+ */
+const char *power_supply_path_by_type(const char *type)
+{
+	power_supply_entry_t *entry;
+
+	if (!power_supplies_by_type)
+	{
+		power_supply_index_scan(NULL);
+	}
+
+	entry = type ? g_hash_table_lookup(power_supplies_by_type, type) : NULL;
+	return entry ? entry->path : NULL;
+}
+
+const char *power_supply_path_by_name(const char *name)
+{
+	power_supply_entry_t *entry;
+
+	if (!power_supplies_by_name)
+	{
+		power_supply_index_scan(NULL);
+	}
+
+	entry = name ? g_hash_table_lookup(power_supplies_by_name, name) : NULL;
+	return entry ? entry->path : NULL;
+}
+
+/**
+ * Newly allocated copy of power_supply_path_by_type(); free with g_free().
+ */
+char *find_power_supply_sysfs_path(const char *device_type)
+{
+	return g_strdup(power_supply_path_by_type(device_type));
+}
+
+/**
+ * Point attr at dir/name, closing whatever it had open. A NULL dir leaves
+ * the attribute unset, and every read of it fails without a syscall.
+ */
+void sysfs_attr_init(sysfs_attr_t *attr, const char *dir, const char *name)
+{
+	if (!attr)
+	{
+		return;
+	}
+
+	sysfs_attr_close(attr);
+
+	if (dir && name)
+	{
+		snprintf(attr->path, SYSFS_ATTR_PATH_LEN, "%s/%s", dir, name);
+	}
+	else
+	{
+		attr->path[0] = '\0';
+	}
+}
+
+void sysfs_attr_close(sysfs_attr_t *attr)
+{
+	if (attr && attr->fd >= 0)
+	{
+		close(attr->fd);
+		attr->fd = -1;
+	}
+}
+
+static int sysfs_attr_open(sysfs_attr_t *attr)
+{
+	if (attr->fd < 0 && attr->path[0])
+	{
+		attr->fd = open(attr->path, O_RDONLY | O_CLOEXEC);
+	}
+
+	return attr->fd;
+}
+
+bool sysfs_attr_exists(sysfs_attr_t *attr)
+{
+	return attr && sysfs_attr_open(attr) >= 0;
+}
+
+/**
+ * Read the attribute into buf as a string without trailing whitespace.
+ * Returns its length, or -1 on error.
+ */
+int sysfs_attr_read(sysfs_attr_t *attr, char *buf, size_t len)
+{
+	ssize_t n = -1;
+	int tries;
+
+	if (!attr || !buf || len == 0)
+	{
+		return -1;
+	}
+
+	for (tries = 0; tries < 2; tries++)
+	{
+		if (sysfs_attr_open(attr) < 0)
+		{
+			return -1;
+		}
+
+		n = pread(attr->fd, buf, len - 1, 0);
+
+		if (n >= 0 || (errno != ENODEV && errno != ESTALE))
+		{
+			break;
+		}
+
+		// The supply was unplugged; if it came back, the path is a new node
+		sysfs_attr_close(attr);
+	}
+
+	if (n < 0)
+	{
+		return -1;
+	}
+
+	while (n > 0 && (buf[n - 1] == '\n' || buf[n - 1] == ' ' || buf[n - 1] == '\t'))
+	{
+		n--;
+	}
+
+	buf[n] = '\0';
+	return (int)n;
+}
+
+int sysfs_attr_read_int(sysfs_attr_t *attr, int32_t *value)
+{
+	char buf[32];
+	char *endptr;
+	long val;
+
+	if (sysfs_attr_read(attr, buf, sizeof(buf)) <= 0)
+	{
+		return -1;
+	}
+
+	errno = 0;
+	val = strtol(buf, &endptr, 10);
+
+	if (endptr == buf || errno != 0)
+	{
+		return -1;
+	}
+
+	if (value)
+	{
+		*value = (int32_t)val;
+	}
+
+	return 0;
+}
+
+/**
+ * True when attr is an attribute of the power supply named sysname, the name
+ * udev reports for its events.
+ */
+bool sysfs_attr_of_supply(const sysfs_attr_t *attr, const char *sysname)
+{
+	const char *name, *end;
+	size_t len;
+
+	if (!attr || !sysname || !attr->path[0])
+	{
+		return false;
+	}
+
+	end = strrchr(attr->path, '/');
+
+	if (!end || end == attr->path)
+	{
+		return false;
+	}
+
+	for (name = end; name > attr->path && name[-1] != '/'; name--)
+		;
+
+	len = strlen(sysname);
+	return (size_t)(end - name) == len && strncmp(name, sysname, len) == 0;
+}
+
+/**
+ * Coalescing window for power_supply uevents: POWER_SUPPLY_COALESCE_MS unless
+ * NYX_POWER_SUPPLY_COALESCE_MS says otherwise.
+ */
+unsigned int power_supply_coalesce_ms(void)
+{
+	const char *env = getenv("NYX_POWER_SUPPLY_COALESCE_MS");
+	char *endptr;
+	long ms;
+
+	if (!env || !*env)
+	{
+		return POWER_SUPPLY_COALESCE_MS;
+	}
+
+	ms = strtol(env, &endptr, 10);
+
+	if (*endptr != '\0' || ms < 0 || ms > 1000)
+	{
+		nyx_error(MSGID_NYX_MOD_COALESCE_ENV_ERR, 0, "Invalid NYX_POWER_SUPPLY_COALESCE_MS: %s", env);
+		return POWER_SUPPLY_COALESCE_MS;
+	}
+
+	return (unsigned int)ms;
+}
+
+void event_coalescer_init(event_coalescer_t *coalescer, unsigned int window_ms,
+                          bool (*flush)(void *data), void *data)
+{
+	event_coalescer_cancel(coalescer);
+	memset(coalescer, 0, sizeof(event_coalescer_t));
+	coalescer->window_ms = window_ms;
+	coalescer->flush = flush;
+	coalescer->data = data;
+}
+
+static void event_coalescer_flush(event_coalescer_t *coalescer)
+{
+	coalescer->evaluations++;
+
+	if (coalescer->flush && coalescer->flush(coalescer->data))
+	{
+		coalescer->delivered++;
+	}
+}
+
+static gboolean event_coalescer_expired(gpointer data)
+{
+	event_coalescer_t *coalescer = (event_coalescer_t *)data;
+
+	coalescer->timer = 0;
+	event_coalescer_flush(coalescer);
+	return FALSE;
+}
+
+/**
+ * Note one event. With a zero window it is evaluated at once.
+ */
+void event_coalescer_push(event_coalescer_t *coalescer)
+{
+	coalescer->raw_events++;
+
+	if (coalescer->window_ms == 0)
+	{
+		event_coalescer_flush(coalescer);
+	}
+	else if (coalescer->timer == 0)
+	{
+		coalescer->timer = g_timeout_add(coalescer->window_ms, event_coalescer_expired,
+		                                 coalescer);
+	}
+}
+
+bool event_coalescer_pending(const event_coalescer_t *coalescer)
+{
+	return coalescer->timer != 0;
+}
+
+void event_coalescer_cancel(event_coalescer_t *coalescer)
+{
+	if (coalescer && coalescer->timer)
+	{
+		g_source_remove(coalescer->timer);
+		coalescer->timer = 0;
+	}
+}
+
+static const char *power_supply_key_names[POWER_SUPPLY_KEY_COUNT] =
+{
+	[POWER_SUPPLY_PRESENT] = "POWER_SUPPLY_PRESENT",
+	[POWER_SUPPLY_ONLINE] = "POWER_SUPPLY_ONLINE",
+	[POWER_SUPPLY_CAPACITY] = "POWER_SUPPLY_CAPACITY",
+	[POWER_SUPPLY_ENERGY_NOW] = "POWER_SUPPLY_ENERGY_NOW",
+	[POWER_SUPPLY_ENERGY_FULL] = "POWER_SUPPLY_ENERGY_FULL",
+	[POWER_SUPPLY_CHARGE_NOW] = "POWER_SUPPLY_CHARGE_NOW",
+	[POWER_SUPPLY_CHARGE_FULL] = "POWER_SUPPLY_CHARGE_FULL",
+	[POWER_SUPPLY_CHARGE_FULL_DESIGN] = "POWER_SUPPLY_CHARGE_FULL_DESIGN",
+	[POWER_SUPPLY_CHARGE_COUNTER] = "POWER_SUPPLY_CHARGE_COUNTER",
+	[POWER_SUPPLY_TEMP] = "POWER_SUPPLY_TEMP",
+	[POWER_SUPPLY_VOLTAGE_NOW] = "POWER_SUPPLY_VOLTAGE_NOW",
+	[POWER_SUPPLY_VOLTAGE_MAX] = "POWER_SUPPLY_VOLTAGE_MAX",
+	[POWER_SUPPLY_CURRENT_NOW] = "POWER_SUPPLY_CURRENT_NOW",
+	[POWER_SUPPLY_CURRENT_AVG] = "POWER_SUPPLY_CURRENT_AVG",
+	[POWER_SUPPLY_CURRENT_MAX] = "POWER_SUPPLY_CURRENT_MAX",
+	[POWER_SUPPLY_CYCLE_COUNT] = "POWER_SUPPLY_CYCLE_COUNT",
+};
+
+/**
+ * Store one KEY=value pair of a power_supply uevent. Returns false for keys
+ * that are not tracked or values that are not numbers.
+ */
+bool power_supply_uevent_set(power_supply_uevent_t *uevent, const char *key,
+                             const char *value)
+{
+	char *endptr;
+	long val;
+	int i;
+
+	if (!uevent || !key || !value)
+	{
+		return false;
+	}
+
+	if (strcmp(key, "POWER_SUPPLY_STATUS") == 0)
+	{
+		g_strlcpy(uevent->status, value, POWER_SUPPLY_STATUS_LEN);
+		return true;
+	}
+
+	if (strcmp(key, "POWER_SUPPLY_USB_TYPE") == 0)
+	{
+		/* the supported types, with the one in use in brackets */
+		const char *start = strchr(value, '[');
+		size_t len;
+
+		start = start ? start + 1 : value;
+		len = strcspn(start, "] \n");
+
+		if (len >= POWER_SUPPLY_USB_TYPE_LEN)
+		{
+			len = POWER_SUPPLY_USB_TYPE_LEN - 1;
+		}
+
+		memcpy(uevent->usb_type, start, len);
+		uevent->usb_type[len] = '\0';
+		return true;
+	}
+
+	for (i = 0; i < POWER_SUPPLY_KEY_COUNT; i++)
+	{
+		if (strcmp(key, power_supply_key_names[i]) == 0)
+		{
+			break;
 		}
+	}
+
+	if (i == POWER_SUPPLY_KEY_COUNT)
+	{
+		return false;
+	}
 
-		g_free(dir_path);
-		dir_path = NULL;
+	errno = 0;
+	val = strtol(value, &endptr, 10);
+
+	if (endptr == value || errno != 0)
+	{
+		return false;
+	}
+
+	uevent->value[i] = (int32_t)val;
+	uevent->valid |= 1U << i;
+	return true;
+}
+
+bool power_supply_uevent_get(const power_supply_uevent_t *uevent,
+                             power_supply_key_t key, int32_t *value)
+{
+	if (!uevent || key >= POWER_SUPPLY_KEY_COUNT || !(uevent->valid & (1U << key)))
+	{
+		return false;
+	}
+
+	if (value)
+	{
+		*value = uevent->value[key];
+	}
+
+	return true;
+}
+
+/* Store the KEY=value lines of a uevent attribute */
+static void power_supply_parse_uevent(char *buf, power_supply_uevent_t *uevent)
+{
+	char *line, *next;
+
+	for (line = buf; line && *line; line = next)
+	{
+		char *eq;
+
+		next = strchr(line, '\n');
+
+		if (next)
+		{
+			*next++ = '\0';
+		}
+
+		eq = strchr(line, '=');
+
+		if (eq)
+		{
+			*eq = '\0';
+			power_supply_uevent_set(uevent, line, eq + 1);
+		}
+	}
+}
+
+/**
+ * Read every POWER_SUPPLY_* value of a supply with a single read of its
+ * uevent attribute, instead of opening one sysfs file per value.
+ */
+int power_supply_read_uevent(const char *sysfs_path, power_supply_uevent_t *uevent)
+{
+	char path[PATH_MAX];
+	char buf[4096];
+	ssize_t len = 0, n;
+	int fd;
+
+	if (!sysfs_path || !uevent)
+	{
+		return -1;
+	}
+
+	memset(uevent, 0, sizeof(power_supply_uevent_t));
+	snprintf(path, sizeof(path), "%s/uevent", sysfs_path);
+
+	fd = open(path, O_RDONLY | O_CLOEXEC);
+
+	if (fd < 0)
+	{
+		return -1;
+	}
+
+	// sysfs hands out the whole attribute (at most a page) in the first read
+	while (len < (ssize_t)sizeof(buf) - 1 &&
+	        (n = read(fd, buf + len, sizeof(buf) - 1 - len)) > 0)
+	{
+		len += n;
+	}
+
+	close(fd);
+
+	if (len <= 0)
+	{
+		return -1;
+	}
+
+	buf[len] = '\0';
+	power_supply_parse_uevent(buf, uevent);
+
+	return 0;
+}
+
+/**
+ * Same as power_supply_read_uevent() for a uevent attribute kept open, so
+ * that reading it again is a single pread().
+ */
+int power_supply_read_uevent_attr(sysfs_attr_t *attr, power_supply_uevent_t *uevent)
+{
+	char buf[4096];
+
+	if (!uevent)
+	{
+		return -1;
+	}
+
+	memset(uevent, 0, sizeof(power_supply_uevent_t));
+
+	if (sysfs_attr_read(attr, buf, sizeof(buf)) <= 0)
+	{
+		return -1;
+	}
+
+	power_supply_parse_uevent(buf, uevent);
+
+	return 0;
+}
+
+/**
+ * Take the POWER_SUPPLY_* values from the properties of a received uevent,
+ * which carry what the kernel reported without another read of sysfs.
+ * Returns -1 when the event carried none of them.
+ */
+int power_supply_read_device(struct udev_device *dev, power_supply_uevent_t *uevent)
+{
+	const char *value;
+	int i;
+
+	if (!dev || !uevent)
+	{
+		return -1;
+	}
+
+	memset(uevent, 0, sizeof(power_supply_uevent_t));
+
+	for (i = 0; i < POWER_SUPPLY_KEY_COUNT; i++)
+	{
+		value = udev_device_get_property_value(dev, power_supply_key_names[i]);
+
+		if (value)
+		{
+			power_supply_uevent_set(uevent, power_supply_key_names[i], value);
+		}
+	}
+
+	value = udev_device_get_property_value(dev, "POWER_SUPPLY_STATUS");
+
+	if (value)
+	{
+		power_supply_uevent_set(uevent, "POWER_SUPPLY_STATUS", value);
+	}
+
+	value = udev_device_get_property_value(dev, "POWER_SUPPLY_USB_TYPE");
+
+	if (value)
+	{
+		power_supply_uevent_set(uevent, "POWER_SUPPLY_USB_TYPE", value);
 	}
 
-	return NULL;
+	return (uevent->valid || uevent->status[0] || uevent->usb_type[0]) ? 0 : -1;
 }
@@ -21,8 +21,124 @@
 #ifndef UTILS_H_
 #define UTILS_H_
 
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define POWER_SUPPLY_STATUS_LEN 32
+#define POWER_SUPPLY_USB_TYPE_LEN 16
+#define SYSFS_ATTR_PATH_LEN 256
+
+/* Default coalescing window of power_supply uevents, in ms; the
+ * NYX_POWER_SUPPLY_COALESCE_MS environment variable overrides it, 0 disables */
+#define POWER_SUPPLY_COALESCE_MS 30
+
+/* Battery limits: get_battery_ctia_params() of the battery module reports the
+ * temperatures, and the charger module raises NYX_BATTERY_TEMPERATURE_LIMIT
+ * outside the charging range and NYX_BATTERY_CRITICAL_VOLTAGE below the
+ * critical voltage */
+#define BATTERY_CHARGE_MIN_TEMPERATURE_C 0
+#define BATTERY_CHARGE_MAX_TEMPERATURE_C 57
+#define BATTERY_MAX_TEMPERATURE_C 60
+#define BATTERY_CRITICAL_VOLTAGE_MV 3400
+
+/**
+ * A sysfs attribute that stays open between reads; every read is a single
+ * pread() from offset 0. Initialize with SYSFS_ATTR_INIT or sysfs_attr_init().
+ */
+typedef struct
+{
+	char path[SYSFS_ATTR_PATH_LEN];
+	int fd;
+} sysfs_attr_t;
+
+#define SYSFS_ATTR_INIT { {0}, -1 }
+
+/**
+ * Numeric POWER_SUPPLY_* keys of a power_supply uevent, in the units of the
+ * sysfs attribute of the same name.
+ */
+typedef enum
+{
+	POWER_SUPPLY_PRESENT,
+	POWER_SUPPLY_ONLINE,
+	POWER_SUPPLY_CAPACITY,
+	POWER_SUPPLY_ENERGY_NOW,
+	POWER_SUPPLY_ENERGY_FULL,
+	POWER_SUPPLY_CHARGE_NOW,
+	POWER_SUPPLY_CHARGE_FULL,
+	POWER_SUPPLY_CHARGE_FULL_DESIGN,
+	POWER_SUPPLY_CHARGE_COUNTER,
+	POWER_SUPPLY_TEMP,
+	POWER_SUPPLY_VOLTAGE_NOW,
+	POWER_SUPPLY_VOLTAGE_MAX,
+	POWER_SUPPLY_CURRENT_NOW,
+	POWER_SUPPLY_CURRENT_AVG,
+	POWER_SUPPLY_CURRENT_MAX,
+	POWER_SUPPLY_CYCLE_COUNT,
+	POWER_SUPPLY_KEY_COUNT
+} power_supply_key_t;
+
+/**
+ * All POWER_SUPPLY_* values of one supply. A numeric key is only valid when
+ * its (1 << power_supply_key_t) bit is set in valid; status and usb_type are
+ * empty when POWER_SUPPLY_STATUS and POWER_SUPPLY_USB_TYPE were not reported.
+ * usb_type is the type in use, e.g. "DCP" from "Unknown SDP [DCP] CDP".
+ */
+typedef struct
+{
+	uint32_t valid;
+	int32_t value[POWER_SUPPLY_KEY_COUNT];
+	char status[POWER_SUPPLY_STATUS_LEN];
+	char usb_type[POWER_SUPPLY_USB_TYPE_LEN];
+} power_supply_uevent_t;
+
 int FileGetString(const char *path, char *ret_string, size_t maxlen);
 int FileGetDouble(const char *path, double *ret_data);
 char *find_power_supply_sysfs_path(const char *device_type);
 
+void sysfs_attr_init(sysfs_attr_t *attr, const char *dir, const char *name);
+void sysfs_attr_close(sysfs_attr_t *attr);
+bool sysfs_attr_exists(sysfs_attr_t *attr);
+int sysfs_attr_read(sysfs_attr_t *attr, char *buf, size_t len);
+int sysfs_attr_read_int(sysfs_attr_t *attr, int32_t *value);
+
+/**
+ * Merges a burst of events into one evaluation: the first event starts a
+ * window of window_ms, and when it ends flush() runs once for all of them.
+ * flush() returns true if it delivered callbacks.
+ */
+typedef struct
+{
+	unsigned int window_ms;
+	unsigned int timer;
+	bool (*flush)(void *data);
+	void *data;
+	uint32_t raw_events;
+	uint32_t evaluations;
+	uint32_t delivered;
+} event_coalescer_t;
+
+struct udev_device;
+
+unsigned int power_supply_coalesce_ms(void);
+void event_coalescer_init(event_coalescer_t *coalescer, unsigned int window_ms,
+                          bool (*flush)(void *data), void *data);
+void event_coalescer_push(event_coalescer_t *coalescer);
+bool event_coalescer_pending(const event_coalescer_t *coalescer);
+void event_coalescer_cancel(event_coalescer_t *coalescer);
+
+void power_supply_index_scan(const char *class_dir);
+void power_supply_index_clear(void);
+bool power_supply_index_update(struct udev_device *dev);
+const char *power_supply_path_by_type(const char *type);
+const char *power_supply_path_by_name(const char *name);
+
+int power_supply_read_uevent(const char *sysfs_path, power_supply_uevent_t *uevent);
+int power_supply_read_uevent_attr(sysfs_attr_t *attr, power_supply_uevent_t *uevent);
+int power_supply_read_device(struct udev_device *dev, power_supply_uevent_t *uevent);
+bool sysfs_attr_of_supply(const sysfs_attr_t *attr, const char *sysname);
+bool power_supply_uevent_set(power_supply_uevent_t *uevent, const char *key, const char *value);
+bool power_supply_uevent_get(const power_supply_uevent_t *uevent, power_supply_key_t key, int32_t *value);
+
 #endif // UTILS_H_